@@ -0,0 +1,271 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* autotune.c
+ * https://github.com/8891689
+ * 坐標下降：後端 → EC 執行緒數 → 哈希執行緒數 → 批次大小 → 綁核，每一步固定其餘各項取最快的值。
+ * 各項之間的耦合不強，十幾次試驗即可，不做全組合搜索。
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <time.h>
+
+#include "autotune.h"
+
+// 校準從這個 count 開始倍增（FISSION 從這個深度開始逐層加深）
+#define AUTOTUNE_PROBE_COUNT 4096
+#define AUTOTUNE_PROBE_DEPTH 8
+#define AUTOTUNE_LINE_MAX 1024
+
+static const size_t BATCH_SIZES[] = { 256, 1024, 4096 };
+
+typedef struct {
+    PkcContext *ctx;
+    PkcParams params;           // 試驗用的副本，各調優項在試驗前改寫；count 由校準確定後不變
+    double seconds;
+    FILE *log;
+} Trial;
+
+static double seconds_since(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int count_sink(const PkcBatch *batch, void *user) {
+    __atomic_fetch_add((uint64_t *)user, batch->count, __ATOMIC_RELAXED);
+    return 0;
+}
+
+// 用 cfg 跑一次當前的 count，返回記錄數 / 秒，elapsed 返回耗時；引擎出錯返回 -1
+static double trial_once(Trial *t, const AutotuneResult *cfg, double *elapsed) {
+    *elapsed = 0;
+    if (!ec_set_backend(cfg->backend)) return 0;
+    t->params.threads = cfg->threads;
+    t->params.hash_threads = cfg->hash_threads;
+    t->params.batch_size = cfg->batch_size;
+    t->params.pin = cfg->pin;
+    uint64_t records = 0;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (pkc_run(t->ctx, &t->params, count_sink, &records) < 0) return -1;
+    *elapsed = seconds_since(&start);
+    return *elapsed > 0 ? records / *elapsed : 0;
+}
+
+/* 加大 count 直到一次試驗至少 seconds 秒，且工作量加倍時耗時至少增加 60%：
+ * 每個通道的起點要做一次標量乘法，工作量太小時量到的主要是這部分固定開銷。
+ * 之後所有試驗做同樣多的工作。
+ */
+static int trial_calibrate(Trial *t, const AutotuneResult *cfg) {
+    bool fission = t->params.family == PKC_FAMILY_FISSION;
+    t->params.count = fission ? AUTOTUNE_PROBE_DEPTH : AUTOTUNE_PROBE_COUNT;
+    double previous = 0;
+    for (;;) {
+        double elapsed;
+        if (trial_once(t, cfg, &elapsed) < 0) return 0;
+        if (elapsed >= t->seconds && previous > 0 && elapsed >= previous * 1.6) return 1;
+        if (fission ? t->params.count >= PKC_FISSION_MAX_DEPTH : t->params.count > LLONG_MAX / 8) return 1;
+        // 遠不到 seconds 時一次放大 8 倍，不必逐次加倍
+        bool jump = !fission && elapsed * 8 < t->seconds;
+        t->params.count = fission ? t->params.count + 1 : t->params.count * (jump ? 8 : 2);
+        previous = jump ? 0 : elapsed;
+    }
+}
+
+static double trial_run(Trial *t, const AutotuneResult *cfg) {
+    double elapsed;
+    double rate = trial_once(t, cfg, &elapsed);
+    if (rate >= 0 && t->log)
+        fprintf(t->log, "[+] autotune: %-6s t=%-3d hash=%-3d batch=%-5zu pin=%d  %.3f Mrec/s\n",
+                ec_backend_name(cfg->backend), cfg->threads, cfg->hash_threads, cfg->batch_size,
+                (int)cfg->pin, rate / 1e6);
+    return rate;
+}
+
+// 試 candidate，比 best 快則替換；出錯返回 0
+static int trial_try(Trial *t, AutotuneResult *best, const AutotuneResult *candidate) {
+    double rate = trial_run(t, candidate);
+    if (rate < 0) return 0;
+    if (rate > best->rate) {
+        *best = *candidate;
+        best->rate = rate;
+    }
+    return 1;
+}
+
+int autotune_run(PkcContext *ctx, const PkcParams *params, unsigned fixed, double trial_seconds,
+                 FILE *log, AutotuneResult *out) {
+    Trial t = { .ctx = ctx, .seconds = trial_seconds, .log = log };
+    pkc_params_init(&t.params);
+    t.params.family = params->family;
+    t.params.random_mode = params->random_mode;
+    t.params.endo = params->endo;
+    t.params.forms = params->forms;
+    t.params.seed = params->seed;
+    t.params.div_min = params->div_min;
+    t.params.div_max = params->div_max;
+    t.params.div_iterations = params->div_iterations;
+    t.params.mul_inverse = params->mul_inverse;
+    mpz_set(t.params.min_scalar, params->min_scalar);
+    mpz_set(t.params.max_scalar, params->max_scalar);
+    mpz_set(t.params.step, params->step);
+
+    int cpus = topo_cpu_count();
+    if (cpus < 1) cpus = 1;
+    EcBackend current = ec_get_backend();
+    AutotuneResult best = {
+        .backend = current,
+        .threads = (fixed & AUTOTUNE_FIX_THREADS) ? params->threads : cpus,
+        .hash_threads = (fixed & AUTOTUNE_FIX_HASH_THREADS) ? params->hash_threads : 0,
+        .batch_size = params->batch_size ? params->batch_size : 1024,
+        .pin = params->pin,
+        .rate = -1
+    };
+    int ok = trial_calibrate(&t, &best) && trial_try(&t, &best, &best);
+
+    // 後端
+    for (int b = EC_BACKEND_SCALAR; ok && !(fixed & AUTOTUNE_FIX_BACKEND) && b < EC_BACKEND_COUNT; ++b) {
+        AutotuneResult c = best;
+        c.backend = (EcBackend)b;
+        if (c.backend == current || !ec_set_backend(c.backend)) continue;
+        ok = trial_try(&t, &best, &c);
+    }
+    // EC 執行緒：1、2、4 ... 直到 CPU 數，再加 CPU 數本身（含 SMT）
+    for (int n = 1; ok && !(fixed & AUTOTUNE_FIX_THREADS); n *= 2) {
+        if (n > cpus) n = cpus;
+        AutotuneResult c = best;
+        c.threads = n;
+        if (c.threads != best.threads) ok = trial_try(&t, &best, &c);
+        if (n == cpus) break;
+    }
+    // 哈希執行緒：與 EC 執行緒相同、一半、四分之一
+    for (int div = 2; ok && !(fixed & AUTOTUNE_FIX_HASH_THREADS) && div <= 4; div *= 2) {
+        AutotuneResult c = best;
+        c.hash_threads = best.threads / div;
+        if (c.hash_threads < 1 || c.hash_threads == (best.hash_threads ? best.hash_threads : best.threads)) continue;
+        ok = trial_try(&t, &best, &c);
+    }
+    for (size_t i = 0; ok && i < sizeof(BATCH_SIZES) / sizeof(BATCH_SIZES[0]); ++i) {
+        AutotuneResult c = best;
+        c.batch_size = BATCH_SIZES[i];
+        if (c.batch_size != best.batch_size) ok = trial_try(&t, &best, &c);
+    }
+    // 綁核只在 EC 加哈希執行緒放得下時才有意義
+    if (ok && !(fixed & AUTOTUNE_FIX_PIN) && best.threads + (best.hash_threads ? best.hash_threads : best.threads) <= cpus) {
+        AutotuneResult c = best;
+        c.pin = best.pin == TOPO_PIN_NONE ? TOPO_PIN_CORES : TOPO_PIN_NONE;
+        ok = trial_try(&t, &best, &c);
+    }
+
+    pkc_params_clear(&t.params);
+    ec_set_backend(best.backend);
+    if (!ok) return 0;
+    *out = best;
+    return 1;
+}
+
+void autotune_apply(const AutotuneResult *result, unsigned fixed, PkcParams *params) {
+    if (!(fixed & AUTOTUNE_FIX_BACKEND)) ec_set_backend(result->backend);
+    if (!(fixed & AUTOTUNE_FIX_THREADS)) params->threads = result->threads;
+    if (!(fixed & AUTOTUNE_FIX_HASH_THREADS)) params->hash_threads = result->hash_threads;
+    if (!(fixed & AUTOTUNE_FIX_PIN)) params->pin = result->pin;
+    params->batch_size = result->batch_size;
+}
+
+// ---------- 配置文件 ----------
+
+int autotune_profile_path(char *out, size_t len) {
+    const char *path = getenv("PKCLONE_PROFILE");
+    if (path && *path) return snprintf(out, len, "%s", path) < (int)len;
+#ifdef _WIN32
+    const char *dir = getenv("APPDATA");
+    if (!dir) dir = getenv("USERPROFILE");
+    return dir && snprintf(out, len, "%s\\pkclone_profile.txt", dir) < (int)len;
+#else
+    const char *dir = getenv("HOME");
+    return dir && snprintf(out, len, "%s/.pkclone_profile", dir) < (int)len;
+#endif
+}
+
+void autotune_key(const PkcParams *params, char *out, size_t len) {
+    static const char *FAMILIES[] = { "shift", "fission", "grid", "mul" };
+    char model[256];
+    topo_cpu_model(model, sizeof(model));
+    // 鍵中不能有製表符與換行
+    for (char *p = model; *p; ++p) if (*p == '\t' || *p == '\n') *p = ' ';
+    snprintf(out, len, "%s|%d|%s%s%s%s|forms=%u", model, topo_cpu_count(), FAMILIES[params->family],
+             params->random_mode ? ",random" : "", params->endo ? ",endo" : "",
+             params->mul_inverse ? ",inverse" : "", params->forms);
+}
+
+static int parse_line(const char *line, const char *key, AutotuneResult *out) {
+    size_t key_len = strlen(key);
+    if (strncmp(line, key, key_len) != 0 || line[key_len] != '\t') return 0;
+    char backend[16];
+    int pin;
+    AutotuneResult r;
+    if (sscanf(line + key_len + 1, "%15s %d %d %zu %d %lf", backend, &r.threads, &r.hash_threads,
+               &r.batch_size, &pin, &r.rate) != 6) return 0;
+    r.backend = EC_BACKEND_COUNT;
+    for (int b = 0; b < EC_BACKEND_COUNT; ++b)
+        if (strcmp(backend, ec_backend_name((EcBackend)b)) == 0) r.backend = (EcBackend)b;
+    if (r.backend == EC_BACKEND_COUNT || r.threads < 1 || r.hash_threads < 0 || r.batch_size == 0
+        || pin < TOPO_PIN_NONE || pin > TOPO_PIN_NUMA) return 0;
+    r.pin = (TopoPinMode)pin;
+    *out = r;
+    return 1;
+}
+
+int autotune_load(const char *path, const char *key, AutotuneResult *out) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 0;
+    char line[AUTOTUNE_LINE_MAX];
+    int found = 0;
+    // 同一個鍵出現多次時以最後一行為準
+    while (fgets(line, sizeof(line), fp)) found |= parse_line(line, key, out);
+    fclose(fp);
+    return found;
+}
+
+int autotune_store(const char *path, const char *key, const AutotuneResult *result) {
+    // 保留其他鍵的行，寫到臨時文件再改名，中途失敗不會損壞原文件
+    char tmp[4096];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) return 0;
+    FILE *out = fopen(tmp, "w");
+    if (!out) return 0;
+    FILE *in = fopen(path, "r");
+    size_t key_len = strlen(key);
+    char line[AUTOTUNE_LINE_MAX];
+    while (in && fgets(line, sizeof(line), in)) {
+        if (strncmp(line, key, key_len) == 0 && line[key_len] == '\t') continue;
+        fputs(line, out);
+    }
+    if (in) fclose(in);
+    fprintf(out, "%s\t%s %d %d %zu %d %.0f\n", key, ec_backend_name(result->backend), result->threads,
+            result->hash_threads, result->batch_size, (int)result->pin, result->rate);
+    int ok = fclose(out) == 0;
+#ifdef _WIN32
+    remove(path);
+#endif
+    if (ok && rename(tmp, path) != 0) ok = 0;
+    if (!ok) remove(tmp);
+    return ok;
+}
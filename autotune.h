@@ -0,0 +1,77 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* autotune.h — 克隆引擎的啟動調優
+ *
+ * 用實際的 PkcParams（點族、派生形式、endo、隨機模式）跑一連串短試驗，
+ * 逐項選出吞吐量最高的批量加法後端、EC 執行緒數、哈希執行緒數、批次大小與綁核方式。
+ * 結果按 CPU 型號、可用 CPU 數與工作類型記在一個文本配置文件裡，之後的運行直接套用。
+ *
+ * 配置文件每行一條：<鍵>\t<backend> <threads> <hash_threads> <batch_size> <pin> <records/s>
+ */
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "pkclone.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 不參與調優的項（命令行已明確給出）
+enum {
+    AUTOTUNE_FIX_BACKEND      = 1 << 0,
+    AUTOTUNE_FIX_THREADS      = 1 << 1,
+    AUTOTUNE_FIX_HASH_THREADS = 1 << 2,
+    AUTOTUNE_FIX_PIN          = 1 << 3
+};
+
+typedef struct {
+    EcBackend backend;
+    int threads;
+    int hash_threads;
+    size_t batch_size;
+    TopoPinMode pin;
+    double rate;            // 試驗中的記錄數 / 秒
+} AutotuneResult;
+
+// 配置文件路徑：$PKCLONE_PROFILE，否則 $HOME/.pkclone_profile（Windows 為 %APPDATA%）；取不到返回 0
+int autotune_profile_path(char *out, size_t len);
+// 配置文件中的鍵：CPU 型號 | CPU 數 | 點族、派生形式等
+void autotune_key(const PkcParams *params, char *out, size_t len);
+
+// 讀出鍵對應的結果，沒有或格式不對返回 0
+int autotune_load(const char *path, const char *key, AutotuneResult *out);
+// 寫入或替換鍵對應的行，成功返回 1
+int autotune_store(const char *path, const char *key, const AutotuneResult *result);
+
+/* 以 params 為模板試驗，每次約 trial_seconds 秒；fixed 中的項取 params 與當前後端的值。
+ * log 非 NULL 時每次試驗打印一行。成功返回 1，引擎出錯返回 0。
+ */
+int autotune_run(PkcContext *ctx, const PkcParams *params, unsigned fixed, double trial_seconds,
+                 FILE *log, AutotuneResult *out);
+
+// 把結果套用到 params 與全局後端；fixed 中的項保持不變
+void autotune_apply(const AutotuneResult *result, unsigned fixed, PkcParams *params);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AUTOTUNE_H */
@@ -242,5 +242,63 @@ int b58tobin(uint8_t *bin, size_t *binlen, const char *b58, size_t b58len) {
     return 1;
 }
 
+/* Base58 字符 → 數值，非法字符為 -1 */
+static const int8_t BASE58_MAP[128] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1,  0,  1,  2,  3,  4,  5,  6,  7,  8, -1, -1, -1, -1, -1, -1,
+    -1,  9, 10, 11, 12, 13, 14, 15, 16, -1, 17, 18, 19, 20, 21, -1,
+    22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, -1, -1, -1, -1, -1,
+    -1, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, -1, 44, 45, 46,
+    47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, -1, -1, -1, -1, -1
+};
 
+/*
+ * Base58Check 解碼（不分配內存）：大量加載地址時使用。
+ * 逐字符乘 58 累加到棧上的大端緩衝區，high 記錄已用到的最高字節，內層循環只走有效部分。
+ */
+int base58_decode_check_into(const char *b58, size_t b58_len, uint8_t *out, size_t out_cap, size_t *out_len) {
+    uint8_t bin[BASE58_DECODE_MAX];
+    if (b58_len == 0 || b58_len > BASE58_DECODE_MAX) return 0;
+
+    size_t zeros = 0;
+    while (zeros < b58_len && b58[zeros] == '1') zeros++;
+
+    size_t size = b58_len * 733 / 1000 + 1;
+    memset(bin, 0, size);
+    size_t high = size - 1;
+    for (size_t i = zeros; i < b58_len; i++) {
+        unsigned char c = (unsigned char)b58[i];
+        if (c & 0x80 || BASE58_MAP[c] < 0) return 0;
+        uint32_t carry = (uint32_t)BASE58_MAP[c];
+        size_t j = size - 1;
+        for (;; --j) {
+            carry += 58u * bin[j];
+            bin[j] = (uint8_t)carry;
+            carry >>= 8;
+            if (j == 0 || (j <= high && carry == 0)) break;
+        }
+        if (carry != 0) return 0;
+        if (j < high) high = j;
+    }
+
+    size_t skip = 0;
+    while (skip < size && bin[skip] == 0) skip++;
+    size_t total = zeros + (size - skip);
+    if (total < 4 || total - 4 > out_cap) return 0;
 
+    // 前導 '1' 還原為 0x00，與剩餘字節拼成 payload + 校驗和
+    uint8_t full[BASE58_DECODE_MAX];
+    memset(full, 0, zeros);
+    memcpy(full + zeros, bin + skip, size - skip);
+
+    uint8_t hash1[SHA256_BLOCK_SIZE], hash2[SHA256_BLOCK_SIZE];
+    sha256(full, total - 4, hash1);
+    sha256(hash1, SHA256_BLOCK_SIZE, hash2);
+    if (memcmp(hash2, full + total - 4, 4) != 0) return 0;
+
+    memcpy(out, full, total - 4);
+    *out_len = total - 4;
+    return 1;
+}
@@ -40,6 +40,11 @@ char *base58_encode_check(const uint8_t *data, size_t data_len);
 // Base58Check 解碼：解碼後檢查校驗和正確性，若正確返回 payload（去除 4 字節校驗碼），否則返回 NULL
 uint8_t *base58_decode_check(const char *b58, size_t *result_len);
 
+// 無分配的 Base58Check 解碼，b58 不需要以 '\0' 結尾，最長 BASE58_DECODE_MAX 個字符
+// payload 寫入 out（最多 out_cap 字節），長度寫入 out_len；返回 1 表示成功，0 表示非法字符、過長或校驗和不匹配。
+#define BASE58_DECODE_MAX 128
+int base58_decode_check_into(const char *b58, size_t b58_len, uint8_t *out, size_t out_cap, size_t *out_len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,670 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* bsgs.c
+ * https://github.com/8891689
+ * 構建時各執行緒按 j 分段並行寫表，槽用 CAS 佔用；巨步階段所有目標的巨步切成小段，
+ * 各執行緒的通道做完一段就取下一段，目標求出後其餘的段直接跳過。
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <secp256k1.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "bsgs.h"
+#include "ecbatch.h"
+
+static const char *SECP256K1_N_HEX = "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141";
+
+#define BSGS_MIN_SLOTS ((size_t)1 << 10)
+// 每個通道平均分到這麼多段，執行緒之間的負載才均衡
+#define BSGS_SEGMENTS_PER_LANE 8
+// 一段至少這麼多巨步，換段時的一次標量乘法可以忽略
+#define BSGS_MIN_SEGMENT 1024
+
+typedef struct {
+    Bsgs *b;
+    int thread_id;
+    uint64_t first;         // 本執行緒負責 j ∈ [first, last]
+    uint64_t last;
+    int error;
+} BuildThread;
+
+typedef struct {
+    Bsgs *b;
+    int thread_id;
+    uint64_t steps;
+    int done;
+    int error;
+} GiantThread;
+
+struct Bsgs {
+    secp256k1_context *secp;
+    mpz_t n;
+    mpz_t min;
+    mpz_t span;
+    int threads;
+    TopoPinMode pin;
+    uint64_t m;
+    size_t slot_count;
+    NumaTable table;        // 內存中構建或讀入的表
+    void *mapped;           // mmap 的表文件（含頭），此時不用 table
+    size_t mapped_len;
+    double build_seconds;
+    uint64_t giant;         // 每個目標的巨步數
+    AffinePoint giant_step; // −(2m + 1)·G
+
+    secp256k1_pubkey *targets;
+    unsigned char (*target33)[33];
+    unsigned char (*keys)[32];
+    int *solved;
+    int target_count;
+    int target_cap;
+
+    uint64_t segment_len;
+    uint64_t segments_per_target;
+    uint64_t next_segment;
+    int found;
+    int stop;
+    GiantThread *running;
+    int running_count;
+    uint64_t steps_before;
+    double seconds_before;
+    struct timespec started;
+};
+
+static double seconds_since(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// unsigned long 在 Windows 上只有 32 位
+static void mpz_set_u64(mpz_t r, uint64_t v) {
+    mpz_import(r, 1, -1, sizeof(v), 0, 0, &v);
+}
+
+static void put_le64(unsigned char *out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) out[i] = (unsigned char)(v >> (8 * i));
+}
+
+static uint64_t get_le64(const unsigned char *in) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= (uint64_t)in[i] << (8 * i);
+    return v;
+}
+
+static void pubkey_to_point(const secp256k1_context *secp, const secp256k1_pubkey *pk, AffinePoint *out) {
+    unsigned char uncompressed[65];
+    size_t len = sizeof(uncompressed);
+    secp256k1_ec_pubkey_serialize(secp, uncompressed, &len, pk, SECP256K1_EC_UNCOMPRESSED);
+    ec_point_from_uncompressed(out, uncompressed);
+}
+
+static void scalar_bytes(unsigned char *out32, mpz_srcptr v, mpz_srcptr n) {
+    mpz_t r;
+    size_t words = 0;
+    mpz_init(r);
+    mpz_mod(r, v, n);
+    memset(out32, 0, 32);
+    mpz_export(out32 + 32 - mpz_sizeinbase(r, 256), &words, 1, 1, 1, 0, r);
+    if (mpz_sgn(r) == 0) memset(out32, 0, 32);
+    mpz_clear(r);
+}
+
+// v·G；v ≡ 0 (mod n) 時為無窮遠點
+static void scalar_to_point(const Bsgs *b, mpz_srcptr v, AffinePoint *out) {
+    unsigned char bytes[32];
+    secp256k1_pubkey pk;
+    scalar_bytes(bytes, v, b->n);
+    out->infinity = 1;
+    if (secp256k1_ec_pubkey_create(b->secp, &pk, bytes)) pubkey_to_point(b->secp, &pk, out);
+}
+
+static const uint64_t *table_slots(const Bsgs *b) {
+    if (b->mapped) return (const uint64_t *)((const unsigned char *)b->mapped + BSGS_HEADER_SIZE);
+    return (const uint64_t *)numa_table_local(&b->table);
+}
+
+// ---------- 嬰兒步表 ----------
+
+static void table_insert(uint64_t *slots, size_t mask, const AffinePoint *pt, uint64_t j) {
+    uint64_t slot = (pt->x.n[1] & 0xffffffff00000000ULL) | j;
+    size_t idx = (size_t)pt->x.n[0] & mask;
+    for (;;) {
+        uint64_t expected = 0;
+        if (__atomic_compare_exchange_n(&slots[idx], &expected, slot, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) return;
+        idx = (idx + 1) & mask;
+    }
+}
+
+static void *build_thread(void *arg) {
+    BuildThread *t = (BuildThread *)arg;
+    Bsgs *b = t->b;
+    topo_pin_self(topo_place(b->pin, t->thread_id, 0, NULL));
+    if (t->first > t->last) return NULL;
+    uint64_t count = t->last - t->first + 1;
+    size_t lanes = count < BSGS_LANES ? (size_t)count : BSGS_LANES;
+    AffinePoint *pos = malloc(lanes * sizeof(AffinePoint));
+    FieldElement *scratch = malloc(ec_batch_scratch_len(lanes) * sizeof(FieldElement));
+    uint64_t *slots = (uint64_t *)numa_table_primary(&b->table);
+    AffinePoint stride;
+    mpz_t v;
+    mpz_init(v);
+    if (!pos || !scratch) {
+        t->error = 1;
+    } else {
+        // 通道 l 依次處理 j = first + l, first + l + lanes, ...
+        for (size_t l = 0; l < lanes; ++l) {
+            mpz_set_u64(v, t->first + l);
+            scalar_to_point(b, v, &pos[l]);
+        }
+        mpz_set_u64(v, lanes);
+        scalar_to_point(b, v, &stride);
+        for (uint64_t base = t->first; ; base += lanes) {
+            for (size_t l = 0; l < lanes && base + l <= t->last; ++l) table_insert(slots, b->slot_count - 1, &pos[l], base + l);
+            if (t->last - base < lanes) break;
+            ec_add_batch(pos, &stride, 0, lanes, scratch);
+        }
+    }
+    mpz_clear(v);
+    free(pos);
+    free(scratch);
+    return NULL;
+}
+
+static int build_table(Bsgs *b) {
+    if (!numa_table_init(&b->table, b->slot_count * sizeof(uint64_t), b->pin == TOPO_PIN_NUMA)) return 0;
+#ifndef __linux__
+    memset(numa_table_primary(&b->table), 0, b->slot_count * sizeof(uint64_t));
+#endif
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    BuildThread *threads = calloc(b->threads, sizeof(BuildThread));
+    pthread_t *tids = malloc(b->threads * sizeof(pthread_t));
+    int ok = threads && tids;
+    uint64_t per_thread = b->m / b->threads, remainder = b->m % b->threads, next = 1;
+    int started = 0;
+    for (int i = 0; ok && i < b->threads; ++i) {
+        BuildThread *t = &threads[i];
+        t->b = b;
+        t->thread_id = i;
+        t->first = next;
+        t->last = next + per_thread + ((uint64_t)i < remainder ? 1 : 0) - 1;
+        next = t->last + 1;
+        if (pthread_create(&tids[i], NULL, build_thread, t) != 0) {
+            // 建不了執行緒的段在本執行緒構建
+            build_thread(t);
+            continue;
+        }
+        started++;
+    }
+    for (int i = 0; i < started; ++i) pthread_join(tids[i], NULL);
+    for (int i = 0; ok && i < b->threads; ++i) if (threads[i].error) ok = 0;
+    free(threads);
+    free(tids);
+    if (ok) numa_table_commit(&b->table);
+    b->build_seconds = seconds_since(&start);
+    return ok;
+}
+
+static int save_table(const Bsgs *b, const char *path) {
+    FILE *fp = fopen(path, "wb");
+    if (!fp) return 0;
+    unsigned char header[BSGS_HEADER_SIZE] = {0};
+    memcpy(header, BSGS_FILE_MAGIC, sizeof(BSGS_FILE_MAGIC));
+    header[8] = BSGS_FILE_VERSION;
+    put_le64(header + 16, b->m);
+    put_le64(header + 24, b->slot_count);
+    // 槽在內存中為本機字節序，文件為小端；x86 上二者相同，可以直接 mmap
+    int ok = fwrite(header, 1, sizeof(header), fp) == sizeof(header)
+          && fwrite(table_slots(b), sizeof(uint64_t), b->slot_count, fp) == b->slot_count;
+    if (fclose(fp) != 0) ok = 0;
+    return ok;
+}
+
+// 表文件：POSIX 上只讀 mmap；--numa 或非 POSIX 平台讀入 NumaTable
+static int open_table(Bsgs *b, const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return 0;
+    unsigned char header[BSGS_HEADER_SIZE];
+    int ok = fread(header, 1, sizeof(header), fp) == sizeof(header)
+          && memcmp(header, BSGS_FILE_MAGIC, sizeof(BSGS_FILE_MAGIC)) == 0
+          && header[8] == BSGS_FILE_VERSION;
+    if (ok) {
+        b->m = get_le64(header + 16);
+        b->slot_count = get_le64(header + 24);
+        ok = b->m >= 1 && b->m <= BSGS_MAX_BABY && b->slot_count >= BSGS_MIN_SLOTS
+          && (b->slot_count & (b->slot_count - 1)) == 0 && b->m < b->slot_count;
+    }
+    fseek(fp, 0, SEEK_END);
+    long long file_size = ftell(fp);
+    size_t table_size = b->slot_count * sizeof(uint64_t);
+    ok = ok && file_size == (long long)(BSGS_HEADER_SIZE + table_size);
+#ifndef _WIN32
+    if (ok && !(b->pin == TOPO_PIN_NUMA && topo_init() > 1)) {
+        fclose(fp);
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return 0;
+        void *p = mmap(NULL, BSGS_HEADER_SIZE + table_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) return 0;
+        // 查表是隨機訪問，預讀整個文件
+        madvise(p, BSGS_HEADER_SIZE + table_size, MADV_WILLNEED);
+        b->mapped = p;
+        b->mapped_len = BSGS_HEADER_SIZE + table_size;
+        return 1;
+    }
+#endif
+    ok = ok && numa_table_init(&b->table, table_size, b->pin == TOPO_PIN_NUMA);
+    if (ok) {
+        fseek(fp, BSGS_HEADER_SIZE, SEEK_SET);
+        ok = fread(numa_table_primary(&b->table), 1, table_size, fp) == table_size;
+        if (ok) numa_table_commit(&b->table);
+    }
+    fclose(fp);
+    return ok;
+}
+
+// ---------- 巨步 ----------
+
+// 第 i 個巨步的中心 min + m + i·(2m + 1)
+static void giant_center(const Bsgs *b, uint64_t i, mpz_t out) {
+    mpz_t width;
+    mpz_init(width);
+    mpz_set_u64(width, b->m);
+    mpz_mul_2exp(width, width, 1);
+    mpz_add_ui(width, width, 1);
+    mpz_set_u64(out, i);
+    mpz_mul(out, out, width);
+    mpz_add(out, out, b->min);
+    mpz_set_u64(width, b->m);
+    mpz_add(out, out, width);
+    mpz_clear(width);
+}
+
+// 檢查 k = c ± j 是否為目標 t 的私鑰；是則記錄
+static int verify_hit(Bsgs *b, int t, uint64_t i, uint64_t j) {
+    mpz_t c, k;
+    unsigned char key[32], serialized[33];
+    secp256k1_pubkey pk;
+    int hit = 0;
+    mpz_inits(c, k, NULL);
+    giant_center(b, i, c);
+    for (int sign = 0; sign < 2 && !hit; ++sign) {
+        mpz_set_u64(k, j);
+        if (sign) mpz_sub(k, c, k);
+        else mpz_add(k, c, k);
+        scalar_bytes(key, k, b->n);
+        size_t len = sizeof(serialized);
+        if (!secp256k1_ec_pubkey_create(b->secp, &pk, key)) continue;
+        secp256k1_ec_pubkey_serialize(b->secp, serialized, &len, &pk, SECP256K1_EC_COMPRESSED);
+        hit = memcmp(serialized, b->target33[t], 33) == 0;
+    }
+    mpz_clears(c, k, NULL);
+    if (hit && __atomic_exchange_n(&b->solved[t], 1, __ATOMIC_ACQ_REL) == 0) {
+        memcpy(b->keys[t], key, 32);
+        __atomic_fetch_add(&b->found, 1, __ATOMIC_RELAXED);
+        // 全部求出後不用再走
+        if (__atomic_load_n(&b->found, __ATOMIC_RELAXED) == b->target_count) bsgs_stop(b);
+    }
+    return hit;
+}
+
+static void table_lookup(Bsgs *b, const uint64_t *slots, const AffinePoint *pt, int t, uint64_t i) {
+    if (pt->infinity) {
+        verify_hit(b, t, i, 0);
+        return;
+    }
+    size_t mask = b->slot_count - 1, idx = (size_t)pt->x.n[0] & mask;
+    uint64_t fp = pt->x.n[1] & 0xffffffff00000000ULL;
+    for (uint64_t slot; (slot = slots[idx]) != 0; idx = (idx + 1) & mask) {
+        if ((slot & 0xffffffff00000000ULL) == fp && verify_hit(b, t, i, slot & 0xffffffffULL)) return;
+    }
+}
+
+typedef struct {
+    int target;
+    uint64_t i;
+    uint64_t end;
+    int active;
+} GiantLane;
+
+/* 給通道取下一段，並把點放在段首的前一個巨步上：之後的批量加法正好落到段首。
+ * 沒有剩餘的段時返回 0。
+ */
+static int lane_refill(Bsgs *b, GiantLane *lane, AffinePoint *pt, mpz_t c) {
+    uint64_t total = b->segments_per_target * (uint64_t)b->target_count;
+    for (;;) {
+        uint64_t g = __atomic_fetch_add(&b->next_segment, 1, __ATOMIC_RELAXED);
+        if (g >= total || __atomic_load_n(&b->stop, __ATOMIC_RELAXED)) return 0;
+        int t = (int)(g / b->segments_per_target);
+        if (__atomic_load_n(&b->solved[t], __ATOMIC_RELAXED)) continue;
+        lane->target = t;
+        lane->i = g % b->segments_per_target * b->segment_len;
+        lane->end = lane->i + b->segment_len < b->giant ? lane->i + b->segment_len : b->giant;
+        // Q − (c − (2m + 1))·G = Q − c·G + (2m + 1)·G
+        giant_center(b, lane->i, c);
+        mpz_sub_ui(c, c, 1);
+        mpz_t m2;
+        mpz_init(m2);
+        mpz_set_u64(m2, b->m);
+        mpz_submul_ui(c, m2, 2);
+        mpz_clear(m2);
+        mpz_neg(c, c);
+        unsigned char tweak[32];
+        scalar_bytes(tweak, c, b->n);
+        secp256k1_pubkey pk = b->targets[t];
+        pt->infinity = 1;
+        if (secp256k1_ec_pubkey_tweak_add(b->secp, &pk, tweak)) pubkey_to_point(b->secp, &pk, pt);
+        return 1;
+    }
+}
+
+static void *giant_thread(void *arg) {
+    GiantThread *t = (GiantThread *)arg;
+    Bsgs *b = t->b;
+    topo_pin_self(topo_place(b->pin, t->thread_id, 0, NULL));
+    const uint64_t *slots = table_slots(b);
+    AffinePoint *pos = malloc(BSGS_LANES * sizeof(AffinePoint));
+    GiantLane *lanes = calloc(BSGS_LANES, sizeof(GiantLane));
+    FieldElement *scratch = malloc(ec_batch_scratch_len(BSGS_LANES) * sizeof(FieldElement));
+    mpz_t c;
+    mpz_init(c);
+    if (!pos || !lanes || !scratch) {
+        t->error = 1;
+        goto done;
+    }
+    int active = 0;
+    for (int l = 0; l < BSGS_LANES; ++l) {
+        lanes[l].active = lane_refill(b, &lanes[l], &pos[l], c);
+        if (!lanes[l].active) pos[l].infinity = 1;
+        active += lanes[l].active;
+    }
+    while (active > 0 && !__atomic_load_n(&b->stop, __ATOMIC_RELAXED)) {
+        ec_add_batch(pos, &b->giant_step, 0, BSGS_LANES, scratch);
+        uint64_t steps = 0;
+        for (int l = 0; l < BSGS_LANES; ++l) {
+            GiantLane *lane = &lanes[l];
+            if (!lane->active) continue;
+            if (!__atomic_load_n(&b->solved[lane->target], __ATOMIC_RELAXED)) {
+                table_lookup(b, slots, &pos[l], lane->target, lane->i);
+                steps++;
+            }
+            if (++lane->i >= lane->end || __atomic_load_n(&b->solved[lane->target], __ATOMIC_RELAXED)) {
+                lane->active = lane_refill(b, lane, &pos[l], c);
+                active -= !lane->active;
+            }
+        }
+        __atomic_store_n(&t->steps, t->steps + steps, __ATOMIC_RELAXED);
+    }
+
+done:
+    mpz_clear(c);
+    free(pos);
+    free(lanes);
+    free(scratch);
+    __atomic_store_n(&t->done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// ---------- 公共接口 ----------
+
+void bsgs_params_init(BsgsParams *params) {
+    params->threads = 1;
+    params->pin = TOPO_PIN_NONE;
+    params->mem_bytes = (size_t)256 << 20;
+    mpz_inits(params->min_scalar, params->max_scalar, NULL);
+    mpz_set_ui(params->min_scalar, 1);
+    mpz_set_str(params->max_scalar, SECP256K1_N_HEX, 16);
+    mpz_sub_ui(params->max_scalar, params->max_scalar, 1);
+}
+
+void bsgs_params_clear(BsgsParams *params) {
+    mpz_clears(params->min_scalar, params->max_scalar, NULL);
+}
+
+// m 與槽數：內存允許的最大 2 的冪個槽，負載 3/4；區間用不了這麼多時縮小
+static void choose_size(Bsgs *b, size_t mem_bytes) {
+    size_t slots = BSGS_MIN_SLOTS;
+    while (slots * 2 * sizeof(uint64_t) <= mem_bytes && slots * 2 - slots / 2 <= BSGS_MAX_BABY) slots *= 2;
+    uint64_t m = slots - slots / 4;
+    // 2m + 1 >= 區間長度時一個巨步就夠
+    mpz_t need;
+    mpz_init(need);
+    mpz_fdiv_q_2exp(need, b->span, 1);
+    if (mpz_sgn(need) == 0) mpz_set_ui(need, 1);
+    if (mpz_sizeinbase(need, 2) <= 64) {
+        uint64_t need64 = 0;
+        size_t words = 0;
+        mpz_export(&need64, &words, -1, sizeof(need64), 0, 0, need);
+        if (need64 < m) {
+            m = need64;
+            slots = BSGS_MIN_SLOTS;
+            while (slots - slots / 4 < m) slots *= 2;
+        }
+    }
+    mpz_clear(need);
+    b->m = m;
+    b->slot_count = slots;
+}
+
+Bsgs *bsgs_create(const BsgsParams *params, const char *table_path) {
+    if (params->threads <= 0) return NULL;
+    Bsgs *b = calloc(1, sizeof(Bsgs));
+    if (!b) return NULL;
+    mpz_inits(b->n, b->min, b->span, NULL);
+    mpz_set_str(b->n, SECP256K1_N_HEX, 16);
+    b->secp = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
+    if (!b->secp || mpz_cmp_ui(params->min_scalar, 1) < 0 || mpz_cmp(params->min_scalar, params->max_scalar) > 0
+        || mpz_cmp(params->max_scalar, b->n) >= 0) {
+        bsgs_destroy(b);
+        return NULL;
+    }
+    mpz_set(b->min, params->min_scalar);
+    mpz_sub(b->span, params->max_scalar, params->min_scalar);
+    mpz_add_ui(b->span, b->span, 1);
+    b->threads = params->threads;
+    b->pin = params->pin;
+
+    FILE *existing = table_path ? fopen(table_path, "rb") : NULL;
+    int ok;
+    if (existing) {
+        fclose(existing);
+        ok = open_table(b, table_path);
+    } else {
+        choose_size(b, params->mem_bytes);
+        ok = build_table(b) && (!table_path || save_table(b, table_path));
+    }
+
+    // 每個目標 ⌈span / (2m + 1)⌉ 個巨步；超過 2^64 的區間不支持
+    mpz_t width, steps;
+    mpz_inits(width, steps, NULL);
+    mpz_set_u64(width, b->m);
+    mpz_mul_2exp(width, width, 1);
+    mpz_add_ui(width, width, 1);
+    mpz_cdiv_q(steps, b->span, width);
+    ok = ok && mpz_sizeinbase(steps, 2) <= 63;
+    if (ok) {
+        size_t words = 0;
+        mpz_export(&b->giant, &words, -1, sizeof(b->giant), 0, 0, steps);
+        mpz_neg(width, width);
+        scalar_to_point(b, width, &b->giant_step);
+    }
+    mpz_clears(width, steps, NULL);
+    if (!ok) {
+        bsgs_destroy(b);
+        return NULL;
+    }
+    return b;
+}
+
+void bsgs_destroy(Bsgs *b) {
+    if (!b) return;
+#ifndef _WIN32
+    if (b->mapped) munmap(b->mapped, b->mapped_len);
+#endif
+    numa_table_free(&b->table);
+    if (b->secp) secp256k1_context_destroy(b->secp);
+    mpz_clears(b->n, b->min, b->span, NULL);
+    free(b->targets);
+    free(b->target33);
+    free(b->keys);
+    free(b->solved);
+    free(b);
+}
+
+uint64_t bsgs_baby_count(const Bsgs *b) {
+    return b->m;
+}
+
+size_t bsgs_table_bytes(const Bsgs *b) {
+    return b->slot_count * sizeof(uint64_t);
+}
+
+double bsgs_build_seconds(const Bsgs *b) {
+    return b->build_seconds;
+}
+
+int bsgs_table_mapped(const Bsgs *b) {
+    return b->mapped != NULL;
+}
+
+uint64_t bsgs_giant_steps(const Bsgs *b) {
+    return b->giant;
+}
+
+int bsgs_add_target(Bsgs *b, const unsigned char *pubkey, size_t len) {
+    secp256k1_pubkey parsed;
+    if (!secp256k1_ec_pubkey_parse(b->secp, &parsed, pubkey, len)) return -1;
+    if (b->target_count == b->target_cap) {
+        int cap = b->target_cap ? b->target_cap * 2 : 4;
+        secp256k1_pubkey *targets = realloc(b->targets, cap * sizeof(*targets));
+        if (targets) b->targets = targets;
+        unsigned char (*target33)[33] = realloc(b->target33, cap * sizeof(*target33));
+        if (target33) b->target33 = target33;
+        unsigned char (*keys)[32] = realloc(b->keys, cap * sizeof(*keys));
+        if (keys) b->keys = keys;
+        int *solved = realloc(b->solved, cap * sizeof(*solved));
+        if (solved) b->solved = solved;
+        if (!targets || !target33 || !keys || !solved) return -1;
+        b->target_cap = cap;
+    }
+    size_t out_len = 33;
+    b->targets[b->target_count] = parsed;
+    secp256k1_ec_pubkey_serialize(b->secp, b->target33[b->target_count], &out_len, &parsed, SECP256K1_EC_COMPRESSED);
+    b->solved[b->target_count] = 0;
+    return b->target_count++;
+}
+
+int bsgs_target_count(const Bsgs *b) {
+    return b->target_count;
+}
+
+void bsgs_stop(Bsgs *b) {
+    __atomic_store_n(&b->stop, 1, __ATOMIC_RELAXED);
+}
+
+int bsgs_key(const Bsgs *b, int index, unsigned char *out32) {
+    if (index < 0 || index >= b->target_count || !__atomic_load_n(&b->solved[index], __ATOMIC_ACQUIRE)) return 0;
+    memcpy(out32, b->keys[index], 32);
+    return 1;
+}
+
+void bsgs_stats(const Bsgs *b, BsgsStats *stats) {
+    stats->giant_steps = b->steps_before;
+    stats->seconds = b->seconds_before;
+    if (b->running) {
+        for (int i = 0; i < b->running_count; ++i) stats->giant_steps += __atomic_load_n(&b->running[i].steps, __ATOMIC_RELAXED);
+        stats->seconds += seconds_since(&b->started);
+    }
+    unsigned __int128 total = (unsigned __int128)b->giant * (unsigned __int128)b->target_count;
+    stats->giant_total = total > UINT64_MAX ? UINT64_MAX : (uint64_t)total;
+    stats->found = __atomic_load_n(&b->found, __ATOMIC_RELAXED);
+}
+
+int bsgs_run(Bsgs *b, BsgsProgressFn progress, void *user) {
+    if (b->target_count == 0) return 0;
+    // 工作執行緒開始前確定批量加法後端
+    ec_get_backend();
+
+    // 段長：每個通道平均約 BSGS_SEGMENTS_PER_LANE 段
+    unsigned __int128 work = (unsigned __int128)b->giant * (unsigned __int128)b->target_count;
+    unsigned __int128 per = work / ((unsigned __int128)b->threads * BSGS_LANES * BSGS_SEGMENTS_PER_LANE) + 1;
+    b->segment_len = per > b->giant ? b->giant : (uint64_t)per;
+    if (b->segment_len < BSGS_MIN_SEGMENT) b->segment_len = b->giant < BSGS_MIN_SEGMENT ? b->giant : BSGS_MIN_SEGMENT;
+    b->segments_per_target = (b->giant + b->segment_len - 1) / b->segment_len;
+    b->next_segment = 0;
+    b->stop = 0;
+
+    GiantThread *threads = calloc(b->threads, sizeof(GiantThread));
+    pthread_t *tids = malloc(b->threads * sizeof(pthread_t));
+    if (!threads || !tids) {
+        free(threads); free(tids);
+        return -1;
+    }
+    b->running = threads;
+    b->running_count = b->threads;
+    clock_gettime(CLOCK_MONOTONIC, &b->started);
+    int started = 0, error = 0;
+    for (int i = 0; i < b->threads; ++i) {
+        threads[i].b = b;
+        threads[i].thread_id = i;
+        if (pthread_create(&tids[i], NULL, giant_thread, &threads[i]) != 0) {
+            // 已啟動的執行緒會取走所有的段
+            if (started == 0) error = 1;
+            break;
+        }
+        started++;
+    }
+
+    // 本執行緒只負責彙報進度
+    int finished = 0;
+    double last_report = 0;
+    while (finished < started) {
+        struct timespec ts = { 0, 100000000 };
+        nanosleep(&ts, NULL);
+        finished = 0;
+        for (int i = 0; i < started; ++i) finished += __atomic_load_n(&threads[i].done, __ATOMIC_ACQUIRE);
+        double now = seconds_since(&b->started);
+        if (progress && finished < started && now - last_report >= 1) {
+            BsgsStats stats;
+            bsgs_stats(b, &stats);
+            progress(&stats, user);
+            last_report = now;
+        }
+    }
+    for (int i = 0; i < started; ++i) {
+        pthread_join(tids[i], NULL);
+        if (threads[i].error) error = 1;
+        b->steps_before += threads[i].steps;
+    }
+    b->seconds_before += seconds_since(&b->started);
+    b->running = NULL;
+    b->running_count = 0;
+    free(threads);
+    free(tids);
+    return error ? -1 : b->found;
+}
@@ -0,0 +1,117 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* bsgs.h — baby-step giant-step 區間求解，多個目標共用一張嬰兒步表
+ *
+ * 嬰兒步表記錄 j·G (j ∈ [1, m]) 的 x 指紋。只比較 x 時 ±j·G 同時命中，
+ * 所以每個巨步覆蓋 2m + 1 個私鑰：第 i 個巨步的中心 cᵢ = min + m + i·(2m + 1)，
+ * Rᵢ = Q − cᵢ·G，x(Rᵢ) = x(j·G) 時 k = cᵢ ± j，Rᵢ 為無窮遠點時 k = cᵢ。
+ * 相鄰巨步只差常數點 −(2m + 1)·G，所有目標的所有巨步用同一個加數批量推進。
+ * 每次指紋命中都用 k·G = Q 確認，報告的私鑰總是正確的。
+ *
+ * 表為 2 的冪個 8 字節槽：槽 = x 的 32 位指紋 << 32 | j，按 x 的低位開放定址，
+ * 負載不超過 3/4，每個嬰兒步約 11 ~ 21 字節。表只依賴 m，可以保存到文件後直接 mmap，
+ * 用於其他區間與目標。
+ *
+ *   BsgsParams params;
+ *   bsgs_params_init(&params);
+ *   mpz_set(params.min_scalar, min); mpz_set(params.max_scalar, max);
+ *   Bsgs *b = bsgs_create(&params, NULL);
+ *   bsgs_add_target(b, pubkey33, 33);
+ *   bsgs_run(b, NULL, NULL);
+ *   if (bsgs_key(b, 0, key32)) ...
+ *   bsgs_destroy(b);
+ */
+#ifndef BSGS_H
+#define BSGS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <gmp.h>
+
+#include "topology.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 每個執行緒同時推進的巨步通道數（共用一次求逆）
+#define BSGS_LANES 256
+// j 存在槽的低 32 位
+#define BSGS_MAX_BABY 0xffffffffULL
+
+/* 表文件 = 32 字節頭 + 槽數組（每槽 8 字節小端）。
+ * 頭：magic[8] | version | 保留[7] | m (8, 小端) | 槽數 (8, 小端)
+ */
+#define BSGS_FILE_MAGIC "PKBSGS"
+#define BSGS_FILE_VERSION 1
+#define BSGS_HEADER_SIZE 32
+
+typedef struct {
+    int threads;
+    TopoPinMode pin;            // TOPO_PIN_NUMA 時內存中構建的表每個節點一份
+    size_t mem_bytes;           // 表的內存上限，決定 m；區間較小時 m 只取到覆蓋區間所需
+    mpz_t min_scalar;
+    mpz_t max_scalar;
+} BsgsParams;
+
+typedef struct {
+    uint64_t giant_steps;       // 已完成的巨步數，所有目標合計
+    uint64_t giant_total;       // 所有目標的巨步總數
+    int found;
+    double seconds;
+} BsgsStats;
+
+typedef struct Bsgs Bsgs;
+
+// 在調用 bsgs_run 的執行緒中大約每秒調用一次
+typedef void (*BsgsProgressFn)(const BsgsStats *stats, void *user);
+
+// 默認：1 個執行緒，256 MB，區間 [1, n-1]
+void bsgs_params_init(BsgsParams *params);
+void bsgs_params_clear(BsgsParams *params);
+
+/* table_path 為已有的表文件時 mmap 它，m 取文件中的值；文件不存在時按參數構建並保存到 table_path；
+ * table_path 為 NULL 時只在內存中構建。區間非法、文件損壞或內存不足時返回 NULL。
+ */
+Bsgs *bsgs_create(const BsgsParams *params, const char *table_path);
+void bsgs_destroy(Bsgs *b);
+
+uint64_t bsgs_baby_count(const Bsgs *b);
+size_t   bsgs_table_bytes(const Bsgs *b);
+// 構建嬰兒步表的秒數，表從文件映射時為 0
+double   bsgs_build_seconds(const Bsgs *b);
+int      bsgs_table_mapped(const Bsgs *b);
+// 每個目標的巨步數 ⌈(max − min + 1) / (2m + 1)⌉
+uint64_t bsgs_giant_steps(const Bsgs *b);
+
+// 添加目標公鑰（33 或 65 字節），返回其下標，解析失敗返回 -1
+int bsgs_add_target(Bsgs *b, const unsigned char *pubkey, size_t len);
+int bsgs_target_count(const Bsgs *b);
+
+// 對所有目標走完巨步或全部求出後返回求出的個數，內存不足返回 -1
+int  bsgs_run(Bsgs *b, BsgsProgressFn progress, void *user);
+// 可以在信號處理函數中調用
+void bsgs_stop(Bsgs *b);
+// 第 index 個目標的私鑰，32 字節大端；未求出返回 0
+int  bsgs_key(const Bsgs *b, int index, unsigned char *out32);
+void bsgs_stats(const Bsgs *b, BsgsStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BSGS_H */
@@ -0,0 +1,358 @@
+/* clonefile.c
+ * https://github.com/8891689
+ * 克隆器二進制記錄文件：文件頭讀寫，以及並行基數排序 + k 路歸併去重的外部排序。
+ */
+#include "clonefile.h"
+#include "topology.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// 頂層按 key 前兩個字節分桶
+#define TOP_BUCKETS 65536
+// 小於這個數量的區間改用插入排序
+#define INSERTION_THRESHOLD 32
+// 歸併時每個 run 的讀緩衝
+#define MERGE_READ_BUFFER (256 * 1024)
+
+int clone_write_header(FILE *fp, const CloneFileInfo *info) {
+    unsigned char header[CLONE_HEADER_SIZE] = {0};
+    memcpy(header, CLONE_FILE_MAGIC, sizeof(CLONE_FILE_MAGIC));
+    header[8] = CLONE_FILE_VERSION;
+    header[9] = info->key_len;
+    header[10] = info->sorted;
+    return fwrite(header, 1, sizeof(header), fp) == sizeof(header);
+}
+
+int clone_read_header(FILE *fp, CloneFileInfo *info) {
+    unsigned char header[CLONE_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), fp) != sizeof(header)) return 0;
+    if (memcmp(header, CLONE_FILE_MAGIC, sizeof(CLONE_FILE_MAGIC)) != 0) return 0;
+    if (header[8] != CLONE_FILE_VERSION) return 0;
+    info->key_len = header[9];
+    info->sorted = header[10];
+    return info->key_len == 20 || info->key_len == 33 || info->key_len == 65;
+}
+
+// --- run 內排序 ---
+
+static void insertion_sort(unsigned char *a, size_t n, size_t rec, size_t byte) {
+    unsigned char tmp[256];
+    for (size_t i = 1; i < n; ++i) {
+        memcpy(tmp, a + i * rec, rec);
+        size_t j = i;
+        while (j > 0 && memcmp(a + (j - 1) * rec + byte, tmp + byte, rec - byte) > 0) {
+            memcpy(a + j * rec, a + (j - 1) * rec, rec);
+            --j;
+        }
+        memcpy(a + j * rec, tmp, rec);
+    }
+}
+
+// MSD 基數排序：按第 byte 個字節分桶，scratch 與 a 等長，結果留在 a
+static void msd_sort(unsigned char *a, unsigned char *scratch, size_t n, size_t rec, size_t byte) {
+    while (n > 1 && byte < rec) {
+        if (n <= INSERTION_THRESHOLD) { insertion_sort(a, n, rec, byte); return; }
+
+        size_t count[256] = {0};
+        for (size_t i = 0; i < n; ++i) count[a[i * rec + byte]]++;
+
+        // 所有記錄這個字節都相同時直接看下一個字節
+        int only = -1;
+        for (int b = 0; b < 256; ++b) {
+            if (count[b] == n) { only = b; break; }
+            if (count[b]) break;
+        }
+        if (only >= 0) { ++byte; continue; }
+
+        size_t offset[256], pos = 0;
+        for (int b = 0; b < 256; ++b) { offset[b] = pos; pos += count[b]; }
+        for (size_t i = 0; i < n; ++i) {
+            const unsigned char *r = a + i * rec;
+            memcpy(scratch + offset[r[byte]]++ * rec, r, rec);
+        }
+        memcpy(a, scratch, n * rec);
+
+        pos = 0;
+        for (int b = 0; b < 256; ++b) {
+            if (count[b] > 1) msd_sort(a + pos * rec, scratch + pos * rec, count[b], rec, byte + 1);
+            pos += count[b];
+        }
+        return;
+    }
+}
+
+static inline unsigned top_digit(const unsigned char *r) {
+    return ((unsigned)r[0] << 8) | r[1];
+}
+
+typedef struct {
+    const unsigned char *src;
+    unsigned char *dst;
+    unsigned char *scratch;
+    size_t rec;
+    size_t begin, end;          // 本執行緒負責的記錄區間（計數 / 分發階段）
+    size_t *count;              // TOP_BUCKETS 個計數，分發階段改作寫入位置
+    const size_t *bucket_start; // 桶排序階段：各桶在 dst 中的起點（TOP_BUCKETS + 1 個）
+    atomic_size_t *next_bucket;
+} SortTask;
+
+static void *count_task(void *arg) {
+    SortTask *t = arg;
+    memset(t->count, 0, TOP_BUCKETS * sizeof(size_t));
+    for (size_t i = t->begin; i < t->end; ++i) t->count[top_digit(t->src + i * t->rec)]++;
+    return NULL;
+}
+
+static void *scatter_task(void *arg) {
+    SortTask *t = arg;
+    for (size_t i = t->begin; i < t->end; ++i) {
+        const unsigned char *r = t->src + i * t->rec;
+        memcpy(t->dst + t->count[top_digit(r)]++ * t->rec, r, t->rec);
+    }
+    return NULL;
+}
+
+static void *bucket_task(void *arg) {
+    SortTask *t = arg;
+    for (;;) {
+        size_t b = atomic_fetch_add(t->next_bucket, 1);
+        if (b >= TOP_BUCKETS) break;
+        size_t lo = t->bucket_start[b], hi = t->bucket_start[b + 1];
+        if (hi - lo > 1) msd_sort(t->dst + lo * t->rec, t->scratch + lo * t->rec, hi - lo, t->rec, 2);
+    }
+    return NULL;
+}
+
+static void run_tasks(SortTask *tasks, int threads, void *(*fn)(void *)) {
+    pthread_t *ids = malloc(threads * sizeof(pthread_t));
+    int started = 0;
+    if (ids) {
+        for (; started < threads; ++started)
+            if (pthread_create(&ids[started], NULL, fn, &tasks[started]) != 0) break;
+    }
+    // 創建失敗的部分在當前執行緒完成
+    for (int i = started; i < threads; ++i) fn(&tasks[i]);
+    for (int i = 0; i < started; ++i) pthread_join(ids[i], NULL);
+    free(ids);
+}
+
+/* 並行排序一個 run：計數 → 前綴和 → 分發到 scratch → 各桶並行 MSD 排序。
+ * 返回排好序的緩衝區（a 或 scratch 之一）。
+ */
+static unsigned char *sort_run(unsigned char *a, unsigned char *scratch, size_t n, size_t rec, int threads) {
+    if (n < (size_t)threads * 1024) threads = 1;
+    SortTask *tasks = calloc(threads, sizeof(SortTask));
+    size_t *counts = malloc((size_t)threads * TOP_BUCKETS * sizeof(size_t));
+    size_t *bucket_start = malloc((TOP_BUCKETS + 1) * sizeof(size_t));
+    if (!tasks || !counts || !bucket_start) {
+        free(tasks); free(counts); free(bucket_start);
+        msd_sort(a, scratch, n, rec, 0);
+        return a;
+    }
+
+    atomic_size_t next_bucket;
+    atomic_init(&next_bucket, 0);
+    for (int t = 0; t < threads; ++t) {
+        tasks[t].src = a;
+        tasks[t].dst = scratch;
+        tasks[t].scratch = a;
+        tasks[t].rec = rec;
+        tasks[t].begin = n * t / threads;
+        tasks[t].end = n * (t + 1) / threads;
+        tasks[t].count = counts + (size_t)t * TOP_BUCKETS;
+        tasks[t].bucket_start = bucket_start;
+        tasks[t].next_bucket = &next_bucket;
+    }
+    run_tasks(tasks, threads, count_task);
+
+    // 桶 b 中執行緒 t 的寫入起點 = 所有更小桶的總數 + 同桶中前面執行緒的數量
+    size_t pos = 0;
+    for (size_t b = 0; b < TOP_BUCKETS; ++b) {
+        bucket_start[b] = pos;
+        for (int t = 0; t < threads; ++t) {
+            size_t c = tasks[t].count[b];
+            tasks[t].count[b] = pos;
+            pos += c;
+        }
+    }
+    bucket_start[TOP_BUCKETS] = pos;
+    run_tasks(tasks, threads, scatter_task);
+    run_tasks(tasks, threads, bucket_task);
+
+    free(tasks);
+    free(counts);
+    free(bucket_start);
+    return scratch;
+}
+
+// 寫出排好序的記錄，跳過與前一條 key 相同的記錄；last_key 跨調用保持狀態
+static long long write_dedup(FILE *fp, const unsigned char *sorted, size_t n, size_t rec, size_t key_len,
+                             unsigned char *last_key, int *have_last) {
+    long long written = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const unsigned char *r = sorted + i * rec;
+        if (*have_last && memcmp(r, last_key, key_len) == 0) continue;
+        if (fwrite(r, 1, rec, fp) != rec) return -1;
+        memcpy(last_key, r, key_len);
+        *have_last = 1;
+        ++written;
+    }
+    return written;
+}
+
+// --- k 路歸併 ---
+
+typedef struct {
+    FILE *fp;
+    unsigned char *buffer;
+    unsigned char record[256];
+} RunReader;
+
+static int run_next(RunReader *r, size_t rec) {
+    return fread(r->record, 1, rec, r->fp) == rec;
+}
+
+static int run_less(const RunReader *runs, int a, int b, size_t rec) {
+    return memcmp(runs[a].record, runs[b].record, rec) < 0;
+}
+
+static void heap_sift_down(int *heap, int size, int i, const RunReader *runs, size_t rec) {
+    for (;;) {
+        int l = 2 * i + 1, r = l + 1, m = i;
+        if (l < size && run_less(runs, heap[l], heap[m], rec)) m = l;
+        if (r < size && run_less(runs, heap[r], heap[m], rec)) m = r;
+        if (m == i) return;
+        int t = heap[i]; heap[i] = heap[m]; heap[m] = t;
+        i = m;
+    }
+}
+
+static long long merge_runs(FILE *out, char **run_paths, int run_count, size_t rec, size_t key_len) {
+    RunReader *runs = calloc(run_count, sizeof(RunReader));
+    int *heap = malloc(run_count * sizeof(int));
+    long long written = 0;
+    int heap_size = 0;
+    if (!runs || !heap) { free(runs); free(heap); return -1; }
+
+    for (int i = 0; i < run_count; ++i) {
+        runs[i].fp = fopen(run_paths[i], "rb");
+        if (!runs[i].fp) { written = -1; goto done; }
+        runs[i].buffer = malloc(MERGE_READ_BUFFER);
+        if (runs[i].buffer) setvbuf(runs[i].fp, (char *)runs[i].buffer, _IOFBF, MERGE_READ_BUFFER);
+        if (run_next(&runs[i], rec)) heap[heap_size++] = i;
+    }
+    for (int i = heap_size / 2 - 1; i >= 0; --i) heap_sift_down(heap, heap_size, i, runs, rec);
+
+    unsigned char last_key[256];
+    int have_last = 0;
+    while (heap_size > 0) {
+        RunReader *top = &runs[heap[0]];
+        if (!have_last || memcmp(top->record, last_key, key_len) != 0) {
+            if (fwrite(top->record, 1, rec, out) != rec) { written = -1; goto done; }
+            memcpy(last_key, top->record, key_len);
+            have_last = 1;
+            ++written;
+        }
+        if (!run_next(top, rec)) heap[0] = heap[--heap_size];
+        heap_sift_down(heap, heap_size, 0, runs, rec);
+    }
+
+done:
+    for (int i = 0; i < run_count; ++i) {
+        if (runs[i].fp) fclose(runs[i].fp);
+        free(runs[i].buffer);
+    }
+    free(runs);
+    free(heap);
+    return written;
+}
+
+long long clone_sort_file(const char *in_path, const char *out_path, size_t mem_bytes, int threads) {
+    FILE *in = fopen(in_path, "rb");
+    if (!in) { fprintf(stderr, "Error: Could not open '%s'.\n", in_path); return -1; }
+    CloneFileInfo info;
+    if (!clone_read_header(in, &info)) {
+        fprintf(stderr, "Error: '%s' is not a binary clone file.\n", in_path);
+        fclose(in);
+        return -1;
+    }
+    size_t key_len = info.key_len;
+    size_t rec = clone_record_size(key_len);
+    if (threads < 1) threads = 1;
+
+    // 排序需要兩倍 run 大小（數據 + scratch）
+    size_t run_records = mem_bytes / (2 * rec);
+    if (run_records < 4096) run_records = 4096;
+    // 基數分發是隨機寫，run 緩衝放在大頁上減少 TLB 缺失
+    HugeRegion sort_mem;
+    if (!topo_huge_alloc(&sort_mem, 2 * run_records * rec, -1)) {
+        fprintf(stderr, "Error: Could not allocate sort buffers.\n");
+        fclose(in);
+        return -1;
+    }
+    unsigned char *a = sort_mem.ptr;
+    unsigned char *scratch = a + run_records * rec;
+
+    char **run_paths = NULL;
+    int run_count = 0;
+    long long result = -1;
+    unsigned char last_key[256];
+    int have_last = 0;
+    info.sorted = 1;
+
+    for (;;) {
+        size_t n = fread(a, rec, run_records, in);
+        if (n == 0) break;
+        unsigned char *sorted = sort_run(a, scratch, n, rec, threads);
+
+        // 整個輸入放得下一個 run：直接寫結果
+        if (run_count == 0 && n < run_records) {
+            fclose(in);
+            in = NULL;
+            FILE *out = fopen(out_path, "wb");
+            if (!out) { fprintf(stderr, "Error: Could not open output file '%s'.\n", out_path); goto cleanup; }
+            if (clone_write_header(out, &info))
+                result = write_dedup(out, sorted, n, rec, key_len, last_key, &have_last);
+            if (fclose(out) != 0) result = -1;
+            goto cleanup;
+        }
+
+        char **grown = realloc(run_paths, (run_count + 1) * sizeof(char *));
+        if (!grown) goto cleanup;
+        run_paths = grown;
+        size_t path_len = strlen(out_path) + 32;
+        run_paths[run_count] = malloc(path_len);
+        if (!run_paths[run_count]) goto cleanup;
+        snprintf(run_paths[run_count], path_len, "%s.run%d", out_path, run_count);
+        FILE *run_fp = fopen(run_paths[run_count], "wb");
+        ++run_count;
+        if (!run_fp) { fprintf(stderr, "Error: Could not create run file '%s'.\n", run_paths[run_count - 1]); goto cleanup; }
+        have_last = 0;
+        long long w = write_dedup(run_fp, sorted, n, rec, key_len, last_key, &have_last);
+        if (fclose(run_fp) != 0 || w < 0) goto cleanup;
+    }
+    fclose(in);
+    in = NULL;
+    fprintf(stderr, "[+] sort: %d runs spilled, merging\n", run_count);
+
+    // 釋放排序緩衝再歸併，歸併只需要每個 run 的讀緩衝
+    topo_huge_free(&sort_mem);
+    {
+        FILE *out = fopen(out_path, "wb");
+        if (!out) { fprintf(stderr, "Error: Could not open output file '%s'.\n", out_path); goto cleanup; }
+        if (clone_write_header(out, &info)) result = merge_runs(out, run_paths, run_count, rec, key_len);
+        if (fclose(out) != 0) result = -1;
+    }
+
+cleanup:
+    if (in) fclose(in);
+    for (int i = 0; i < run_count; ++i) {
+        remove(run_paths[i]);
+        free(run_paths[i]);
+    }
+    free(run_paths);
+    topo_huge_free(&sort_mem);
+    return result;
+}
@@ -0,0 +1,78 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* clonefile.h — 克隆器二進制記錄文件與外部排序
+ *
+ * 文件 = 16 字節頭 + 定長記錄。記錄佈局：
+ *   key[key_len] | relation (1 字節) | scalar (32 字節大端)
+ * key 為壓縮公鑰 (33)、未壓縮公鑰 (65) 或 hash160 (20)。
+ * 排序後的文件按 key 升序且 key 唯一，可直接對記錄數組做插值 / 二分查找。
+ */
+#ifndef CLONEFILE_H
+#define CLONEFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CLONE_FILE_MAGIC "PKCLONE"
+#define CLONE_FILE_VERSION 1
+#define CLONE_HEADER_SIZE 16
+#define CLONE_SCALAR_SIZE 32
+
+// relation 字節：記錄的點與基準公鑰 P 的關係
+enum {
+    CLONE_REL_PLUS = 0,         // P + kG
+    CLONE_REL_MINUS = 1,        // P - kG
+    CLONE_REL_LAMBDA_PLUS = 2,  // λ(P + kG)
+    CLONE_REL_LAMBDA_MINUS = 3,
+    CLONE_REL_LAMBDA2_PLUS = 4, // λ²(P + kG)
+    CLONE_REL_LAMBDA2_MINUS = 5,
+    CLONE_REL_FISSION = 6,      // (P - jG)·2^-d，scalar 為 2^d + j
+    CLONE_REL_GRID = 7,         // (P - sG)·d^-t，scalar 見 pkclone.h 的 PKC_GRID_*
+    CLONE_REL_MUL = 8,          // k·P
+    CLONE_REL_MUL_INV = 9       // k^-1·P
+};
+
+typedef struct {
+    uint8_t key_len;
+    uint8_t sorted;     // 1：已按 key 排序並去重
+} CloneFileInfo;
+
+static inline size_t clone_record_size(size_t key_len) {
+    return key_len + 1 + CLONE_SCALAR_SIZE;
+}
+
+// 寫 / 讀 16 字節文件頭，成功返回 1
+int clone_write_header(FILE *fp, const CloneFileInfo *info);
+int clone_read_header(FILE *fp, CloneFileInfo *info);
+
+/* 外部排序：讀入 in_path，按 key 升序輸出到 out_path，相同 key 只保留一條
+ * （relation/scalar 最小的一條）。每個 run 最多佔 mem_bytes 內存，用 threads 個執行緒
+ * 做 MSD 基數排序，溢出到 out_path.run<N> 臨時文件後 k 路歸併。
+ * 返回寫出的記錄數，失敗返回 -1。
+ */
+long long clone_sort_file(const char *in_path, const char *out_path, size_t mem_bytes, int threads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLONEFILE_H */
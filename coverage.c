@@ -0,0 +1,242 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* coverage.c
+ * https://github.com/8891689
+ * 區間數很少（合併後通常每個分節只有幾段），所以加入時直接追加、排序、合併。
+ */
+#include "coverage.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#endif
+
+#define COVER_LINE_MAX (COVER_NAME_MAX + 160)
+
+void cover_init(CoverMap *m) {
+    m->sections = NULL;
+    m->count = m->cap = 0;
+}
+
+static void section_clear_ranges(CoverSection *s) {
+    for (size_t i = 0; i < s->count; ++i) mpz_clears(s->ranges[i].lo, s->ranges[i].hi, NULL);
+    s->count = 0;
+}
+
+void cover_free(CoverMap *m) {
+    for (size_t i = 0; i < m->count; ++i) {
+        CoverSection *s = &m->sections[i];
+        section_clear_ranges(s);
+        free(s->ranges);
+        free(s->name);
+        mpz_clear(s->draws);
+    }
+    free(m->sections);
+    cover_init(m);
+}
+
+CoverSection *cover_find(CoverMap *m, const char *name, int create) {
+    for (size_t i = 0; i < m->count; ++i)
+        if (strcmp(m->sections[i].name, name) == 0) return &m->sections[i];
+    if (!create) return NULL;
+    if (m->count == m->cap) {
+        size_t cap = m->cap ? m->cap * 2 : 8;
+        CoverSection *sections = realloc(m->sections, cap * sizeof(CoverSection));
+        if (!sections) return NULL;
+        m->sections = sections;
+        m->cap = cap;
+    }
+    CoverSection *s = &m->sections[m->count];
+    s->name = malloc(strlen(name) + 1);
+    if (!s->name) return NULL;
+    strcpy(s->name, name);
+    s->ranges = NULL;
+    s->count = s->cap = 0;
+    mpz_init(s->draws);
+    m->count++;
+    return s;
+}
+
+static int compare_ranges(const void *a, const void *b) {
+    return mpz_cmp(((const CoverRange *)a)->lo, ((const CoverRange *)b)->lo);
+}
+
+int cover_add(CoverSection *s, mpz_srcptr lo, mpz_srcptr hi) {
+    if (mpz_cmp(lo, hi) > 0) return 1;
+    if (s->count == s->cap) {
+        size_t cap = s->cap ? s->cap * 2 : 4;
+        CoverRange *ranges = realloc(s->ranges, cap * sizeof(CoverRange));
+        if (!ranges) return 0;
+        s->ranges = ranges;
+        s->cap = cap;
+    }
+    mpz_init_set(s->ranges[s->count].lo, lo);
+    mpz_init_set(s->ranges[s->count].hi, hi);
+    s->count++;
+    // mpz_t 只含指向肢的指針，整體移動不影響所有權
+    qsort(s->ranges, s->count, sizeof(CoverRange), compare_ranges);
+    mpz_t next;
+    mpz_init(next);
+    size_t out = 0;
+    for (size_t i = 1; i < s->count; ++i) {
+        CoverRange *cur = &s->ranges[out];
+        mpz_add_ui(next, cur->hi, 1);
+        if (mpz_cmp(s->ranges[i].lo, next) <= 0) {
+            if (mpz_cmp(s->ranges[i].hi, cur->hi) > 0) mpz_set(cur->hi, s->ranges[i].hi);
+            mpz_clears(s->ranges[i].lo, s->ranges[i].hi, NULL);
+        } else {
+            s->ranges[++out] = s->ranges[i];
+        }
+    }
+    s->count = out + 1;
+    mpz_clear(next);
+    return 1;
+}
+
+void cover_add_draws(CoverSection *s, mpz_srcptr n) {
+    mpz_add(s->draws, s->draws, n);
+}
+
+void cover_count(const CoverSection *s, mpz_srcptr from, mpz_srcptr to, mpz_ptr out) {
+    mpz_set_ui(out, 0);
+    if (!s) return;
+    mpz_t lo, hi;
+    mpz_inits(lo, hi, NULL);
+    for (size_t i = 0; i < s->count; ++i) {
+        const CoverRange *r = &s->ranges[i];
+        mpz_set(lo, mpz_cmp(r->lo, from) > 0 ? r->lo : from);
+        mpz_set(hi, mpz_cmp(r->hi, to) < 0 ? r->hi : to);
+        if (mpz_cmp(lo, hi) > 0) continue;
+        mpz_sub(hi, hi, lo);
+        mpz_add_ui(hi, hi, 1);
+        mpz_add(out, out, hi);
+    }
+    mpz_clears(lo, hi, NULL);
+}
+
+int cover_first_gap(const CoverSection *s, mpz_srcptr from, mpz_srcptr to, mpz_ptr gap_lo, mpz_ptr gap_hi) {
+    mpz_set(gap_lo, from);
+    for (size_t i = 0; s && i < s->count && mpz_cmp(gap_lo, to) <= 0; ++i) {
+        const CoverRange *r = &s->ranges[i];
+        if (mpz_cmp(r->hi, gap_lo) < 0) continue;
+        if (mpz_cmp(r->lo, gap_lo) > 0) {
+            mpz_sub_ui(gap_hi, r->lo, 1);
+            if (mpz_cmp(gap_hi, to) > 0) mpz_set(gap_hi, to);
+            return 1;
+        }
+        mpz_add_ui(gap_lo, r->hi, 1);
+    }
+    if (mpz_cmp(gap_lo, to) > 0) return 0;
+    mpz_set(gap_hi, to);
+    return 1;
+}
+
+int cover_intersect(CoverSection *out, const CoverSection *a, const CoverSection *b) {
+    section_clear_ranges(out);
+    mpz_t lo, hi;
+    mpz_inits(lo, hi, NULL);
+    int ok = 1;
+    for (size_t i = 0, j = 0; ok && a && b && i < a->count && j < b->count;) {
+        const CoverRange *x = &a->ranges[i], *y = &b->ranges[j];
+        mpz_set(lo, mpz_cmp(x->lo, y->lo) > 0 ? x->lo : y->lo);
+        mpz_set(hi, mpz_cmp(x->hi, y->hi) < 0 ? x->hi : y->hi);
+        if (mpz_cmp(lo, hi) <= 0) ok = cover_add(out, lo, hi);
+        if (mpz_cmp(x->hi, y->hi) < 0) i++;
+        else j++;
+    }
+    mpz_clears(lo, hi, NULL);
+    return ok;
+}
+
+int cover_load(CoverMap *m, const char *path) {
+    FILE *in = fopen(path, "r");
+    if (!in) return 1;
+    char line[COVER_LINE_MAX];
+    mpz_t lo, hi;
+    mpz_inits(lo, hi, NULL);
+    int ok = 1;
+    while (ok && fgets(line, sizeof(line), in)) {
+        char *name = strtok(line, " \t\r\n");
+        if (!name) continue;
+        char *first = strtok(NULL, " \t\r\n"), *second = strtok(NULL, " \t\r\n");
+        CoverSection *s = NULL;
+        ok = first && second && strlen(name) < COVER_NAME_MAX && mpz_set_str(hi, second, 16) == 0
+             && (s = cover_find(m, name, 1)) != NULL;
+        if (ok && strcmp(first, "draws") == 0) cover_add_draws(s, hi);
+        else if (ok) ok = mpz_set_str(lo, first, 16) == 0 && cover_add(s, lo, hi);
+    }
+    if (ferror(in)) ok = 0;
+    fclose(in);
+    mpz_clears(lo, hi, NULL);
+    return ok;
+}
+
+static int cover_save(const char *path, const CoverMap *m) {
+    char tmp[4096];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) return 0;
+    FILE *out = fopen(tmp, "w");
+    if (!out) return 0;
+    for (size_t i = 0; i < m->count; ++i) {
+        const CoverSection *s = &m->sections[i];
+        for (size_t r = 0; r < s->count; ++r) gmp_fprintf(out, "%s %Zx %Zx\n", s->name, s->ranges[r].lo, s->ranges[r].hi);
+        if (mpz_sgn(s->draws)) gmp_fprintf(out, "%s draws %Zx\n", s->name, s->draws);
+    }
+    int ok = fclose(out) == 0;
+#ifdef _WIN32
+    remove(path);
+#endif
+    if (ok && rename(tmp, path) != 0) ok = 0;
+    if (!ok) remove(tmp);
+    return ok;
+}
+
+int cover_flush(const char *path, CoverMap *m) {
+    int lock_fd = -1;
+#ifndef _WIN32
+    char lock_path[4096];
+    if (snprintf(lock_path, sizeof(lock_path), "%s.lock", path) >= (int)sizeof(lock_path)) return 0;
+    lock_fd = open(lock_path, O_RDWR | O_CREAT, 0600);
+    if (lock_fd < 0 || flock(lock_fd, LOCK_EX) != 0) {
+        if (lock_fd >= 0) close(lock_fd);
+        return 0;
+    }
+#endif
+    CoverMap merged;
+    cover_init(&merged);
+    int ok = cover_load(&merged, path);
+    for (size_t i = 0; ok && i < m->count; ++i) {
+        const CoverSection *s = &m->sections[i];
+        CoverSection *dst = cover_find(&merged, s->name, 1);
+        ok = dst != NULL;
+        for (size_t r = 0; ok && r < s->count; ++r) ok = cover_add(dst, s->ranges[r].lo, s->ranges[r].hi);
+        if (ok) cover_add_draws(dst, s->draws);
+    }
+    if (ok) ok = cover_save(path, &merged);
+    if (ok)
+        for (size_t i = 0; i < m->count; ++i) mpz_set_ui(m->sections[i].draws, 0);
+    cover_free(&merged);
+#ifndef _WIN32
+    close(lock_fd);
+#else
+    (void)lock_fd;
+#endif
+    return ok;
+}
@@ -0,0 +1,86 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* coverage.h — 跨運行的搜索覆蓋記錄
+ *
+ * 每個分節（基準公鑰 + 模式 + 下標空間，見調用方）保存已完成的閉區間集合與隨機抽樣次數。
+ * 區間按下限升序，互不重疊也不相鄰，每次加入後立即合併，所以分段、分機器跑完的
+ * 相鄰區間最終只佔一行。文件是文本，每行一條：
+ *   <分節> <lo> <hi>        十六進制閉區間
+ *   <分節> draws <n>        十六進制，累計抽樣次數
+ * 寫文件時先鎖 <文件>.lock，重新讀入文件、併入本次的記錄，再寫臨時文件後改名，
+ * 所以同時運行的多個進程不會互相覆蓋。
+ */
+#ifndef COVERAGE_H
+#define COVERAGE_H
+
+#include <stddef.h>
+#include <gmp.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 分節名的最大長度（不含空白）
+#define COVER_NAME_MAX 512
+
+typedef struct {
+    mpz_t lo;
+    mpz_t hi;
+} CoverRange;
+
+typedef struct {
+    char *name;
+    CoverRange *ranges;
+    size_t count;
+    size_t cap;
+    mpz_t draws;
+} CoverSection;
+
+typedef struct {
+    CoverSection *sections;
+    size_t count;
+    size_t cap;
+} CoverMap;
+
+void cover_init(CoverMap *m);
+void cover_free(CoverMap *m);
+// 找名為 name 的分節；沒有時 create 非 0 則新建，否則返回 NULL。內存不足返回 NULL
+CoverSection *cover_find(CoverMap *m, const char *name, int create);
+// 加入 [lo, hi] 並與已有區間合併，內存不足返回 0
+int  cover_add(CoverSection *s, mpz_srcptr lo, mpz_srcptr hi);
+void cover_add_draws(CoverSection *s, mpz_srcptr n);
+// [from, to] 內已覆蓋的個數；s 為 NULL 表示沒有記錄
+void cover_count(const CoverSection *s, mpz_srcptr from, mpz_srcptr to, mpz_ptr out);
+/* [from, to] 內第一段未覆蓋的區間 [gap_lo, gap_hi]；全部已覆蓋返回 0。
+ * s 為 NULL 時整段都是空隙。
+ */
+int  cover_first_gap(const CoverSection *s, mpz_srcptr from, mpz_srcptr to, mpz_ptr gap_lo, mpz_ptr gap_hi);
+// out = a ∩ b，out 原有的區間被替換，a 或 b 為 NULL 時結果為空；內存不足返回 0
+int  cover_intersect(CoverSection *out, const CoverSection *a, const CoverSection *b);
+
+// 讀入文件併入 m；文件不存在不算錯誤。讀失敗或格式錯誤返回 0
+int  cover_load(CoverMap *m, const char *path);
+/* 在鎖內把 m 併入文件（重新讀入後合併再整體寫回），失敗返回 0。
+ * 區間可以重複併入；抽樣次數是累加的，成功後 m 中的次數清零，下次只帶新增的部分。
+ */
+int  cover_flush(const char *path, CoverMap *m);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COVERAGE_H */
@@ -0,0 +1,636 @@
+/* ecbatch.c
+ * https://github.com/8891689
+ * secp256k1 仿射點批量加法（Montgomery 批量求逆），供公鑰克隆器做連續步進。
+ */
+#include "ecbatch.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef unsigned __int128 uint128_t;
+
+// p = 2^256 - C
+#define FE_C 0x1000003D1ULL
+
+// β：p 的三次單位根，(β·x, y) = λ·(x, y)
+static const FieldElement FE_BETA = {{
+    0xC1396C28719501EEULL, 0x9CF0497512F58995ULL,
+    0x6E64479EAC3434E9ULL, 0x7AE96A2B657C0710ULL
+}};
+
+void fe_set_bytes(FieldElement *r, const unsigned char *in32) {
+    for (int i = 0; i < 4; ++i) {
+        uint64_t v = 0;
+        for (int j = 0; j < 8; ++j) v = (v << 8) | in32[(3 - i) * 8 + j];
+        r->n[i] = v;
+    }
+    // 輸入 >= p 時歸約一次
+    uint64_t t[4];
+    uint128_t acc = (uint128_t)r->n[0] + FE_C;
+    t[0] = (uint64_t)acc; acc >>= 64;
+    for (int i = 1; i < 4; ++i) { acc += r->n[i]; t[i] = (uint64_t)acc; acc >>= 64; }
+    if (acc) memcpy(r->n, t, sizeof(t));
+}
+
+void fe_get_bytes(unsigned char *out32, const FieldElement *a) {
+    for (int i = 0; i < 4; ++i) {
+        uint64_t v = a->n[i];
+        for (int j = 7; j >= 0; --j) { out32[(3 - i) * 8 + j] = (unsigned char)v; v >>= 8; }
+    }
+}
+
+// r = s + C (mod 2^256)，返回進位；s + C 溢出當且僅當 s >= p
+static inline uint64_t fe_add_c(uint64_t *r, const uint64_t *s, uint64_t c) {
+    uint128_t acc = (uint128_t)s[0] + c;
+    r[0] = (uint64_t)acc; acc >>= 64;
+    acc += s[1]; r[1] = (uint64_t)acc; acc >>= 64;
+    acc += s[2]; r[2] = (uint64_t)acc; acc >>= 64;
+    acc += s[3]; r[3] = (uint64_t)acc; acc >>= 64;
+    return (uint64_t)acc;
+}
+
+void fe_add(FieldElement *r, const FieldElement *a, const FieldElement *b) {
+    uint64_t s[4], t[4];
+    uint128_t acc = 0;
+    for (int i = 0; i < 4; ++i) {
+        acc += (uint128_t)a->n[i] + b->n[i];
+        s[i] = (uint64_t)acc;
+        acc >>= 64;
+    }
+    uint64_t carry = (uint64_t)acc;
+    uint64_t over = fe_add_c(t, s, FE_C);
+    memcpy(r->n, (carry | over) ? t : s, sizeof(s));
+}
+
+void fe_sub(FieldElement *r, const FieldElement *a, const FieldElement *b) {
+    uint64_t d[4];
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; ++i) {
+        uint128_t t = (uint128_t)a->n[i] - b->n[i] - borrow;
+        d[i] = (uint64_t)t;
+        borrow = (uint64_t)(t >> 64) & 1;
+    }
+    if (borrow) {
+        // d + p = d - C (mod 2^256)
+        uint128_t t = (uint128_t)d[0] - FE_C;
+        d[0] = (uint64_t)t;
+        borrow = (uint64_t)(t >> 64) & 1;
+        for (int i = 1; i < 4 && borrow; ++i) {
+            t = (uint128_t)d[i] - borrow;
+            d[i] = (uint64_t)t;
+            borrow = (uint64_t)(t >> 64) & 1;
+        }
+    }
+    memcpy(r->n, d, sizeof(d));
+}
+
+void fe_neg(FieldElement *r, const FieldElement *a) {
+    static const FieldElement zero = {{0, 0, 0, 0}};
+    fe_sub(r, &zero, a);
+}
+
+void fe_mul(FieldElement *r, const FieldElement *a, const FieldElement *b) {
+    uint64_t t[8] = {0};
+    for (int i = 0; i < 4; ++i) {
+        uint64_t carry = 0;
+        for (int j = 0; j < 4; ++j) {
+            uint128_t acc = (uint128_t)a->n[i] * b->n[j] + t[i + j] + carry;
+            t[i + j] = (uint64_t)acc;
+            carry = (uint64_t)(acc >> 64);
+        }
+        t[i + 4] = carry;
+    }
+
+    // 高 256 位乘 C 折回低位：lo + hi * C
+    uint64_t s[4];
+    uint128_t acc = 0;
+    for (int i = 0; i < 4; ++i) {
+        acc += (uint128_t)t[i + 4] * FE_C + t[i];
+        s[i] = (uint64_t)acc;
+        acc >>= 64;
+    }
+    // 剩餘不超過 34 位，再折一次
+    acc = (uint128_t)(uint64_t)acc * FE_C + s[0];
+    s[0] = (uint64_t)acc; acc >>= 64;
+    for (int i = 1; i < 4; ++i) { acc += s[i]; s[i] = (uint64_t)acc; acc >>= 64; }
+    if (acc) fe_add_c(s, s, FE_C);
+
+    uint64_t u[4];
+    if (fe_add_c(u, s, FE_C)) memcpy(s, u, sizeof(u));
+    memcpy(r->n, s, sizeof(s));
+}
+
+void fe_sqr(FieldElement *r, const FieldElement *a) {
+    fe_mul(r, a, a);
+}
+
+static void fe_sqr_n(FieldElement *r, const FieldElement *a, int n) {
+    *r = *a;
+    while (n-- > 0) fe_sqr(r, r);
+}
+
+// 費馬小定理 a^(p-2)，與 libsecp256k1 相同的加法鏈
+void fe_inv(FieldElement *r, const FieldElement *a) {
+    FieldElement x2, x3, x6, x9, x11, x22, x44, x88, x176, x220, x223, t;
+
+    fe_sqr(&x2, a);          fe_mul(&x2, &x2, a);
+    fe_sqr(&x3, &x2);        fe_mul(&x3, &x3, a);
+    fe_sqr_n(&x6, &x3, 3);   fe_mul(&x6, &x6, &x3);
+    fe_sqr_n(&x9, &x6, 3);   fe_mul(&x9, &x9, &x3);
+    fe_sqr_n(&x11, &x9, 2);  fe_mul(&x11, &x11, &x2);
+    fe_sqr_n(&x22, &x11, 11); fe_mul(&x22, &x22, &x11);
+    fe_sqr_n(&x44, &x22, 22); fe_mul(&x44, &x44, &x22);
+    fe_sqr_n(&x88, &x44, 44); fe_mul(&x88, &x88, &x44);
+    fe_sqr_n(&x176, &x88, 88); fe_mul(&x176, &x176, &x88);
+    fe_sqr_n(&x220, &x176, 44); fe_mul(&x220, &x220, &x44);
+    fe_sqr_n(&x223, &x220, 3); fe_mul(&x223, &x223, &x3);
+
+    fe_sqr_n(&t, &x223, 23); fe_mul(&t, &t, &x22);
+    fe_sqr_n(&t, &t, 5);     fe_mul(&t, &t, a);
+    fe_sqr_n(&t, &t, 3);     fe_mul(&t, &t, &x2);
+    fe_sqr_n(&t, &t, 2);     fe_mul(r, &t, a);
+}
+
+int fe_is_zero(const FieldElement *a) {
+    return (a->n[0] | a->n[1] | a->n[2] | a->n[3]) == 0;
+}
+
+int fe_equal(const FieldElement *a, const FieldElement *b) {
+    return memcmp(a->n, b->n, sizeof(a->n)) == 0;
+}
+
+int ec_point_from_uncompressed(AffinePoint *r, const unsigned char *in65) {
+    if (in65[0] != 0x04) return 0;
+    fe_set_bytes(&r->x, in65 + 1);
+    fe_set_bytes(&r->y, in65 + 33);
+    r->infinity = 0;
+    return 1;
+}
+
+int ec_point_from_compressed(AffinePoint *r, const unsigned char *in33) {
+    static const unsigned char sqrt_exponent[32] = {
+        0x3F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xBF, 0xFF, 0xFF, 0x0C
+    };
+    unsigned char bytes[32] = {0};
+    FieldElement rhs, y, check;
+    if (in33[0] != 0x02 && in33[0] != 0x03) return 0;
+    fe_set_bytes(&r->x, in33 + 1);
+    bytes[31] = 7;
+    fe_set_bytes(&y, bytes);
+    fe_sqr(&rhs, &r->x);
+    fe_mul(&rhs, &rhs, &r->x);
+    fe_add(&rhs, &rhs, &y);
+    // p ≡ 3 (mod 4)：平方根為 rhs^((p + 1) / 4)，從高位起平方-乘
+    bytes[31] = 1;
+    fe_set_bytes(&y, bytes);
+    for (int i = 0; i < 256; ++i) {
+        fe_sqr(&y, &y);
+        if (sqrt_exponent[i / 8] >> (7 - i % 8) & 1) fe_mul(&y, &y, &rhs);
+    }
+    fe_sqr(&check, &y);
+    if (!fe_equal(&check, &rhs)) return 0;
+    fe_get_bytes(bytes, &y);
+    if ((bytes[31] & 1) != (in33[0] & 1)) fe_neg(&y, &y);
+    r->y = y;
+    r->infinity = 0;
+    return 1;
+}
+
+size_t ec_point_serialize(unsigned char *out, const AffinePoint *a, int compressed) {
+    if (a->infinity) return 0;
+    if (compressed) {
+        out[0] = 0x02 | (unsigned char)(a->y.n[0] & 1);
+        fe_get_bytes(out + 1, &a->x);
+        return 33;
+    }
+    out[0] = 0x04;
+    fe_get_bytes(out + 1, &a->x);
+    fe_get_bytes(out + 33, &a->y);
+    return 65;
+}
+
+void ec_point_neg(AffinePoint *r, const AffinePoint *a) {
+    r->x = a->x;
+    fe_neg(&r->y, &a->y);
+    r->infinity = a->infinity;
+}
+
+void ec_point_double(AffinePoint *r, const AffinePoint *a) {
+    if (a->infinity || fe_is_zero(&a->y)) { r->infinity = 1; return; }
+    // λ = 3x² / 2y
+    FieldElement num, den, lambda, x3, y3;
+    fe_sqr(&num, &a->x);
+    fe_add(&lambda, &num, &num);
+    fe_add(&num, &lambda, &num);
+    fe_add(&den, &a->y, &a->y);
+    fe_inv(&den, &den);
+    fe_mul(&lambda, &num, &den);
+
+    fe_sqr(&x3, &lambda);
+    fe_sub(&x3, &x3, &a->x);
+    fe_sub(&x3, &x3, &a->x);
+    fe_sub(&y3, &a->x, &x3);
+    fe_mul(&y3, &y3, &lambda);
+    fe_sub(&y3, &y3, &a->y);
+    r->x = x3;
+    r->y = y3;
+    r->infinity = 0;
+}
+
+// 處理批量中不能走通用公式的情況，返回 1 表示已處理
+static int ec_add_special(AffinePoint *r, const AffinePoint *a, const AffinePoint *b) {
+    if (b->infinity) { *r = *a; return 1; }
+    if (a->infinity) { *r = *b; return 1; }
+    if (!fe_equal(&a->x, &b->x)) return 0;
+    if (fe_equal(&a->y, &b->y)) ec_point_double(r, a);
+    else r->infinity = 1;
+    return 1;
+}
+
+void ec_point_add(AffinePoint *r, const AffinePoint *a, const AffinePoint *b) {
+    if (ec_add_special(r, a, b)) return;
+    FieldElement dx, lambda, x3, y3;
+    fe_sub(&dx, &b->x, &a->x);
+    fe_inv(&dx, &dx);
+    fe_sub(&lambda, &b->y, &a->y);
+    fe_mul(&lambda, &lambda, &dx);
+    fe_sqr(&x3, &lambda);
+    fe_sub(&x3, &x3, &a->x);
+    fe_sub(&x3, &x3, &b->x);
+    fe_sub(&y3, &a->x, &x3);
+    fe_mul(&y3, &y3, &lambda);
+    fe_sub(&y3, &y3, &a->y);
+    r->x = x3;
+    r->y = y3;
+    r->infinity = 0;
+}
+
+void ec_point_endo(AffinePoint *r, const AffinePoint *a) {
+    fe_mul(&r->x, &a->x, &FE_BETA);
+    r->y = a->y;
+    r->infinity = a->infinity;
+}
+
+static inline int ec_batch_regular(const AffinePoint *a, const AffinePoint *b) {
+    return !a->infinity && !b->infinity && !fe_equal(&a->x, &b->x);
+}
+
+void ec_add_batch_scalar(AffinePoint *p, const AffinePoint *q, size_t q_stride,
+                         size_t count, FieldElement *scratch) {
+    if (count == 0) return;
+    static const FieldElement one = {{1, 0, 0, 0}};
+
+    // 前綴積：scratch[i] = dx_0 * dx_1 * ... * dx_i（特殊情況以 1 代替）
+    FieldElement acc = one, dx;
+    for (size_t i = 0; i < count; ++i) {
+        const AffinePoint *b = &q[i * q_stride];
+        if (ec_batch_regular(&p[i], b)) {
+            fe_sub(&dx, &b->x, &p[i].x);
+            fe_mul(&acc, &acc, &dx);
+        }
+        scratch[i] = acc;
+    }
+
+    FieldElement inv, inv_i, lambda, x3, y3;
+    fe_inv(&inv, &acc);
+
+    for (size_t i = count; i-- > 0; ) {
+        const AffinePoint *b = &q[i * q_stride];
+        if (!ec_batch_regular(&p[i], b)) {
+            ec_add_special(&p[i], &p[i], b);
+            continue;
+        }
+        fe_sub(&dx, &b->x, &p[i].x);
+        if (i > 0) fe_mul(&inv_i, &inv, &scratch[i - 1]);
+        else inv_i = inv;
+        fe_mul(&inv, &inv, &dx);
+
+        fe_sub(&lambda, &b->y, &p[i].y);
+        fe_mul(&lambda, &lambda, &inv_i);
+        fe_sqr(&x3, &lambda);
+        fe_sub(&x3, &x3, &p[i].x);
+        fe_sub(&x3, &x3, &b->x);
+        fe_sub(&y3, &p[i].x, &x3);
+        fe_mul(&y3, &y3, &lambda);
+        fe_sub(&y3, &y3, &p[i].y);
+        p[i].x = x3;
+        p[i].y = y3;
+    }
+}
+
+/* ---- AVX-512 IFMA 後端 ----
+ * 8 條通道各放一個域元素，5 x 52 位肢按結構數組排列：第 k 肢的 8 個通道在同一個 zmm 內。
+ * vpmadd52luq / vpmadd52huq 直接給出 52x52 位乘積的低 / 高 52 位，累加不會溢出 64 位。
+ * 肢在每次運算後都歸一到 < 2^52（值 < 2^260，不必小於 p），滿足 IFMA 只讀低 52 位的要求；
+ * 只在轉回 4 x 64 時才完全約簡。函數用 target 屬性編譯，運行時檢測 CPU 後才調用。
+ */
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define EC_HAVE_IFMA 1
+#include <immintrin.h>
+
+#define IFMA_FN __attribute__((target("avx512f,avx512ifma")))
+#define M52 0xFFFFFFFFFFFFFULL
+// 2^260 mod p
+#define FE52_R 0x1000003D10ULL
+// 批量中每組 8 個點在 scratch 裡佔的 64 位字數：px, py, qx, qy, 前綴積各 5 肢 x 8 通道
+#define IFMA_GROUP_WORDS (25 * 8)
+
+typedef struct {
+    __m512i n[5];
+} Fe8;
+
+// p 的 5 x 52 肢乘 32：每肢都 >= 2^52，a + 32p - b 逐肢相減不會借位
+static const uint64_t FE52_P32[5] = {
+    0xFFFFEFFFFFC2FULL << 5, M52 << 5, M52 << 5, M52 << 5, 0xFFFFFFFFFFFFULL << 5
+};
+
+static void fe_to_52(uint64_t *l, const FieldElement *a) {
+    l[0] = a->n[0] & M52;
+    l[8] = ((a->n[0] >> 52) | (a->n[1] << 12)) & M52;
+    l[16] = ((a->n[1] >> 40) | (a->n[2] << 24)) & M52;
+    l[24] = ((a->n[2] >> 28) | (a->n[3] << 36)) & M52;
+    l[32] = a->n[3] >> 16;
+}
+
+// 5 x 52（每肢 < 2^52）轉回完全約簡的 4 x 64
+static void fe_from_52(FieldElement *r, const uint64_t *l) {
+    uint64_t s[4], u[4];
+    s[0] = l[0] | (l[8] << 52);
+    s[1] = (l[8] >> 12) | (l[16] << 40);
+    s[2] = (l[16] >> 24) | (l[24] << 28);
+    s[3] = (l[24] >> 36) | (l[32] << 16);
+    // 2^256 以上的 4 位乘 C 折回
+    uint128_t acc = (uint128_t)(l[32] >> 48) * FE_C + s[0];
+    s[0] = (uint64_t)acc; acc >>= 64;
+    for (int i = 1; i < 4; ++i) { acc += s[i]; s[i] = (uint64_t)acc; acc >>= 64; }
+    if (acc) fe_add_c(s, s, FE_C);
+    if (fe_add_c(u, s, FE_C)) memcpy(s, u, sizeof(u));
+    memcpy(r->n, s, sizeof(s));
+}
+
+/* 進位傳播兩遍：第一遍後頂部溢出乘 R 加回 n[0]，第二遍的進位至多為 1，
+ * 且只在 n[1..4] 全滿時發生，此時 n[0] 很小，加 R 不會再溢出。
+ */
+static inline IFMA_FN void fe8_normalize(Fe8 *r) {
+    const __m512i mask = _mm512_set1_epi64(M52);
+    const __m512i R = _mm512_set1_epi64(FE52_R);
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int i = 0; i < 4; ++i) {
+            r->n[i + 1] = _mm512_add_epi64(r->n[i + 1], _mm512_srli_epi64(r->n[i], 52));
+            r->n[i] = _mm512_and_si512(r->n[i], mask);
+        }
+        __m512i c = _mm512_srli_epi64(r->n[4], 52);
+        r->n[4] = _mm512_and_si512(r->n[4], mask);
+        r->n[0] = _mm512_madd52lo_epu64(r->n[0], c, R);
+    }
+}
+
+static inline IFMA_FN void fe8_add(Fe8 *r, const Fe8 *a, const Fe8 *b) {
+    for (int i = 0; i < 5; ++i) r->n[i] = _mm512_add_epi64(a->n[i], b->n[i]);
+    fe8_normalize(r);
+}
+
+static inline IFMA_FN void fe8_sub(Fe8 *r, const Fe8 *a, const Fe8 *b) {
+    for (int i = 0; i < 5; ++i)
+        r->n[i] = _mm512_sub_epi64(_mm512_add_epi64(a->n[i], _mm512_set1_epi64(FE52_P32[i])), b->n[i]);
+    fe8_normalize(r);
+}
+
+static inline IFMA_FN void fe8_mul(Fe8 *r, const Fe8 *a, const Fe8 *b) {
+    const __m512i mask = _mm512_set1_epi64(M52);
+    const __m512i R = _mm512_set1_epi64(FE52_R);
+    __m512i t[10];
+    for (int k = 0; k < 10; ++k) t[k] = _mm512_setzero_si512();
+    // 每列至多 5 個低半 + 5 個高半，< 2^56
+    for (int i = 0; i < 5; ++i) {
+        for (int j = 0; j < 5; ++j) {
+            t[i + j] = _mm512_madd52lo_epu64(t[i + j], a->n[i], b->n[j]);
+            t[i + j + 1] = _mm512_madd52hi_epu64(t[i + j + 1], a->n[i], b->n[j]);
+        }
+    }
+    // 高 5 列歸一到 52 位後才能再作為 IFMA 輸入；乘積 < 2^520，t[9] 不會溢出
+    for (int k = 4; k < 9; ++k) {
+        t[k + 1] = _mm512_add_epi64(t[k + 1], _mm512_srli_epi64(t[k], 52));
+        t[k] = _mm512_and_si512(t[k], mask);
+    }
+    // 2^(52(k+5)) ≡ 2^(52k)·R
+    __m512i top = _mm512_setzero_si512();
+    for (int k = 0; k < 5; ++k) {
+        t[k] = _mm512_madd52lo_epu64(t[k], t[k + 5], R);
+        if (k < 4) t[k + 1] = _mm512_madd52hi_epu64(t[k + 1], t[k + 5], R);
+        else top = _mm512_madd52hi_epu64(top, t[k + 5], R);
+    }
+    for (int k = 0; k < 4; ++k) {
+        t[k + 1] = _mm512_add_epi64(t[k + 1], _mm512_srli_epi64(t[k], 52));
+        t[k] = _mm512_and_si512(t[k], mask);
+    }
+    top = _mm512_add_epi64(top, _mm512_srli_epi64(t[4], 52));
+    t[4] = _mm512_and_si512(t[4], mask);
+    t[0] = _mm512_madd52lo_epu64(t[0], top, R);
+    t[1] = _mm512_madd52hi_epu64(t[1], top, R);
+
+    for (int k = 0; k < 5; ++k) r->n[k] = t[k];
+    fe8_normalize(r);
+}
+
+static inline IFMA_FN void fe8_sqr_n(Fe8 *r, const Fe8 *a, int n) {
+    *r = *a;
+    while (n-- > 0) fe8_mul(r, r, r);
+}
+
+// 與 fe_inv 相同的加法鏈，8 個通道同時求逆
+static IFMA_FN void fe8_inv(Fe8 *r, const Fe8 *a) {
+    Fe8 x2, x3, x6, x9, x11, x22, x44, x88, x176, x220, x223, t;
+    fe8_mul(&x2, a, a);           fe8_mul(&x2, &x2, a);
+    fe8_mul(&x3, &x2, &x2);       fe8_mul(&x3, &x3, a);
+    fe8_sqr_n(&x6, &x3, 3);       fe8_mul(&x6, &x6, &x3);
+    fe8_sqr_n(&x9, &x6, 3);       fe8_mul(&x9, &x9, &x3);
+    fe8_sqr_n(&x11, &x9, 2);      fe8_mul(&x11, &x11, &x2);
+    fe8_sqr_n(&x22, &x11, 11);    fe8_mul(&x22, &x22, &x11);
+    fe8_sqr_n(&x44, &x22, 22);    fe8_mul(&x44, &x44, &x22);
+    fe8_sqr_n(&x88, &x44, 44);    fe8_mul(&x88, &x88, &x44);
+    fe8_sqr_n(&x176, &x88, 88);   fe8_mul(&x176, &x176, &x88);
+    fe8_sqr_n(&x220, &x176, 44);  fe8_mul(&x220, &x220, &x44);
+    fe8_sqr_n(&x223, &x220, 3);   fe8_mul(&x223, &x223, &x3);
+
+    fe8_sqr_n(&t, &x223, 23);     fe8_mul(&t, &t, &x22);
+    fe8_sqr_n(&t, &t, 5);         fe8_mul(&t, &t, a);
+    fe8_sqr_n(&t, &t, 3);         fe8_mul(&t, &t, &x2);
+    fe8_sqr_n(&t, &t, 2);         fe8_mul(r, &t, a);
+}
+
+static inline IFMA_FN void fe8_load(Fe8 *r, const uint64_t *soa) {
+    for (int k = 0; k < 5; ++k) r->n[k] = _mm512_loadu_si512((const void *)(soa + k * 8));
+}
+
+static inline IFMA_FN void fe8_store(uint64_t *soa, const Fe8 *a) {
+    for (int k = 0; k < 5; ++k) _mm512_storeu_si512((void *)(soa + k * 8), a->n[k]);
+}
+
+/* 與 ec_add_batch_scalar 相同的算法，點 i 放在第 i/8 組的第 i%8 通道，8 條前綴積鏈並行，
+ * 最後一次 fe8_inv 同時求出 8 個逆元。特殊情況的通道用 dx = 1 佔位，回寫時交給標量代碼。
+ */
+static IFMA_FN void ec_add_batch_ifma(AffinePoint *p, const AffinePoint *q, size_t q_stride,
+                                      size_t count, FieldElement *scratch) {
+    uint64_t *soa = (uint64_t *)scratch;
+    size_t groups = (count + 7) / 8;
+    Fe8 acc, px, py, qx, qy, dx;
+    memset(&acc, 0, sizeof(acc));
+    acc.n[0] = _mm512_set1_epi64(1);
+
+    for (size_t g = 0; g < groups; ++g) {
+        uint64_t *group = soa + g * IFMA_GROUP_WORDS;
+        for (size_t l = 0; l < 8; ++l) {
+            size_t i = g * 8 + l;
+            if (i < count && ec_batch_regular(&p[i], &q[i * q_stride])) {
+                const AffinePoint *b = &q[i * q_stride];
+                fe_to_52(group + l, &p[i].x);
+                fe_to_52(group + 40 + l, &p[i].y);
+                fe_to_52(group + 80 + l, &b->x);
+                fe_to_52(group + 120 + l, &b->y);
+            } else {
+                for (int k = 0; k < 5; ++k) {
+                    group[k * 8 + l] = group[40 + k * 8 + l] = group[120 + k * 8 + l] = 0;
+                    group[80 + k * 8 + l] = k == 0;
+                }
+            }
+        }
+        fe8_load(&px, group);
+        fe8_load(&qx, group + 80);
+        fe8_sub(&dx, &qx, &px);
+        fe8_mul(&acc, &acc, &dx);
+        fe8_store(group + 160, &acc);
+    }
+
+    Fe8 inv, inv_i, lambda, x3, y3, t;
+    fe8_inv(&inv, &acc);
+
+    for (size_t g = groups; g-- > 0; ) {
+        uint64_t *group = soa + g * IFMA_GROUP_WORDS;
+        fe8_load(&px, group);
+        fe8_load(&py, group + 40);
+        fe8_load(&qx, group + 80);
+        fe8_load(&qy, group + 120);
+        fe8_sub(&dx, &qx, &px);
+        if (g > 0) {
+            fe8_load(&t, group - IFMA_GROUP_WORDS + 160);
+            fe8_mul(&inv_i, &inv, &t);
+        } else {
+            inv_i = inv;
+        }
+        fe8_mul(&inv, &inv, &dx);
+
+        fe8_sub(&lambda, &qy, &py);
+        fe8_mul(&lambda, &lambda, &inv_i);
+        fe8_mul(&x3, &lambda, &lambda);
+        fe8_sub(&x3, &x3, &px);
+        fe8_sub(&x3, &x3, &qx);
+        fe8_sub(&y3, &px, &x3);
+        fe8_mul(&y3, &y3, &lambda);
+        fe8_sub(&y3, &y3, &py);
+        fe8_store(group, &x3);
+        fe8_store(group + 40, &y3);
+
+        for (size_t l = 0; l < 8; ++l) {
+            size_t i = g * 8 + l;
+            if (i >= count) continue;
+            const AffinePoint *b = &q[i * q_stride];
+            if (!ec_batch_regular(&p[i], b)) {
+                ec_add_special(&p[i], &p[i], b);
+                continue;
+            }
+            fe_from_52(&p[i].x, group + l);
+            fe_from_52(&p[i].y, group + 40 + l);
+        }
+    }
+}
+#endif
+
+// 少於兩組時向量化不划算
+#define IFMA_MIN_COUNT 16
+
+static EcBackend ec_backend = EC_BACKEND_AUTO;
+
+static int ec_backend_supported(EcBackend backend) {
+    if (backend == EC_BACKEND_SCALAR) return 1;
+#ifdef EC_HAVE_IFMA
+    if (backend == EC_BACKEND_IFMA) {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512ifma");
+    }
+#endif
+    return 0;
+}
+
+int ec_set_backend(EcBackend backend) {
+    if (backend == EC_BACKEND_AUTO)
+        backend = ec_backend_supported(EC_BACKEND_IFMA) ? EC_BACKEND_IFMA : EC_BACKEND_SCALAR;
+    if (!ec_backend_supported(backend)) return 0;
+    ec_backend = backend;
+    return 1;
+}
+
+EcBackend ec_get_backend(void) {
+    if (ec_backend == EC_BACKEND_AUTO) ec_set_backend(EC_BACKEND_AUTO);
+    return ec_backend;
+}
+
+const char *ec_backend_name(EcBackend backend) {
+    switch (backend) {
+        case EC_BACKEND_SCALAR: return "scalar";
+        case EC_BACKEND_IFMA: return "ifma";
+        default: return "auto";
+    }
+}
+
+size_t ec_batch_scratch_len(size_t count) {
+    // 每組 IFMA_GROUP_WORDS 個 64 位字 = IFMA_GROUP_WORDS / 4 個 FieldElement
+    size_t ifma = (count + 7) / 8 * (25 * 8 / 4);
+    return ifma > count ? ifma : count;
+}
+
+void ec_add_batch(AffinePoint *p, const AffinePoint *q, size_t q_stride,
+                  size_t count, FieldElement *scratch) {
+#ifdef EC_HAVE_IFMA
+    if (count >= IFMA_MIN_COUNT && ec_get_backend() == EC_BACKEND_IFMA) {
+        ec_add_batch_ifma(p, q, q_stride, count, scratch);
+        return;
+    }
+#endif
+    ec_add_batch_scalar(p, q, q_stride, count, scratch);
+}
+
+int ec_window_init(EcWindowTable *t, const AffinePoint *p) {
+    t->points = malloc(EC_WINDOW_TABLE_LEN * sizeof(AffinePoint));
+    if (!t->points) return 0;
+    AffinePoint base = *p;
+    for (int w = 0; w < EC_WINDOW_COUNT; ++w) {
+        AffinePoint *row = t->points + w * 15;
+        row[0] = base;
+        for (int j = 1; j < 15; ++j) ec_point_add(&row[j], &row[j - 1], &base);
+        // 下一窗口的基點 16·base = 15·base + base
+        ec_point_add(&base, &row[14], &base);
+    }
+    return 1;
+}
+
+void ec_window_free(EcWindowTable *t) {
+    free(t->points);
+    t->points = NULL;
+}
+
+void ec_window_mul_batch(const EcWindowTable *t, const unsigned char *scalars, AffinePoint *r,
+                         size_t count, AffinePoint *addends, FieldElement *scratch) {
+    for (size_t i = 0; i < count; ++i) r[i].infinity = 1;
+    for (int w = 0; w < EC_WINDOW_COUNT; ++w) {
+        // 第 w 個窗口是從低位數起的第 w 個 4 位組
+        int shift = (w & 1) * EC_WINDOW_BITS;
+        int byte = 31 - w / 2;
+        for (size_t i = 0; i < count; ++i) {
+            int digit = (scalars[i * 32 + byte] >> shift) & 15;
+            if (digit) addends[i] = t->points[w * 15 + digit - 1];
+            else addends[i].infinity = 1;
+        }
+        ec_add_batch(r, addends, 1, count, scratch);
+    }
+}
@@ -0,0 +1,116 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* ecbatch.h — secp256k1 仿射座標批量點加法
+ * 私鑰相關的運算仍交給 libsecp256k1，這裡只負責「已知點 + 常數點」的大量步進。
+ */
+#ifndef ECBATCH_H
+#define ECBATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 域元素：4 x 64 位小端肢，始終保持在 [0, p) 內
+typedef struct {
+    uint64_t n[4];
+} FieldElement;
+
+// 仿射座標點；infinity 非 0 表示無窮遠點（x, y 無意義）
+typedef struct {
+    FieldElement x;
+    FieldElement y;
+    int infinity;
+} AffinePoint;
+
+void fe_set_bytes(FieldElement *r, const unsigned char *in32);   // 32 字節大端
+void fe_get_bytes(unsigned char *out32, const FieldElement *a);
+void fe_add(FieldElement *r, const FieldElement *a, const FieldElement *b);
+void fe_sub(FieldElement *r, const FieldElement *a, const FieldElement *b);
+void fe_neg(FieldElement *r, const FieldElement *a);
+void fe_mul(FieldElement *r, const FieldElement *a, const FieldElement *b);
+void fe_sqr(FieldElement *r, const FieldElement *a);
+void fe_inv(FieldElement *r, const FieldElement *a);              // a 不可為 0
+int  fe_is_zero(const FieldElement *a);
+int  fe_equal(const FieldElement *a, const FieldElement *b);
+
+// 從 65 字節未壓縮公鑰 (04 || x || y) 載入，成功返回 1
+int  ec_point_from_uncompressed(AffinePoint *r, const unsigned char *in65);
+// 從 33 字節壓縮公鑰 (02/03 || x) 載入，y = (x³ + 7)^((p + 1) / 4)；x 不在曲線上時返回 0
+int  ec_point_from_compressed(AffinePoint *r, const unsigned char *in33);
+// 序列化：compressed 非 0 時輸出 33 字節，否則 65 字節；返回寫入長度，無窮遠點返回 0
+size_t ec_point_serialize(unsigned char *out, const AffinePoint *a, int compressed);
+void ec_point_neg(AffinePoint *r, const AffinePoint *a);
+void ec_point_double(AffinePoint *r, const AffinePoint *a);
+void ec_point_add(AffinePoint *r, const AffinePoint *a, const AffinePoint *b);
+// GLV 自同態：r = λ·a = (β·x, y)，只需一次域乘法；λ^3 = 1 (mod n)
+void ec_point_endo(AffinePoint *r, const AffinePoint *a);
+
+// 批量加法：p[i] += q[i * q_stride]，i ∈ [0, count)，所有分母共用一次求逆。
+// q_stride 為 0 時所有點加同一個 q。scratch 至少需要 ec_batch_scratch_len(count) 個元素。
+// 兩點 x 相同（倍點或互為相反數）與無窮遠點會被單獨處理，結果與逐個相加完全一致。
+// 按 ec_set_backend 選擇的後端執行，各後端結果逐位相同。
+void ec_add_batch(AffinePoint *p, const AffinePoint *q, size_t q_stride,
+                  size_t count, FieldElement *scratch);
+size_t ec_batch_scratch_len(size_t count);
+
+// 4 x 64 位標量實現，可移植的後備路徑，也是向量後端的對照基準
+void ec_add_batch_scalar(AffinePoint *p, const AffinePoint *q, size_t q_stride,
+                         size_t count, FieldElement *scratch);
+
+/* 固定點 4 位窗口表：points[w * 15 + (j - 1)] = j·16ʷ·P，w ∈ [0, 64)，j ∈ [1, 15]。
+ * 用於大量「任意標量 × 同一個點」：每個標量最多 64 次加法，同批的標量逐窗口共用求逆。
+ */
+#define EC_WINDOW_BITS 4
+#define EC_WINDOW_COUNT 64
+#define EC_WINDOW_TABLE_LEN (EC_WINDOW_COUNT * 15)
+
+typedef struct {
+    AffinePoint *points;
+} EcWindowTable;
+
+// 成功返回 1；p 為無窮遠點時表中全為無窮遠點
+int  ec_window_init(EcWindowTable *t, const AffinePoint *p);
+void ec_window_free(EcWindowTable *t);
+/* r[i] = k_i·P，k_i 為 scalars 中第 i 個 32 字節大端標量。
+ * addends 至少 count 個元素，scratch 至少 ec_batch_scratch_len(count) 個元素。
+ */
+void ec_window_mul_batch(const EcWindowTable *t, const unsigned char *scalars, AffinePoint *r,
+                         size_t count, AffinePoint *addends, FieldElement *scratch);
+
+/* 批量加法的域運算後端。AUTO 在運行時選擇 CPU 支持的最快後端；
+ * IFMA 為 AVX-512 IFMA 8 通道 5 x 52 位實現。
+ */
+typedef enum {
+    EC_BACKEND_AUTO,
+    EC_BACKEND_SCALAR,
+    EC_BACKEND_IFMA,
+    EC_BACKEND_COUNT
+} EcBackend;
+
+// 設置進程內的後端，CPU 或編譯器不支持時返回 0 且不改變當前設置
+int ec_set_backend(EcBackend backend);
+EcBackend ec_get_backend(void);
+const char *ec_backend_name(EcBackend backend);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ECBATCH_H
@@ -0,0 +1,113 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* feistel.c
+ * https://github.com/8891689
+ * 輪函數輸入 key(32) | r(1) | R(16 字節大端) 共 49 字節，sha256 只壓縮一個塊。
+ * cycle walking 的每一步都從上一步的結果出發，所以 π 是 [0, N) 上的置換：
+ * 2h 位上的 Feistel 本身是雙射，沿它的環走到第一個落在 [0, N) 內的點即可逆。
+ */
+#include <string.h>
+
+#include "feistel.h"
+#include "sha256.h"
+
+// v < 2^256 拆成低 2h 位的高、低兩半
+static void split(const FeistelPerm *p, mpz_srcptr v, FeistelHalf *hi, FeistelHalf *lo) {
+    unsigned char bytes[32] = {0};
+    size_t len = 0;
+    mpz_export(bytes + 32 - (mpz_sgn(v) ? mpz_sizeinbase(v, 256) : 0), &len, 1, 1, 1, 0, v);
+    FeistelHalf w1 = 0, w0 = 0;
+    for (int i = 0; i < 16; ++i) {
+        w1 = w1 << 8 | bytes[i];
+        w0 = w0 << 8 | bytes[16 + i];
+    }
+    unsigned h = p->half_bits;
+    *lo = w0 & p->half_mask;
+    *hi = h == 0 ? 0 : h == 128 ? w1 : ((w0 >> h) | (w1 << (128 - h))) & p->half_mask;
+}
+
+static void join(const FeistelPerm *p, mpz_ptr out, FeistelHalf hi, FeistelHalf lo) {
+    unsigned h = p->half_bits;
+    FeistelHalf w1 = h == 128 ? hi : h == 0 ? 0 : hi >> (128 - h);
+    FeistelHalf w0 = h == 128 ? lo : h == 0 ? 0 : lo | hi << h;
+    unsigned char bytes[32];
+    for (int i = 0; i < 16; ++i) {
+        bytes[15 - i] = (unsigned char)(w1 >> (8 * i));
+        bytes[31 - i] = (unsigned char)(w0 >> (8 * i));
+    }
+    mpz_import(out, 32, 1, 1, 1, 0, bytes);
+}
+
+static FeistelHalf round_value(const FeistelPerm *p, int round, FeistelHalf right) {
+    unsigned char input[FEISTEL_KEY_SIZE + 1 + 16], hash[SHA256_BLOCK_SIZE];
+    memcpy(input, p->key, FEISTEL_KEY_SIZE);
+    input[FEISTEL_KEY_SIZE] = (unsigned char)round;
+    for (int i = 0; i < 16; ++i) input[FEISTEL_KEY_SIZE + 1 + i] = (unsigned char)(right >> (8 * (15 - i)));
+    sha256(input, sizeof(input), hash);
+    FeistelHalf v = 0;
+    for (int i = 0; i < 16; ++i) v = v << 8 | hash[i];
+    return v & p->half_mask;
+}
+
+// (hi, lo) ≤ N − 1
+static int in_range(const FeistelPerm *p, FeistelHalf hi, FeistelHalf lo) {
+    return hi < p->last_hi || (hi == p->last_hi && lo <= p->last_lo);
+}
+
+int feistel_init(FeistelPerm *p, mpz_srcptr size, const unsigned char *key) {
+    if (mpz_sgn(size) <= 0 || mpz_sizeinbase(size, 2) > 257) return 0;
+    mpz_t last;
+    mpz_init(last);
+    mpz_sub_ui(last, size, 1);
+    if (mpz_sizeinbase(last, 2) > 256) {
+        mpz_clear(last);
+        return 0;
+    }
+    unsigned bits = mpz_sgn(last) ? (unsigned)mpz_sizeinbase(last, 2) : 0;
+    p->half_bits = (bits + 1) / 2;
+    p->half_mask = p->half_bits == 128 ? ~(FeistelHalf)0 : ((FeistelHalf)1 << p->half_bits) - 1;
+    memcpy(p->key, key, FEISTEL_KEY_SIZE);
+    split(p, last, &p->last_hi, &p->last_lo);
+    mpz_clear(last);
+    return 1;
+}
+
+void feistel_apply(const FeistelPerm *p, mpz_ptr out, mpz_srcptr index) {
+    FeistelHalf left, right;
+    split(p, index, &left, &right);
+    do {
+        for (int r = 0; r < FEISTEL_ROUNDS; ++r) {
+            FeistelHalf next = left ^ round_value(p, r, right);
+            left = right;
+            right = next;
+        }
+    } while (!in_range(p, left, right));
+    join(p, out, left, right);
+}
+
+void feistel_invert(const FeistelPerm *p, mpz_ptr out, mpz_srcptr value) {
+    FeistelHalf left, right;
+    split(p, value, &left, &right);
+    do {
+        for (int r = FEISTEL_ROUNDS - 1; r >= 0; --r) {
+            FeistelHalf prev = right ^ round_value(p, r, left);
+            right = left;
+            left = prev;
+        }
+    } while (!in_range(p, left, right));
+    join(p, out, left, right);
+}
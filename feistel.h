@@ -0,0 +1,58 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* feistel.h — [0, N) 上的帶密鑰偽隨機置換
+ *
+ * 平衡 Feistel 網絡作用在 2h 位上（2^(2h) 是不小於 N 的最小 4 的冪，h ≤ 128），
+ * 輪函數為 sha256(key | 輪號 | 右半)。結果 ≥ N 時繼續對結果加密（cycle walking），
+ * 直到落回 [0, N)，所以是 [0, N) 上的雙射；平均不超過 4 次。
+ * 同一個 key 下下標 i 總是對應同一個值，按下標切分即可分給執行緒、機器，或從某個下標續跑。
+ */
+#ifndef FEISTEL_H
+#define FEISTEL_H
+
+#include <stdint.h>
+#include <gmp.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FEISTEL_KEY_SIZE 32
+#define FEISTEL_ROUNDS 6
+
+typedef unsigned __int128 FeistelHalf;
+
+typedef struct {
+    unsigned half_bits;             // h
+    FeistelHalf half_mask;
+    FeistelHalf last_hi;            // N − 1 的高、低半
+    FeistelHalf last_lo;
+    unsigned char key[FEISTEL_KEY_SIZE];
+} FeistelPerm;
+
+// size ∈ [1, 2^256]；超出時返回 0
+int  feistel_init(FeistelPerm *p, mpz_srcptr size, const unsigned char *key);
+// out = π(index)，index ∈ [0, N)
+void feistel_apply(const FeistelPerm *p, mpz_ptr out, mpz_srcptr index);
+// out = π⁻¹(value)：某個值是第幾個下標產生的
+void feistel_invert(const FeistelPerm *p, mpz_ptr out, mpz_srcptr value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FEISTEL_H */
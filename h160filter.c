@@ -0,0 +1,197 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* h160filter.c
+ * https://github.com/8891689
+ * 地址 = Base58(0x00 | h160 | 校驗和)。開頭的 '1' 個數等於這 25 字節的前導 0 字節數，
+ * 其餘字符是 X = h160 | 校驗和（192 位整數）的 Base58 表示。前綴 "1" + z 個 '1' + R
+ * 要求 h160 恰有 z 個前導 0 字節，且 X 的 D 位 Base58 表示以 R 開頭：
+ *   X ∈ [r·58^(D−|R|), (r+1)·58^(D−|R|) − 1] ∩ [2^(8(23−z)), 2^(8(24−z)) − 1]
+ * 對每個 D 取交集，右移 32 位去掉校驗和即得 hash160 區間。
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gmp.h>
+
+#include "h160filter.h"
+#include "base58.h"
+
+static const char BASE58_ALPHABET[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+// X 最多 192 位，58^33 > 2^192
+#define BASE58_MAX_DIGITS 33
+
+static uint64_t load64_be(const unsigned char *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v = v << 8 | p[i];
+    return v;
+}
+
+static int hex_nibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// 左對齊解析 1 ~ 40 個十六進制字符，右側補 fill 的半字節；返回字符數，出錯返回 0
+static size_t parse_left_hex(const char *hex, size_t len, unsigned char *out, int fill) {
+    if (len == 0 || len > 2 * H160_FILTER_SIZE) return 0;
+    for (size_t i = 0; i < 2 * H160_FILTER_SIZE; ++i) {
+        int v = fill;
+        if (i < len && (v = hex_nibble(hex[i])) < 0) return 0;
+        if (i % 2 == 0) out[i / 2] = (unsigned char)(v << 4);
+        else out[i / 2] |= (unsigned char)v;
+    }
+    return len;
+}
+
+static int add_range(H160Filter *f, const unsigned char *lo, const unsigned char *hi, const char *address) {
+    H160Range *ranges = realloc(f->ranges, (f->range_count + 1) * sizeof(H160Range));
+    if (!ranges) return 0;
+    f->ranges = ranges;
+    H160Range *r = &ranges[f->range_count++];
+    memcpy(r->lo, lo, H160_FILTER_SIZE);
+    memcpy(r->hi, hi, H160_FILTER_SIZE);
+    r->lo64 = load64_be(lo);
+    r->hi64 = load64_be(hi);
+    snprintf(r->address, sizeof(r->address), "%s", address ? address : "");
+    return 1;
+}
+
+void h160_filter_init(H160Filter *f) {
+    memset(f, 0, sizeof(*f));
+}
+
+void h160_filter_free(H160Filter *f) {
+    free(f->ranges);
+    free(f->masks);
+    memset(f, 0, sizeof(*f));
+}
+
+int h160_filter_empty(const H160Filter *f) {
+    return f->range_count == 0 && f->mask_count == 0;
+}
+
+int h160_filter_add_prefix(H160Filter *f, const char *hex) {
+    unsigned char lo[H160_FILTER_SIZE], hi[H160_FILTER_SIZE];
+    size_t len = strlen(hex);
+    if (!parse_left_hex(hex, len, lo, 0) || !parse_left_hex(hex, len, hi, 15)) return 0;
+    return add_range(f, lo, hi, NULL);
+}
+
+int h160_filter_add_mask(H160Filter *f, const char *spec) {
+    const char *colon = strchr(spec, ':');
+    H160Mask m;
+    if (!colon || !parse_left_hex(spec, colon - spec, m.value, 0)
+        || !parse_left_hex(colon + 1, strlen(colon + 1), m.mask, 0)) return 0;
+    for (int i = 0; i < H160_FILTER_SIZE; ++i) m.value[i] &= m.mask[i];
+    H160Mask *masks = realloc(f->masks, (f->mask_count + 1) * sizeof(H160Mask));
+    if (!masks) return 0;
+    f->masks = masks;
+    f->masks[f->mask_count++] = m;
+    return 1;
+}
+
+// X 的閉區間 [lo, hi] → hash160 區間
+static int add_x_range(H160Filter *f, mpz_srcptr lo, mpz_srcptr hi, const char *prefix) {
+    unsigned char a[H160_FILTER_SIZE] = {0}, b[H160_FILTER_SIZE] = {0};
+    mpz_t h;
+    size_t words;
+    mpz_init(h);
+    mpz_fdiv_q_2exp(h, lo, 32);
+    mpz_export(a + H160_FILTER_SIZE - (mpz_sgn(h) ? mpz_sizeinbase(h, 256) : 0), &words, 1, 1, 1, 0, h);
+    mpz_fdiv_q_2exp(h, hi, 32);
+    mpz_export(b + H160_FILTER_SIZE - (mpz_sgn(h) ? mpz_sizeinbase(h, 256) : 0), &words, 1, 1, 1, 0, h);
+    mpz_clear(h);
+    return add_range(f, a, b, prefix);
+}
+
+int h160_filter_add_address_prefix(H160Filter *f, const char *prefix) {
+    size_t len = strlen(prefix);
+    if (len == 0 || len > H160_FILTER_ADDR_MAX || prefix[0] != '1') return 0;
+    for (size_t i = 0; i < len; ++i) if (!strchr(BASE58_ALPHABET, prefix[i])) return 0;
+    size_t z = strspn(prefix + 1, "1");
+    const char *rest = prefix + 1 + z;
+    size_t rest_len = strlen(rest);
+    if (z >= H160_FILTER_SIZE) return 0;
+
+    mpz_t r, lo, hi, x_min, x_max, scale;
+    mpz_inits(r, lo, hi, x_min, x_max, scale, NULL);
+    // 恰好 z 個前導 0 字節；R 為空時只要求至少 z 個
+    mpz_set_ui(x_max, 1);
+    mpz_mul_2exp(x_max, x_max, 8 * (24 - z));
+    mpz_sub_ui(x_max, x_max, 1);
+    if (rest_len > 0) mpz_setbit(x_min, 8 * (23 - z));
+    for (size_t i = 0; i < rest_len; ++i) {
+        mpz_mul_ui(r, r, 58);
+        mpz_add_ui(r, r, (unsigned long)(strchr(BASE58_ALPHABET, rest[i]) - BASE58_ALPHABET));
+    }
+
+    int added = 0, ok = 1;
+    if (rest_len == 0) {
+        ok = add_x_range(f, x_min, x_max, NULL);
+        added = ok;
+    }
+    for (size_t digits = rest_len; ok && rest_len > 0 && digits <= BASE58_MAX_DIGITS; ++digits) {
+        mpz_ui_pow_ui(scale, 58, digits - rest_len);
+        mpz_mul(lo, r, scale);
+        mpz_add_ui(hi, r, 1);
+        mpz_mul(hi, hi, scale);
+        mpz_sub_ui(hi, hi, 1);
+        if (mpz_cmp(lo, x_min) < 0) mpz_set(lo, x_min);
+        if (mpz_cmp(hi, x_max) > 0) mpz_set(hi, x_max);
+        if (mpz_cmp(lo, hi) > 0) continue;
+        ok = add_x_range(f, lo, hi, prefix);
+        added += ok;
+    }
+    mpz_clears(r, lo, hi, x_min, x_max, scale, NULL);
+    return ok && added > 0;
+}
+
+// 區間端點：編碼地址確認
+static int address_has_prefix(const unsigned char *h160, const char *prefix) {
+    unsigned char payload[1 + H160_FILTER_SIZE];
+    payload[0] = 0x00;
+    memcpy(payload + 1, h160, H160_FILTER_SIZE);
+    char *encoded = base58_encode_check(payload, sizeof(payload));
+    int match = encoded && strncmp(encoded, prefix, strlen(prefix)) == 0;
+    free(encoded);
+    return match;
+}
+
+int h160_filter_match(const H160Filter *f, const unsigned char *h160) {
+    uint64_t head = load64_be(h160);
+    for (int i = 0; i < f->range_count; ++i) {
+        const H160Range *r = &f->ranges[i];
+        if (head < r->lo64 || head > r->hi64) continue;
+        if (head > r->lo64 && head < r->hi64) return 1;
+        int lo_cmp = memcmp(h160, r->lo, H160_FILTER_SIZE), hi_cmp = memcmp(h160, r->hi, H160_FILTER_SIZE);
+        if (lo_cmp < 0 || hi_cmp > 0) continue;
+        if (r->address[0] && (lo_cmp == 0 || hi_cmp == 0)) {
+            if (address_has_prefix(h160, r->address)) return 1;
+            continue;
+        }
+        return 1;
+    }
+    for (int i = 0; i < f->mask_count; ++i) {
+        const H160Mask *m = &f->masks[i];
+        int match = 1;
+        for (int j = 0; j < H160_FILTER_SIZE && match; ++j) match = (h160[j] & m->mask[j]) == m->value[j];
+        if (match) return 1;
+    }
+    return 0;
+}
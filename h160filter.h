@@ -0,0 +1,78 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* h160filter.h — hash160 前綴 / 掩碼 / 地址前綴謂詞
+ *
+ * 所有條件都化成 hash160 上的判斷，匹配時不做 Base58：
+ *   前綴    十六進制前綴，即一個 hash160 區間
+ *   掩碼    (h & mask) == (value & mask)
+ *   地址前綴 P2PKH 地址（版本 0x00）的前綴換算成若干個 hash160 區間；
+ *           區間端點上的 hash160 還取決於校驗和，只有這兩個值需要真的編碼地址比較
+ * 多個條件之間為「或」。
+ */
+#ifndef H160FILTER_H
+#define H160FILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define H160_FILTER_SIZE 20
+// 地址前綴的最大長度（字符）
+#define H160_FILTER_ADDR_MAX 34
+
+typedef struct {
+    unsigned char lo[H160_FILTER_SIZE];     // 閉區間，大端
+    unsigned char hi[H160_FILTER_SIZE];
+    uint64_t lo64;                          // lo / hi 的前 8 字節，快速判斷
+    uint64_t hi64;
+    char address[H160_FILTER_ADDR_MAX + 1]; // 來自地址前綴時為該前綴，端點需要編碼確認；否則為空串
+} H160Range;
+
+typedef struct {
+    unsigned char value[H160_FILTER_SIZE];  // 已與 mask 相與
+    unsigned char mask[H160_FILTER_SIZE];
+} H160Mask;
+
+typedef struct {
+    H160Range *ranges;
+    int range_count;
+    H160Mask *masks;
+    int mask_count;
+} H160Filter;
+
+void h160_filter_init(H160Filter *f);
+void h160_filter_free(H160Filter *f);
+int  h160_filter_empty(const H160Filter *f);
+
+// 十六進制前綴，1 ~ 40 個字符；格式錯誤返回 0
+int h160_filter_add_prefix(H160Filter *f, const char *hex);
+// "<value>:<mask>"，兩者都是左對齊的十六進制，不足 40 個字符時右側補 0
+int h160_filter_add_mask(H160Filter *f, const char *spec);
+// P2PKH 地址前綴，以 '1' 開頭；格式錯誤或不可能匹配任何地址時返回 0
+int h160_filter_add_address_prefix(H160Filter *f, const char *prefix);
+
+// 20 字節 hash160 是否滿足任一條件
+int h160_filter_match(const H160Filter *f, const unsigned char *h160);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* H160FILTER_H */
@@ -0,0 +1,107 @@
+/* hexcodec.c
+ * https://github.com/8891689
+ * 查表 / SSSE3 十六進制編碼，替代逐字節 fprintf("%02x")。
+ */
+#include "hexcodec.h"
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+// "000102...ff"：每字節兩個字符，一次 memcpy 完成
+static const char HEX_PAIRS[513] =
+    "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+    "202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+    "404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+    "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+    "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+    "a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+    "c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+    "e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+size_t hex_encode(char *dst, const unsigned char *src, size_t len) {
+    size_t i = 0;
+#if defined(__SSSE3__)
+    const __m128i lut = _mm_loadu_si128((const __m128i *)HEX_DIGITS);
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+        __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(v, mask));
+        _mm_storeu_si128((__m128i *)(dst + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *)(dst + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+#endif
+    for (; i < len; ++i) memcpy(dst + 2 * i, HEX_PAIRS + 2 * src[i], 2);
+    return 2 * len;
+}
+
+size_t hex_mpz_max_len(mpz_srcptr x) {
+    return mpz_size(x) * sizeof(mp_limb_t) * 2 + 2;
+}
+
+size_t hex_encode_mpz(char *dst, mpz_srcptr x) {
+    size_t limbs = mpz_size(x);
+    size_t pos = 0;
+    if (limbs == 0) { dst[0] = '0'; return 1; }
+    if (mpz_sgn(x) < 0) dst[pos++] = '-';
+
+    // 最高肢去掉前導 0，其餘肢定長輸出
+    int started = 0;
+    for (size_t l = limbs; l-- > 0; ) {
+        mp_limb_t limb = mpz_getlimbn(x, l);
+        for (int shift = (int)(sizeof(mp_limb_t) * 8) - 4; shift >= 0; shift -= 4) {
+            unsigned d = (unsigned)(limb >> shift) & 0x0f;
+            if (!started && d == 0) continue;
+            started = 1;
+            dst[pos++] = HEX_DIGITS[d];
+        }
+    }
+    return pos;
+}
+
+size_t hex_encode_trimmed(char *dst, const unsigned char *src, size_t len) {
+    size_t i = 0;
+    while (i < len && src[i] == 0) ++i;
+    if (i == len) { dst[0] = '0'; return 1; }
+    size_t pos = 0;
+    if (src[i] < 0x10) dst[pos++] = HEX_DIGITS[src[i++]];
+    return pos + hex_encode(dst + pos, src + i, len - i);
+}
+
+// 十六進制字符 → 數值，非法字符為 0xff
+static const uint8_t HEX_VALUES[256] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+int hex_decode(unsigned char *dst, const char *src, size_t hex_len) {
+    if (hex_len % 2 != 0) return 0;
+    // 非法字符的高 4 位非 0，整串解碼完再統一檢查，循環內無分支
+    uint8_t bad = 0;
+    for (size_t i = 0; i < hex_len / 2; ++i) {
+        uint8_t hi = HEX_VALUES[(unsigned char)src[2 * i]];
+        uint8_t lo = HEX_VALUES[(unsigned char)src[2 * i + 1]];
+        bad |= hi | lo;
+        dst[i] = (unsigned char)((hi << 4) | (lo & 0x0f));
+    }
+    return (bad & 0xf0) == 0;
+}
@@ -0,0 +1,48 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* hexcodec.h — 無 libc 調用的十六進制編碼與解碼
+ */
+#ifndef HEXCODEC_H
+#define HEXCODEC_H
+
+#include <stddef.h>
+#include <gmp.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 將 len 字節編碼為 2*len 個小寫十六進制字符（不寫結尾 '\0'），返回寫入長度
+size_t hex_encode(char *dst, const unsigned char *src, size_t len);
+
+// 按 gmp "%Zx" 的格式輸出整數（小寫、無前導 0），不分配內存；返回寫入長度
+// dst 至少需要 hex_mpz_max_len(x) 字節
+size_t hex_encode_mpz(char *dst, mpz_srcptr x);
+size_t hex_mpz_max_len(mpz_srcptr x);
+
+// 大端字節串按 "%Zx" 格式輸出（去掉前導 0，全 0 時輸出 "0"），dst 至少 2*len 字節
+size_t hex_encode_trimmed(char *dst, const unsigned char *src, size_t len);
+
+// 解碼 hex_len 個十六進制字符（大小寫均可）到 dst；長度為奇數或有非法字符時返回 0
+// 失敗時 dst 的內容未定義
+int hex_decode(unsigned char *dst, const char *src, size_t hex_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HEXCODEC_H */
@@ -0,0 +1,151 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* hitverify.c
+ * https://github.com/8891689
+ * 指紋表容量取不小於 2·count 的 2 的冪，線性探測；指紋相同的兩個目標只佔一個槽，
+ * 複核時的二分查找仍能區分它們。隊列出隊時整個數組換走，出隊方在鎖外複核。
+ */
+#include "hitverify.h"
+#include "ecbatch.h"
+#include "pkclone.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint64_t fingerprint(const unsigned char *h160) {
+    uint64_t fp = 0;
+    for (int i = 0; i < 8; ++i) fp = fp << 8 | h160[i];
+    return fp ? fp : 1;
+}
+
+static int compare_h160(const void *a, const void *b) {
+    return memcmp(a, b, HIT_H160_SIZE);
+}
+
+int hit_targets_build(HitTargets *t, const KeyList *keys, size_t *off_curve) {
+    memset(t, 0, sizeof(*t));
+    *off_curve = 0;
+    size_t total = keys->h160_count + 2 * keys->pubkey_count;
+    if (total == 0 || !(t->h160 = malloc(total * HIT_H160_SIZE))) return 0;
+
+    if (keys->h160_count) memcpy(t->h160, keys->h160, keys->h160_count * HIT_H160_SIZE);
+    size_t count = keys->h160_count;
+    for (size_t i = 0; i < keys->pubkey_count; ++i) {
+        const unsigned char *pubkey = keys->pubkeys + i * 33;
+        unsigned char pubkey_u[65];
+        AffinePoint pt;
+        pkc_hash160(pubkey, 33, t->h160 + count++ * HIT_H160_SIZE);
+        if (!ec_point_from_compressed(&pt, pubkey)) {
+            (*off_curve)++;
+            continue;
+        }
+        ec_point_serialize(pubkey_u, &pt, 0);
+        pkc_hash160(pubkey_u, 65, t->h160 + count++ * HIT_H160_SIZE);
+    }
+    qsort(t->h160, count, HIT_H160_SIZE, compare_h160);
+    size_t unique = 0;
+    for (size_t i = 0; i < count; ++i)
+        if (unique == 0 || memcmp(t->h160 + (unique - 1) * HIT_H160_SIZE, t->h160 + i * HIT_H160_SIZE, HIT_H160_SIZE) != 0)
+            memmove(t->h160 + unique++ * HIT_H160_SIZE, t->h160 + i * HIT_H160_SIZE, HIT_H160_SIZE);
+    t->count = unique;
+
+    size_t slots = 16;
+    while (slots < 2 * unique) slots <<= 1;
+    if (!(t->slots = calloc(slots, sizeof(uint64_t)))) {
+        hit_targets_free(t);
+        return 0;
+    }
+    t->mask = slots - 1;
+    for (size_t i = 0; i < unique; ++i) {
+        uint64_t fp = fingerprint(t->h160 + i * HIT_H160_SIZE);
+        size_t s = (size_t)(fp ^ fp >> 29) & t->mask;
+        while (t->slots[s] && t->slots[s] != fp) s = (s + 1) & t->mask;
+        t->slots[s] = fp;
+    }
+    return 1;
+}
+
+void hit_targets_free(HitTargets *t) {
+    free(t->slots);
+    free(t->h160);
+    memset(t, 0, sizeof(*t));
+}
+
+int hit_targets_maybe(const HitTargets *t, const unsigned char *h160) {
+    uint64_t fp = fingerprint(h160);
+    for (size_t s = (size_t)(fp ^ fp >> 29) & t->mask; t->slots[s]; s = (s + 1) & t->mask)
+        if (t->slots[s] == fp) return 1;
+    return 0;
+}
+
+int hit_targets_contains(const HitTargets *t, const unsigned char *h160) {
+    return bsearch(h160, t->h160, t->count, HIT_H160_SIZE, compare_h160) != NULL;
+}
+
+int hit_queue_init(HitQueue *q) {
+    memset(q, 0, sizeof(*q));
+    if (pthread_mutex_init(&q->lock, NULL) != 0) return 0;
+    if (pthread_cond_init(&q->ready, NULL) != 0) {
+        pthread_mutex_destroy(&q->lock);
+        return 0;
+    }
+    return 1;
+}
+
+void hit_queue_free(HitQueue *q) {
+    free(q->items);
+    pthread_cond_destroy(&q->ready);
+    pthread_mutex_destroy(&q->lock);
+}
+
+void hit_queue_push(HitQueue *q, int base_index, int relation, const unsigned char *scalar32) {
+    pthread_mutex_lock(&q->lock);
+    if (q->count == q->cap) {
+        size_t grown_cap = q->cap ? q->cap * 2 : 256;
+        HitCandidate *grown = realloc(q->items, grown_cap * sizeof(HitCandidate));
+        if (!grown) {
+            q->failed = 1;
+            pthread_mutex_unlock(&q->lock);
+            return;
+        }
+        q->items = grown;
+        q->cap = grown_cap;
+    }
+    HitCandidate *c = &q->items[q->count++];
+    c->base_index = base_index;
+    c->relation = (uint8_t)relation;
+    memcpy(c->scalar, scalar32, sizeof(c->scalar));
+    pthread_cond_signal(&q->ready);
+    pthread_mutex_unlock(&q->lock);
+}
+
+size_t hit_queue_take(HitQueue *q, HitCandidate **items) {
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0 && !q->closed) pthread_cond_wait(&q->ready, &q->lock);
+    size_t count = q->count;
+    *items = q->items;
+    q->items = NULL;
+    q->count = q->cap = 0;
+    pthread_mutex_unlock(&q->lock);
+    return count;
+}
+
+void hit_queue_close(HitQueue *q) {
+    pthread_mutex_lock(&q->lock);
+    q->closed = 1;
+    pthread_cond_broadcast(&q->ready);
+    pthread_mutex_unlock(&q->lock);
+}
@@ -0,0 +1,88 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* hitverify.h — 命中複核：目標集合的指紋表與候選隊列
+ *
+ * 目標按 keylist.h 的格式加載（公鑰、hash160 或地址），全部化成 hash160：
+ * 公鑰同時收入壓縮與未壓縮形式的 hash160。熱路徑（哈希執行緒）只查 hash160 前 8 字節的
+ * 指紋表，命中的記錄作為候選交給隊列；複核方按批取出，精確重算後再用完整的 20 字節比較，
+ * 指紋誤報在那裏丟棄。候選很少，隊列用互斥鎖保護的可增長數組，入隊不等待複核。
+ */
+#ifndef HITVERIFY_H
+#define HITVERIFY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "keylist.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HIT_H160_SIZE 20
+
+typedef struct {
+    uint64_t *slots;            // 開放定址，0 為空；指紋 0 按 1 存取
+    size_t mask;
+    unsigned char *h160;        // 排序去重後的完整 hash160，count x 20
+    size_t count;
+} HitTargets;
+
+// 一條候選記錄：與引擎批次中的 (base_index, relation, scalar) 相同
+typedef struct {
+    int base_index;
+    uint8_t relation;
+    unsigned char scalar[32];
+} HitCandidate;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    HitCandidate *items;
+    size_t count;
+    size_t cap;
+    int closed;
+    int failed;                 // 內存不足時丟失過候選
+} HitQueue;
+
+/* 由已加載的目標列表建表（見 keylist.h）；off_curve 返回不在曲線上、只收入壓縮形式的公鑰個數。
+ * 內存不足或列表為空時返回 0。
+ */
+int  hit_targets_build(HitTargets *t, const KeyList *keys, size_t *off_curve);
+void hit_targets_free(HitTargets *t);
+// 熱路徑：指紋是否在表中（可能誤報）
+int  hit_targets_maybe(const HitTargets *t, const unsigned char *h160);
+// 完整比較，返回 1 表示 h160 確實是目標
+int  hit_targets_contains(const HitTargets *t, const unsigned char *h160);
+
+int  hit_queue_init(HitQueue *q);
+void hit_queue_free(HitQueue *q);
+// 任意執行緒入隊，不等待出隊方
+void hit_queue_push(HitQueue *q, int base_index, int relation, const unsigned char *scalar32);
+/* 取走當前所有候選：*items 換成隊列的數組（調用方用完後 free），返回個數。
+ * 隊列為空時等待；已關閉且為空時返回 0。
+ */
+size_t hit_queue_take(HitQueue *q, HitCandidate **items);
+// 生產方全部結束後調用，喚醒等待中的 hit_queue_take
+void hit_queue_close(HitQueue *q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HITVERIFY_H */
@@ -0,0 +1,56 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* jobserver.h — 常駐進程：經本地 Unix 套接字接收命令行作業
+ *
+ * 客戶端把工作目錄、argv 與自己的 stdin / stdout / stderr（SCM_RIGHTS）交給常駐進程；
+ * 常駐進程按到達順序排隊，同時最多運行 max_jobs 個作業。每個作業在 fork 出的子進程中以
+ * 客戶端的三個描述符和工作目錄運行 job_main(argc, argv)，所以輸出直接寫到客戶端的終端、
+ * 管道或文件，行為與直接運行相同；子進程繼承 fork 前預熱的狀態。
+ * 狀態行（常駐進程 → 客戶端）：
+ *   queued <n>    不能立即開始，前面還有 n 個作業（運行中與排隊中）
+ *   started       子進程已啟動
+ *   exit <code>   作業結束，被信號終止時為 128 + 信號
+ * 客戶端斷開時，排隊中的作業被丟棄，運行中的作業收到 SIGINT。
+ * 套接字只允許同一用戶連接（文件權限 0600，並核對對端 uid）。
+ */
+#ifndef JOBSERVER_H
+#define JOBSERVER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 請求（工作目錄 + argv）的最大字節數
+#define JOBSERVER_MAX_REQUEST (1 << 20)
+
+typedef int (*JobMainFn)(int argc, char **argv);
+
+/* 在 path 上監聽直到收到 SIGINT / SIGTERM，然後等運行中的作業結束再返回。
+ * path 上已有可連接的常駐進程、或無法監聽時返回 -1；正常退出返回 0。
+ */
+int jobserver_serve(const char *path, int max_jobs, JobMainFn job_main);
+
+/* 提交一個作業並等待結束，返回作業的退出碼；連不上常駐進程或連接中斷返回 -1。
+ * 需要排隊時在 stderr 報告前面的作業數。
+ */
+int jobserver_submit(const char *path, int argc, char **argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JOBSERVER_H */
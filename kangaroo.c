@@ -0,0 +1,692 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* kangaroo.c
+ * https://github.com/8891689
+ * 距離用 4 x 64 位小端肢累加，只在寫入 DP 表時約化到 [0, n)。
+ * DP 表為開放定址：先 CAS 佔住 tag，寫完其餘字段後再置 ready，讀者遇到相同 tag 時等 ready。
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <secp256k1.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#define getpid GetCurrentProcessId
+#else
+#include <unistd.h>
+#endif
+
+#include "kangaroo.h"
+#include "ecbatch.h"
+
+static const char *SECP256K1_N_HEX = "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141";
+
+// n 與 2^256 − n 的小端肢
+static const uint64_t ORDER_N[4] = { 0xBFD25E8CD0364141ULL, 0xBAAEDCE6AF48A03BULL, 0xFFFFFFFFFFFFFFFEULL, 0xFFFFFFFFFFFFFFFFULL };
+static const uint64_t ORDER_COMPLEMENT[4] = { 0x402DA1732FC9BEBFULL, 0x4551231950B75FC4ULL, 1, 0 };
+
+// 跳躍表的隨機種子固定，同一平均跳距總得到同一張表
+#define KANGAROO_JUMP_SEED 0x4b414e47UL
+// 自動大小的 DP 表最多這麼多條目，超過時應加大 dp_bits
+#define KANGAROO_TABLE_MAX_ENTRIES ((size_t)1 << 24)
+#define KANGAROO_TABLE_MIN_ENTRIES ((size_t)1 << 16)
+// 合併 / 保存文件時每次讀寫的記錄數
+#define KANGAROO_IO_RECORDS 4096
+
+typedef struct {
+    uint64_t tag;           // x 的第 0 個肢，0 表示空槽
+    uint64_t check;         // x 的第 1 個肢
+    uint64_t dist[4];       // 已約化到 [0, n)
+    uint32_t kind;
+    uint32_t ready;         // 佔住 tag 的執行緒寫完其餘字段後置 1
+} DpEntry;
+
+typedef struct {
+    HugeRegion region;
+    DpEntry *entries;
+    size_t mask;
+    size_t limit;           // 超過容量的 7/8 視為表滿，探測鏈不會過長
+    size_t count;
+} DpTable;
+
+typedef enum {
+    DP_INSERTED,
+    DP_FOUND,               // 已有相同 tag 與 check 的條目，內容複製到 found
+    DP_FULL
+} DpInsert;
+
+typedef struct {
+    Kangaroo *k;
+    int thread_id;
+    uint64_t jumps;
+    uint64_t budget;        // 本執行緒的跳躍上限，0 表示不限
+    int done;
+    int error;
+    gmp_randstate_t randstate;
+} KangarooThread;
+
+struct Kangaroo {
+    secp256k1_context *secp;
+    secp256k1_pubkey target;
+    unsigned char target33[33];
+    mpz_t n;
+    mpz_t min;
+    mpz_t span;             // max − min + 1，馴服起點 min + [0, span)
+    mpz_t half;             // 野生起點 Q + w·G，w ∈ [−half, span − half)
+    int threads;
+    int dp_bits;
+    uint64_t dp_mask;
+    TopoPinMode pin;
+    unsigned long seed;
+    uint64_t mean_jump;
+    uint64_t max_jumps;
+    double expected_jumps;
+    AffinePoint jump_points[KANGAROO_JUMPS];
+    uint64_t jump_dist[KANGAROO_JUMPS];
+    DpTable table;
+    int stop;
+    int status;             // KangarooResult，第一個 SOLVED / TABLE_FULL 生效
+    int solved;
+    unsigned char key[32];
+    KangarooThread *running;
+    int running_count;
+    uint64_t jumps_before;  // 之前各次 kangaroo_run 的跳躍數
+    double seconds_before;
+    struct timespec started;
+};
+
+// ---------- 256 位距離 ----------
+
+static void dist_add(uint64_t d[4], uint64_t v) {
+    uint64_t carry = v;
+    for (int i = 0; i < 4 && carry; ++i) {
+        d[i] += carry;
+        carry = d[i] < carry;
+    }
+    // 越過 2^256 時加回 2^256 − n，值仍代表同一個標量 (mod n)
+    if (carry) {
+        unsigned __int128 acc = 0;
+        for (int i = 0; i < 4; ++i) {
+            acc += (unsigned __int128)d[i] + ORDER_COMPLEMENT[i];
+            d[i] = (uint64_t)acc;
+            acc >>= 64;
+        }
+    }
+}
+
+// d < 2^256 < 2n，至多減一次 n
+static void dist_reduce(uint64_t d[4]) {
+    int ge = 1;
+    for (int i = 3; i >= 0; --i) {
+        if (d[i] != ORDER_N[i]) { ge = d[i] > ORDER_N[i]; break; }
+    }
+    if (!ge) return;
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; ++i) {
+        uint64_t sub = ORDER_N[i] + borrow;
+        uint64_t next_borrow = (sub < borrow) | (d[i] < sub);
+        d[i] -= sub;
+        borrow = next_borrow;
+    }
+}
+
+static void dist_from_mpz(uint64_t d[4], mpz_srcptr v) {
+    size_t words = 0;
+    memset(d, 0, 4 * sizeof(uint64_t));
+    mpz_export(d, &words, -1, sizeof(uint64_t), 0, 0, v);
+}
+
+static void dist_to_mpz(mpz_t v, const uint64_t d[4]) {
+    mpz_import(v, 4, -1, sizeof(uint64_t), 0, 0, d);
+}
+
+static void dist_to_bytes(unsigned char *out32, const uint64_t d[4]) {
+    for (int i = 0; i < 32; ++i) out32[31 - i] = (unsigned char)(d[i / 8] >> (8 * (i % 8)));
+}
+
+static void dist_from_bytes(uint64_t d[4], const unsigned char *in32) {
+    memset(d, 0, 4 * sizeof(uint64_t));
+    for (int i = 0; i < 32; ++i) d[i / 8] |= (uint64_t)in32[31 - i] << (8 * (i % 8));
+}
+
+static void put_le64(unsigned char *out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) out[i] = (unsigned char)(v >> (8 * i));
+}
+
+static uint64_t get_le64(const unsigned char *in) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= (uint64_t)in[i] << (8 * i);
+    return v;
+}
+
+// ---------- DP 表 ----------
+
+static int dp_table_init(DpTable *t, size_t entries) {
+    size_t cap = KANGAROO_TABLE_MIN_ENTRIES;
+    while (cap < entries + entries / 7) cap <<= 1;
+    memset(t, 0, sizeof(*t));
+    if (!topo_huge_alloc(&t->region, cap * sizeof(DpEntry), -1)) return 0;
+    t->entries = (DpEntry *)t->region.ptr;
+#ifndef __linux__
+    // 只有 Linux 的匿名映射保證清零
+    memset(t->entries, 0, cap * sizeof(DpEntry));
+#endif
+    t->mask = cap - 1;
+    t->limit = cap - cap / 8;
+    return 1;
+}
+
+static void dp_table_free(DpTable *t) {
+    topo_huge_free(&t->region);
+    t->entries = NULL;
+}
+
+static DpInsert dp_table_insert(DpTable *t, uint64_t tag, uint64_t check, uint32_t kind, const uint64_t dist[4], DpEntry *found) {
+    size_t idx = (size_t)(tag ^ (tag >> 29)) & t->mask;
+    for (size_t probe = 0; probe <= t->mask; ++probe, idx = (idx + 1) & t->mask) {
+        DpEntry *e = &t->entries[idx];
+        uint64_t current = __atomic_load_n(&e->tag, __ATOMIC_ACQUIRE);
+        if (current == 0) {
+            if (__atomic_load_n(&t->count, __ATOMIC_RELAXED) >= t->limit) return DP_FULL;
+            if (__atomic_compare_exchange_n(&e->tag, &current, tag, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                e->check = check;
+                e->kind = kind;
+                memcpy(e->dist, dist, sizeof(e->dist));
+                __atomic_store_n(&e->ready, 1, __ATOMIC_RELEASE);
+                __atomic_fetch_add(&t->count, 1, __ATOMIC_RELAXED);
+                return DP_INSERTED;
+            }
+            // 被別的執行緒搶先，current 已是它寫入的 tag
+        }
+        if (current != tag) continue;
+        while (!__atomic_load_n(&e->ready, __ATOMIC_ACQUIRE)) {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        }
+        if (e->check != check) continue;
+        *found = *e;
+        return DP_FOUND;
+    }
+    return DP_FULL;
+}
+
+// ---------- 點與標量 ----------
+
+static void pubkey_to_point(const secp256k1_context *secp, const secp256k1_pubkey *pk, AffinePoint *out) {
+    unsigned char uncompressed[65];
+    size_t len = sizeof(uncompressed);
+    secp256k1_ec_pubkey_serialize(secp, uncompressed, &len, pk, SECP256K1_EC_UNCOMPRESSED);
+    ec_point_from_uncompressed(out, uncompressed);
+}
+
+// 標量 (mod n) 的 32 字節大端
+static void scalar_bytes(unsigned char *out32, mpz_srcptr v, mpz_srcptr n) {
+    mpz_t r;
+    uint64_t d[4];
+    mpz_init(r);
+    mpz_mod(r, v, n);
+    dist_from_mpz(d, r);
+    dist_to_bytes(out32, d);
+    mpz_clear(r);
+}
+
+// 重新放置一隻袋鼠：馴服的在 (min + t)·G，野生的在 Q + w·G
+static void lane_seed(Kangaroo *k, gmp_randstate_t rs, mpz_t r, int kind, AffinePoint *pt, uint64_t dist[4]) {
+    unsigned char tweak[32];
+    secp256k1_pubkey pk;
+    int ok;
+    do {
+        mpz_urandomm(r, rs, k->span);
+        if (kind == KANGAROO_TAME) {
+            mpz_add(r, r, k->min);
+            scalar_bytes(tweak, r, k->n);
+            ok = secp256k1_ec_pubkey_create(k->secp, &pk, tweak);
+        } else {
+            mpz_sub(r, r, k->half);
+            mpz_mod(r, r, k->n);
+            scalar_bytes(tweak, r, k->n);
+            pk = k->target;
+            ok = secp256k1_ec_pubkey_tweak_add(k->secp, &pk, tweak);
+        }
+    } while (!ok);
+    pubkey_to_point(k->secp, &pk, pt);
+    dist_from_mpz(dist, r);
+}
+
+// 馴服距離 − 野生距離即候選私鑰；tag / check 只是 x 的指紋，必須用 k·G = Q 確認
+static int try_solve(Kangaroo *k, const uint64_t tame[4], const uint64_t wild[4]) {
+    mpz_t a, b;
+    unsigned char key[32], serialized[33];
+    size_t len = sizeof(serialized);
+    secp256k1_pubkey pk;
+    mpz_inits(a, b, NULL);
+    dist_to_mpz(a, tame);
+    dist_to_mpz(b, wild);
+    mpz_sub(a, a, b);
+    scalar_bytes(key, a, k->n);
+    mpz_clears(a, b, NULL);
+    if (!secp256k1_ec_pubkey_create(k->secp, &pk, key)) return 0;
+    secp256k1_ec_pubkey_serialize(k->secp, serialized, &len, &pk, SECP256K1_EC_COMPRESSED);
+    if (memcmp(serialized, k->target33, 33) != 0) return 0;
+    if (__atomic_exchange_n(&k->solved, 1, __ATOMIC_ACQ_REL) == 0) memcpy(k->key, key, 32);
+    return 1;
+}
+
+static void finish(Kangaroo *k, int status) {
+    int expected = KANGAROO_STOPPED;
+    __atomic_compare_exchange_n(&k->status, &expected, status, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&k->stop, 1, __ATOMIC_RELAXED);
+}
+
+static int stopped(const Kangaroo *k) {
+    return __atomic_load_n(&k->stop, __ATOMIC_RELAXED);
+}
+
+/* 記錄一個 DP。返回 1 表示該袋鼠與同類袋鼠走到了同一條路徑上，之後只會重複對方的 DP，
+ * 需要重新放置。
+ */
+static int record_dp(Kangaroo *k, const AffinePoint *pt, uint32_t kind, const uint64_t walked[4]) {
+    uint64_t d[4];
+    memcpy(d, walked, sizeof(d));
+    dist_reduce(d);
+    uint64_t tag = pt->x.n[0] ? pt->x.n[0] : 1;
+    DpEntry found;
+    switch (dp_table_insert(&k->table, tag, pt->x.n[1], kind, d, &found)) {
+        case DP_INSERTED: return 0;
+        case DP_FULL: finish(k, KANGAROO_TABLE_FULL); return 0;
+        case DP_FOUND: break;
+    }
+    if (found.kind == kind) return memcmp(found.dist, d, sizeof(d)) == 0;
+    int solved = kind == KANGAROO_TAME ? try_solve(k, d, found.dist) : try_solve(k, found.dist, d);
+    if (solved) finish(k, KANGAROO_SOLVED);
+    return 0;
+}
+
+// ---------- 工作執行緒 ----------
+
+static void *kangaroo_thread(void *arg) {
+    KangarooThread *t = (KangarooThread *)arg;
+    Kangaroo *k = t->k;
+    topo_pin_self(topo_place(k->pin, t->thread_id, 0, NULL));
+
+    // 綁核之後分配，跳躍表與袋鼠狀態都在本節點的內存中
+    AffinePoint *jumps = malloc(KANGAROO_JUMPS * sizeof(AffinePoint));
+    uint64_t *jump_dist = malloc(KANGAROO_JUMPS * sizeof(uint64_t));
+    AffinePoint *pos = malloc(KANGAROO_LANES * sizeof(AffinePoint));
+    AffinePoint *addends = malloc(KANGAROO_LANES * sizeof(AffinePoint));
+    uint64_t (*dist)[4] = malloc(KANGAROO_LANES * sizeof(*dist));
+    FieldElement *scratch = malloc(ec_batch_scratch_len(KANGAROO_LANES) * sizeof(FieldElement));
+    mpz_t r;
+    mpz_init(r);
+    if (!jumps || !jump_dist || !pos || !addends || !dist || !scratch) {
+        t->error = 1;
+        goto done;
+    }
+    memcpy(jumps, k->jump_points, KANGAROO_JUMPS * sizeof(AffinePoint));
+    memcpy(jump_dist, k->jump_dist, KANGAROO_JUMPS * sizeof(uint64_t));
+    for (int i = 0; i < KANGAROO_LANES; ++i) lane_seed(k, t->randstate, r, i & 1, &pos[i], dist[i]);
+
+    while (!stopped(k) && (t->budget == 0 || t->jumps < t->budget)) {
+        for (int i = 0; i < KANGAROO_LANES; ++i) {
+            unsigned j = (unsigned)(pos[i].x.n[0] & (KANGAROO_JUMPS - 1));
+            addends[i] = jumps[j];
+            dist_add(dist[i], jump_dist[j]);
+        }
+        ec_add_batch(pos, addends, 1, KANGAROO_LANES, scratch);
+        for (int i = 0; i < KANGAROO_LANES; ++i) {
+            // 落到無窮遠點（野生袋鼠恰好跳到 −jᵢ·G）同樣重新放置
+            if (pos[i].infinity
+                || ((pos[i].x.n[3] & k->dp_mask) == 0 && record_dp(k, &pos[i], (uint32_t)(i & 1), dist[i])))
+                lane_seed(k, t->randstate, r, i & 1, &pos[i], dist[i]);
+        }
+        __atomic_store_n(&t->jumps, t->jumps + KANGAROO_LANES, __ATOMIC_RELAXED);
+    }
+
+done:
+    mpz_clear(r);
+    free(jumps); free(jump_dist); free(pos); free(addends); free(dist); free(scratch);
+    __atomic_store_n(&t->done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// ---------- 公共接口 ----------
+
+void kangaroo_params_init(KangarooParams *params) {
+    params->threads = 1;
+    params->dp_bits = -1;
+    params->pin = TOPO_PIN_NONE;
+    params->seed = 0;
+    params->mean_jump = 0;
+    params->max_jumps = 0;
+    params->reserve = 0;
+    mpz_inits(params->min_scalar, params->max_scalar, NULL);
+    mpz_set_ui(params->min_scalar, 1);
+    mpz_set_str(params->max_scalar, SECP256K1_N_HEX, 16);
+    mpz_sub_ui(params->max_scalar, params->max_scalar, 1);
+}
+
+void kangaroo_params_clear(KangarooParams *params) {
+    mpz_clears(params->min_scalar, params->max_scalar, NULL);
+}
+
+// 平均跳距為 mean 的跳躍表：距離在 [1, 2·mean] 內均勻取
+static int build_jumps(Kangaroo *k) {
+    gmp_randstate_t rs;
+    mpz_t r, bound;
+    unsigned char tweak[32];
+    uint64_t d[4];
+    secp256k1_pubkey pk;
+    int ok = 1;
+    gmp_randinit_default(rs);
+    gmp_randseed_ui(rs, KANGAROO_JUMP_SEED);
+    mpz_inits(r, bound, NULL);
+    // unsigned long 在 Windows 上只有 32 位，經由肢數組轉換
+    uint64_t mean[4] = { k->mean_jump, 0, 0, 0 };
+    dist_to_mpz(bound, mean);
+    mpz_mul_2exp(bound, bound, 1);
+    for (int i = 0; i < KANGAROO_JUMPS && ok; ++i) {
+        mpz_urandomm(r, rs, bound);
+        mpz_add_ui(r, r, 1);
+        dist_from_mpz(d, r);
+        k->jump_dist[i] = d[0];
+        dist_to_bytes(tweak, d);
+        ok = secp256k1_ec_pubkey_create(k->secp, &pk, tweak);
+        if (ok) pubkey_to_point(k->secp, &pk, &k->jump_points[i]);
+    }
+    mpz_clears(r, bound, NULL);
+    gmp_randclear(rs);
+    return ok;
+}
+
+Kangaroo *kangaroo_create(const unsigned char *pubkey, size_t len, const KangarooParams *params) {
+    if (params->threads <= 0 || params->dp_bits > KANGAROO_MAX_DP_BITS) return NULL;
+    Kangaroo *k = calloc(1, sizeof(Kangaroo));
+    if (!k) return NULL;
+    mpz_inits(k->n, k->min, k->span, k->half, NULL);
+    mpz_set_str(k->n, SECP256K1_N_HEX, 16);
+    k->secp = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
+    size_t serialized_len = sizeof(k->target33);
+    if (!k->secp || !secp256k1_ec_pubkey_parse(k->secp, &k->target, pubkey, len)
+        || mpz_cmp_ui(params->min_scalar, 1) < 0 || mpz_cmp(params->min_scalar, params->max_scalar) > 0
+        || mpz_cmp(params->max_scalar, k->n) >= 0) {
+        kangaroo_destroy(k);
+        return NULL;
+    }
+    secp256k1_ec_pubkey_serialize(k->secp, k->target33, &serialized_len, &k->target, SECP256K1_EC_COMPRESSED);
+    mpz_set(k->min, params->min_scalar);
+    mpz_sub(k->span, params->max_scalar, params->min_scalar);
+    mpz_add_ui(k->span, k->span, 1);
+    mpz_fdiv_q_2exp(k->half, k->span, 1);
+    k->threads = params->threads;
+    k->pin = params->pin;
+    k->seed = params->seed ? params->seed : (unsigned long)time(NULL) ^ (unsigned long)getpid();
+    k->max_jumps = params->max_jumps;
+
+    // 最優平均跳距約為 袋鼠總數·√w/4；dp_bits 使每隻袋鼠到第一個 DP 的路程只佔總量的一小部分
+    unsigned long kangaroos = (unsigned long)k->threads * KANGAROO_LANES;
+    mpz_t root;
+    mpz_init(root);
+    mpz_sqrt(root, k->span);
+    double mean = params->mean_jump ? (double)params->mean_jump : (double)kangaroos * mpz_get_d(root) / 4;
+    if (mean < 1) mean = 1;
+    if (mean > 0x1p62) mean = 0x1p62;
+    k->mean_jump = (uint64_t)mean;
+    if (params->dp_bits >= 0) {
+        k->dp_bits = params->dp_bits;
+    } else {
+        // floor(log2(√w / 袋鼠總數)) − 2
+        mpz_fdiv_q_ui(root, root, kangaroos);
+        long bits = mpz_sgn(root) ? (long)mpz_sizeinbase(root, 2) - 3 : 0;
+        k->dp_bits = bits < 0 ? 0 : bits > KANGAROO_MAX_DP_BITS ? KANGAROO_MAX_DP_BITS : (int)bits;
+    }
+    mpz_sqrt(root, k->span);
+    k->dp_mask = k->dp_bits ? ~0ULL << (64 - k->dp_bits) : 0;
+    double dp_len = (double)(1ULL << k->dp_bits);
+    k->expected_jumps = 2 * mpz_get_d(root) + kangaroos * dp_len;
+    mpz_clear(root);
+
+    // 預留期望 DP 數的 4 倍，運氣差的運行也放得下
+    double expected_dps = 4 * k->expected_jumps / dp_len;
+    size_t entries = expected_dps < (double)KANGAROO_TABLE_MAX_ENTRIES ? (size_t)expected_dps : KANGAROO_TABLE_MAX_ENTRIES;
+    if (!build_jumps(k) || !dp_table_init(&k->table, entries + params->reserve)) {
+        kangaroo_destroy(k);
+        return NULL;
+    }
+    return k;
+}
+
+void kangaroo_destroy(Kangaroo *k) {
+    if (!k) return;
+    dp_table_free(&k->table);
+    if (k->secp) secp256k1_context_destroy(k->secp);
+    mpz_clears(k->n, k->min, k->span, k->half, NULL);
+    free(k);
+}
+
+int kangaroo_dp_bits(const Kangaroo *k) {
+    return k->dp_bits;
+}
+
+uint64_t kangaroo_mean_jump(const Kangaroo *k) {
+    return k->mean_jump;
+}
+
+double kangaroo_expected_jumps(const Kangaroo *k) {
+    return k->expected_jumps;
+}
+
+int kangaroo_count(const Kangaroo *k) {
+    return k->threads * KANGAROO_LANES;
+}
+
+static double seconds_since(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+void kangaroo_stats(const Kangaroo *k, KangarooStats *stats) {
+    stats->jumps = k->jumps_before;
+    stats->seconds = k->seconds_before;
+    if (k->running) {
+        for (int i = 0; i < k->running_count; ++i) stats->jumps += __atomic_load_n(&k->running[i].jumps, __ATOMIC_RELAXED);
+        stats->seconds += seconds_since(&k->started);
+    }
+    stats->dps = __atomic_load_n(&k->table.count, __ATOMIC_RELAXED);
+}
+
+void kangaroo_stop(Kangaroo *k) {
+    __atomic_store_n(&k->stop, 1, __ATOMIC_RELAXED);
+}
+
+int kangaroo_key(const Kangaroo *k, unsigned char *out32) {
+    if (!__atomic_load_n(&k->solved, __ATOMIC_ACQUIRE)) return 0;
+    memcpy(out32, k->key, 32);
+    return 1;
+}
+
+KangarooResult kangaroo_run(Kangaroo *k, KangarooProgressFn progress, void *user) {
+    if (k->solved) return KANGAROO_SOLVED;
+    // 工作執行緒開始前確定批量加法後端
+    ec_get_backend();
+
+    KangarooThread *threads = calloc(k->threads, sizeof(KangarooThread));
+    pthread_t *tids = malloc(k->threads * sizeof(pthread_t));
+    if (!threads || !tids) {
+        free(threads); free(tids);
+        return KANGAROO_ERROR;
+    }
+    k->status = KANGAROO_STOPPED;
+    k->running = threads;
+    k->running_count = k->threads;
+    clock_gettime(CLOCK_MONOTONIC, &k->started);
+
+    // 預算按執行緒均分，取整到整步
+    uint64_t budget = 0;
+    if (k->max_jumps) {
+        budget = (k->max_jumps + k->threads - 1) / k->threads;
+        budget = (budget + KANGAROO_LANES - 1) / KANGAROO_LANES * KANGAROO_LANES;
+    }
+    int started = 0, error = 0;
+    for (int i = 0; i < k->threads; ++i) {
+        KangarooThread *t = &threads[i];
+        t->k = k;
+        t->thread_id = i;
+        t->budget = budget;
+        gmp_randinit_default(t->randstate);
+        gmp_randseed_ui(t->randstate, k->seed ^ (unsigned long)(i + 1));
+        if (pthread_create(&tids[i], NULL, kangaroo_thread, t) != 0) {
+            gmp_randclear(t->randstate);
+            kangaroo_stop(k);
+            error = 1;
+            break;
+        }
+        started++;
+    }
+
+    // 本執行緒只負責彙報進度
+    int finished = 0;
+    double last_report = 0;
+    while (finished < started) {
+        struct timespec ts = { 0, 100000000 };
+        nanosleep(&ts, NULL);
+        finished = 0;
+        for (int i = 0; i < started; ++i) finished += __atomic_load_n(&threads[i].done, __ATOMIC_ACQUIRE);
+        double now = seconds_since(&k->started);
+        if (progress && finished < started && now - last_report >= 1) {
+            KangarooStats stats;
+            kangaroo_stats(k, &stats);
+            progress(&stats, user);
+            last_report = now;
+        }
+    }
+    for (int i = 0; i < started; ++i) {
+        pthread_join(tids[i], NULL);
+        if (threads[i].error) error = 1;
+        gmp_randclear(threads[i].randstate);
+        k->jumps_before += threads[i].jumps;
+    }
+    k->seconds_before += seconds_since(&k->started);
+    k->running = NULL;
+    k->running_count = 0;
+    free(threads);
+    free(tids);
+    if (k->solved) return KANGAROO_SOLVED;
+    if (error) return KANGAROO_ERROR;
+    return (KangarooResult)k->status;
+}
+
+// ---------- DP 文件 ----------
+
+static int read_header(FILE *fp, KangarooFileInfo *info) {
+    unsigned char header[KANGAROO_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), fp) != sizeof(header)) return 0;
+    if (memcmp(header, KANGAROO_FILE_MAGIC, sizeof(KANGAROO_FILE_MAGIC)) != 0) return 0;
+    if (header[8] != KANGAROO_FILE_VERSION) return 0;
+    info->dp_bits = header[9];
+    memcpy(info->target, header + 10, 33);
+    info->mean_jump = get_le64(header + 48);
+    info->count = get_le64(header + 56);
+    return 1;
+}
+
+int kangaroo_file_info(const char *path, KangarooFileInfo *info) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return 0;
+    int ok = read_header(fp, info);
+    fclose(fp);
+    return ok;
+}
+
+long long kangaroo_load(Kangaroo *k, const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return -1;
+    KangarooFileInfo info;
+    unsigned char *buf = malloc((size_t)KANGAROO_IO_RECORDS * KANGAROO_RECORD_SIZE);
+    if (!buf || !read_header(fp, &info)) {
+        free(buf);
+        fclose(fp);
+        return -1;
+    }
+    int same_target = memcmp(info.target, k->target33, 33) == 0;
+    long long added = 0;
+    uint64_t left = info.count;
+    while (left > 0 && added >= 0) {
+        size_t want = left < KANGAROO_IO_RECORDS ? (size_t)left : KANGAROO_IO_RECORDS;
+        if (fread(buf, KANGAROO_RECORD_SIZE, want, fp) != want) { added = -1; break; }
+        left -= want;
+        for (size_t i = 0; i < want; ++i) {
+            const unsigned char *rec = buf + i * KANGAROO_RECORD_SIZE;
+            uint32_t kind = rec[16];
+            // 野生距離相對於寫文件時的目標，換了目標就沒有意義
+            if (kind > KANGAROO_WILD || (kind == KANGAROO_WILD && !same_target)) continue;
+            uint64_t d[4];
+            dist_from_bytes(d, rec + 17);
+            DpEntry found;
+            DpInsert r = dp_table_insert(&k->table, get_le64(rec), get_le64(rec + 8), kind, d, &found);
+            if (r == DP_FULL) { added = -1; break; }
+            if (r == DP_INSERTED) { added++; continue; }
+            if (found.kind != kind) {
+                if (kind == KANGAROO_TAME) try_solve(k, d, found.dist);
+                else try_solve(k, found.dist, d);
+            }
+        }
+    }
+    free(buf);
+    fclose(fp);
+    return added;
+}
+
+long long kangaroo_save(const Kangaroo *k, const char *path) {
+    FILE *fp = fopen(path, "wb");
+    if (!fp) return -1;
+    unsigned char header[KANGAROO_HEADER_SIZE] = {0};
+    memcpy(header, KANGAROO_FILE_MAGIC, sizeof(KANGAROO_FILE_MAGIC));
+    header[8] = KANGAROO_FILE_VERSION;
+    header[9] = (unsigned char)k->dp_bits;
+    memcpy(header + 10, k->target33, 33);
+    put_le64(header + 48, k->mean_jump);
+    put_le64(header + 56, k->table.count);
+    int ok = fwrite(header, 1, sizeof(header), fp) == sizeof(header);
+
+    unsigned char *buf = malloc((size_t)KANGAROO_IO_RECORDS * KANGAROO_RECORD_SIZE);
+    long long written = 0;
+    size_t pending = 0;
+    ok = ok && buf;
+    for (size_t i = 0; ok && i <= k->table.mask; ++i) {
+        const DpEntry *e = &k->table.entries[i];
+        if (e->tag == 0) continue;
+        unsigned char *rec = buf + pending * KANGAROO_RECORD_SIZE;
+        put_le64(rec, e->tag);
+        put_le64(rec + 8, e->check);
+        rec[16] = (unsigned char)e->kind;
+        dist_to_bytes(rec + 17, e->dist);
+        if (++pending == KANGAROO_IO_RECORDS) {
+            ok = fwrite(buf, KANGAROO_RECORD_SIZE, pending, fp) == pending;
+            pending = 0;
+        }
+        written++;
+    }
+    if (ok && pending) ok = fwrite(buf, KANGAROO_RECORD_SIZE, pending, fp) == pending;
+    free(buf);
+    if (fclose(fp) != 0) ok = 0;
+    return ok ? written : -1;
+}
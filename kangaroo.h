@@ -0,0 +1,144 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* kangaroo.h — Pollard kangaroo (λ) 區間求解
+ *
+ * 已知 Q = k·G 且 k ∈ [min, max]，期望約 2·√(max − min) 次跳躍求出 k。
+ * 每個執行緒推進 KANGAROO_LANES 隻袋鼠，偶數通道為馴服袋鼠（從 (min + t)·G 出發），
+ * 奇數通道為野生袋鼠（從 Q + w·G 出發）。每一步按 x 的低位從跳躍表中選一個 jᵢ·G，
+ * 全部通道用一次批量加法推進。x 的高 dp_bits 位為 0 的點是可區分點 (DP)，
+ * 連同走過的距離寫入所有執行緒共用的無鎖哈希表；一隻馴服袋鼠與一隻野生袋鼠
+ * 落在同一個 DP 上時 k = 馴服距離 − 野生距離 (mod n)。
+ *
+ * DP 表可以保存到文件並在下次運行時合併，跳躍表由文件頭中的平均跳距確定，
+ * 恢復的袋鼠與上次走的是同一張跳躍表。馴服 DP 與目標無關，換目標時仍可合併。
+ *
+ *   KangarooParams params;
+ *   kangaroo_params_init(&params);
+ *   mpz_set(params.min_scalar, min); mpz_set(params.max_scalar, max);
+ *   Kangaroo *k = kangaroo_create(pubkey33, 33, &params);
+ *   if (kangaroo_run(k, NULL, NULL) == KANGAROO_SOLVED) kangaroo_key(k, key32);
+ *   kangaroo_destroy(k);
+ */
+#ifndef KANGAROO_H
+#define KANGAROO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <gmp.h>
+
+#include "topology.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 每個執行緒同時推進的袋鼠數（共用一次求逆）
+#define KANGAROO_LANES 256
+// 跳躍表大小，按 x 的低 5 位選取
+#define KANGAROO_JUMPS 32
+#define KANGAROO_MAX_DP_BITS 60
+
+/* DP 文件 = 64 字節頭 + 定長記錄。
+ * 頭：magic[8] | version | dp_bits | 目標壓縮公鑰[33] | 保留[5] | mean_jump (8, 小端) | 記錄數 (8, 小端)
+ * 記錄：tag (8, 小端) | check (8, 小端) | kind (1) | distance (32 字節大端)
+ * tag / check 是 DP 的 x 座標的第 0 / 1 個 64 位肢。馴服記錄的 distance 是 DP 的私鑰，
+ * 野生記錄的 distance 是 w，DP = Q + w·G。
+ */
+#define KANGAROO_FILE_MAGIC "PKKANGA"
+#define KANGAROO_FILE_VERSION 1
+#define KANGAROO_HEADER_SIZE 64
+#define KANGAROO_RECORD_SIZE 49
+
+enum {
+    KANGAROO_TAME = 0,
+    KANGAROO_WILD = 1
+};
+
+typedef enum {
+    KANGAROO_ERROR = -1,
+    KANGAROO_STOPPED,       // 跳躍次數用完或 kangaroo_stop
+    KANGAROO_SOLVED,
+    KANGAROO_TABLE_FULL     // DP 表已滿，應加大 dp_bits 後從保存的文件繼續
+} KangarooResult;
+
+typedef struct {
+    int threads;
+    int dp_bits;            // -1：按區間大小與袋鼠數自動選擇
+    TopoPinMode pin;
+    unsigned long seed;     // 起點的隨機種子，0 表示 time ^ pid
+    uint64_t mean_jump;     // 0：自動，約 袋鼠總數·√(max − min)/4；恢復時取文件頭中的值
+    uint64_t max_jumps;     // 所有執行緒合計的跳躍次數上限，0 表示不限
+    size_t reserve;         // DP 表為待合併的文件額外預留的條目數
+    mpz_t min_scalar;
+    mpz_t max_scalar;
+} KangarooParams;
+
+typedef struct {
+    uint64_t jumps;
+    uint64_t dps;           // 表中的 DP 數，含合併進來的
+    double seconds;
+} KangarooStats;
+
+// kangaroo_file_info 讀出的文件頭
+typedef struct {
+    unsigned char target[33];
+    int dp_bits;
+    uint64_t mean_jump;
+    uint64_t count;
+} KangarooFileInfo;
+
+typedef struct Kangaroo Kangaroo;
+
+// 在調用 kangaroo_run 的執行緒中大約每秒調用一次
+typedef void (*KangarooProgressFn)(const KangarooStats *stats, void *user);
+
+// 默認：1 個執行緒，自動 dp_bits 與平均跳距，不限跳躍次數，區間 [1, n-1]
+void kangaroo_params_init(KangarooParams *params);
+void kangaroo_params_clear(KangarooParams *params);
+
+// 目標公鑰 33 或 65 字節；區間非法 (min < 1、min > max、max >= n) 或內存不足時返回 NULL
+Kangaroo *kangaroo_create(const unsigned char *pubkey, size_t len, const KangarooParams *params);
+void kangaroo_destroy(Kangaroo *k);
+
+int      kangaroo_dp_bits(const Kangaroo *k);
+uint64_t kangaroo_mean_jump(const Kangaroo *k);
+// 期望的總跳躍次數：2·√(max − min) 加上每隻袋鼠到第一個 DP 的 2^dp_bits
+double   kangaroo_expected_jumps(const Kangaroo *k);
+int      kangaroo_count(const Kangaroo *k);
+
+// 阻塞直到求出、停止或表滿
+KangarooResult kangaroo_run(Kangaroo *k, KangarooProgressFn progress, void *user);
+// 可以在信號處理函數中調用；kangaroo_run 在各執行緒完成當前一步後返回 KANGAROO_STOPPED
+void kangaroo_stop(Kangaroo *k);
+// 求出後的私鑰，32 字節大端；未求出時返回 0
+int  kangaroo_key(const Kangaroo *k, unsigned char *out32);
+void kangaroo_stats(const Kangaroo *k, KangarooStats *stats);
+
+// 讀文件頭，成功返回 1
+int kangaroo_file_info(const char *path, KangarooFileInfo *info);
+/* 合併 DP 文件。目標不同的文件只合併馴服記錄。合併時遇到可用的碰撞直接求出 k。
+ * 返回新加入的記錄數，失敗（讀錯誤、表滿）返回 -1。
+ */
+long long kangaroo_load(Kangaroo *k, const char *path);
+// 保存表中全部 DP，只能在 kangaroo_run 之外調用；返回寫出的記錄數，失敗返回 -1
+long long kangaroo_save(const Kangaroo *k, const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KANGAROO_H */
@@ -0,0 +1,249 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* keylist.c
+ * https://github.com/8891689
+ * 每個執行緒把自己那段的結果放進局部數組，全部結束後按段的順序拼接，行號由各段行數的前綴和得出。
+ */
+#include "keylist.h"
+#include "hexcodec.h"
+#include "base58.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// 每段至少這麼大，小文件不值得開多個執行緒
+#define KEYLIST_MIN_CHUNK ((size_t)1 << 20)
+
+typedef struct {
+    const char *begin;
+    const char *end;
+    unsigned accept;
+    unsigned char *pubkeys;
+    size_t pubkey_count, pubkey_cap;
+    unsigned char *h160;
+    size_t h160_count, h160_cap;
+    size_t line_count;
+    size_t bad_count;
+    size_t bad_lines[KEYLIST_BAD_REPORT];   // 段內行號，從 0 起
+    int error;
+} KeyChunk;
+
+// 整個文件的只讀映射；非 POSIX 平台讀入內存
+typedef struct {
+    const char *data;
+    size_t size;
+    int mapped;
+} FileView;
+
+static int file_view_open(FileView *view, const char *path) {
+    memset(view, 0, sizeof(*view));
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0) { close(fd); return 0; }
+    view->size = (size_t)st.st_size;
+    if (view->size > 0) {
+        void *p = mmap(NULL, view->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, view->size, MADV_SEQUENTIAL);
+            view->data = p;
+            view->mapped = 1;
+        }
+    }
+    close(fd);
+    if (view->size == 0 || view->mapped) return 1;
+#endif
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return 0;
+    fseek(fp, 0, SEEK_END);
+    long len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *buf = malloc(len > 0 ? (size_t)len : 1);
+    if (!buf || len < 0 || fread(buf, 1, (size_t)len, fp) != (size_t)len) {
+        free(buf);
+        fclose(fp);
+        return 0;
+    }
+    fclose(fp);
+    view->data = buf;
+    view->size = (size_t)len;
+    return 1;
+}
+
+static void file_view_close(FileView *view) {
+#ifndef _WIN32
+    if (view->mapped) {
+        munmap((void *)view->data, view->size);
+        return;
+    }
+#endif
+    free((void *)view->data);
+}
+
+// 數組滿時加倍；失敗返回 NULL 並置 error
+static unsigned char *chunk_slot(KeyChunk *c, unsigned char **array, size_t *count, size_t *cap, size_t width) {
+    if (*count == *cap) {
+        size_t grown_cap = *cap ? *cap * 2 : 1024;
+        unsigned char *grown = realloc(*array, grown_cap * width);
+        if (!grown) { c->error = 1; return NULL; }
+        *array = grown;
+        *cap = grown_cap;
+    }
+    return *array + (*count)++ * width;
+}
+
+static void chunk_bad(KeyChunk *c) {
+    if (c->bad_count < KEYLIST_BAD_REPORT) c->bad_lines[c->bad_count] = c->line_count;
+    c->bad_count++;
+}
+
+// 解析一個字段，成功返回 1
+static int parse_field(KeyChunk *c, const char *s, size_t len) {
+    unsigned char bytes[65];
+    if ((len == 66 || len == 130) && (c->accept & KEYLIST_PUBKEY)) {
+        if (!hex_decode(bytes, s, len)) return 0;
+        if (len == 66 && bytes[0] != 0x02 && bytes[0] != 0x03) return 0;
+        if (len == 130) {
+            if (bytes[0] != 0x04) return 0;
+            bytes[0] = (unsigned char)(0x02 | (bytes[64] & 1));
+        }
+        unsigned char *dst = chunk_slot(c, &c->pubkeys, &c->pubkey_count, &c->pubkey_cap, 33);
+        if (dst) memcpy(dst, bytes, 33);
+        return 1;
+    }
+    if (!(c->accept & KEYLIST_H160)) return 0;
+    if (len == 40) {
+        if (!hex_decode(bytes, s, len)) return 0;
+        unsigned char *dst = chunk_slot(c, &c->h160, &c->h160_count, &c->h160_cap, 20);
+        if (dst) memcpy(dst, bytes, 20);
+        return 1;
+    }
+    size_t payload_len;
+    if (!base58_decode_check_into(s, len, bytes, sizeof(bytes), &payload_len) || payload_len != 21) return 0;
+    unsigned char *dst = chunk_slot(c, &c->h160, &c->h160_count, &c->h160_cap, 20);
+    if (dst) memcpy(dst, bytes + 1, 20);
+    return 1;
+}
+
+static void *chunk_thread(void *arg) {
+    KeyChunk *c = (KeyChunk *)arg;
+    const char *p = c->begin;
+    while (p < c->end && !c->error) {
+        const char *nl = memchr(p, '\n', (size_t)(c->end - p));
+        const char *line_end = nl ? nl : c->end;
+        const char *s = p;
+        while (s < line_end && (*s == ' ' || *s == '\t')) ++s;
+        const char *e = s;
+        while (e < line_end && *e != ' ' && *e != '\t' && *e != '\r') ++e;
+        if (e > s && *s != '#' && !parse_field(c, s, (size_t)(e - s))) chunk_bad(c);
+        c->line_count++;
+        p = line_end + 1;
+    }
+    return NULL;
+}
+
+int keylist_load(KeyList *list, const char *path, int threads, unsigned accept) {
+    memset(list, 0, sizeof(*list));
+    FileView view;
+    if (!file_view_open(&view, path)) return 0;
+
+    size_t chunks = threads > 0 ? (size_t)threads : 1;
+    if (chunks > view.size / KEYLIST_MIN_CHUNK) chunks = view.size / KEYLIST_MIN_CHUNK;
+    if (chunks == 0) chunks = 1;
+    KeyChunk *parts = calloc(chunks, sizeof(KeyChunk));
+    pthread_t *tids = malloc(chunks * sizeof(pthread_t));
+    if (!parts || !tids) {
+        free(parts); free(tids);
+        file_view_close(&view);
+        return 0;
+    }
+
+    // 段邊界從等分點向後移到下一個換行之後，每行只屬於一段
+    const char *data = view.data, *file_end = view.data + view.size;
+    const char *begin = data;
+    for (size_t i = 0; i < chunks; ++i) {
+        const char *end = file_end;
+        if (i + 1 < chunks) {
+            end = data + view.size / chunks * (i + 1);
+            if (end < begin) end = begin;
+            const char *nl = memchr(end, '\n', (size_t)(file_end - end));
+            end = nl ? nl + 1 : file_end;
+        }
+        parts[i].begin = begin;
+        parts[i].end = end;
+        parts[i].accept = accept;
+        begin = end;
+    }
+
+    size_t started = 0;
+    for (; started < chunks; ++started)
+        if (pthread_create(&tids[started], NULL, chunk_thread, &parts[started]) != 0) break;
+    // 建不了執行緒的段在本執行緒解析
+    for (size_t i = started; i < chunks; ++i) chunk_thread(&parts[i]);
+    for (size_t i = 0; i < started; ++i) pthread_join(tids[i], NULL);
+
+    int ok = 1;
+    for (size_t i = 0; i < chunks; ++i) {
+        if (parts[i].error) ok = 0;
+        list->pubkey_count += parts[i].pubkey_count;
+        list->h160_count += parts[i].h160_count;
+    }
+    if (ok && list->pubkey_count) ok = (list->pubkeys = malloc(list->pubkey_count * 33)) != NULL;
+    if (ok && list->h160_count) ok = (list->h160 = malloc(list->h160_count * 20)) != NULL;
+
+    size_t pubkey_pos = 0, h160_pos = 0;
+    for (size_t i = 0; i < chunks; ++i) {
+        KeyChunk *c = &parts[i];
+        if (ok) {
+            if (c->pubkey_count) memcpy(list->pubkeys + pubkey_pos * 33, c->pubkeys, c->pubkey_count * 33);
+            if (c->h160_count) memcpy(list->h160 + h160_pos * 20, c->h160, c->h160_count * 20);
+            pubkey_pos += c->pubkey_count;
+            h160_pos += c->h160_count;
+        }
+        for (size_t b = 0; b < c->bad_count && b < KEYLIST_BAD_REPORT; ++b)
+            if (list->bad_count + b < KEYLIST_BAD_REPORT)
+                list->bad_lines[list->bad_count + b] = list->line_count + c->bad_lines[b] + 1;
+        list->bad_count += c->bad_count;
+        list->line_count += c->line_count;
+        free(c->pubkeys);
+        free(c->h160);
+    }
+
+    free(parts);
+    free(tids);
+    file_view_close(&view);
+    if (!ok) keylist_free(list);
+    return ok;
+}
+
+void keylist_free(KeyList *list) {
+    free(list->pubkeys);
+    free(list->h160);
+    list->pubkeys = NULL;
+    list->h160 = NULL;
+    list->pubkey_count = list->h160_count = 0;
+}
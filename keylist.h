@@ -0,0 +1,64 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* keylist.h — 公鑰 / hash160 / 地址列表的並行加載
+ *
+ * 文件 mmap 後按換行切成若干段，每段一個執行緒解析。每行取第一個空白之前的字段並自動識別：
+ *   66 個十六進制字符 (02/03)   壓縮公鑰
+ *   130 個十六進制字符 (04)     未壓縮公鑰，按 y 的奇偶轉為壓縮形式
+ *   40 個十六進制字符           hash160
+ *   Base58Check，21 字節 payload  地址，取版本字節之後的 hash160
+ * 因此克隆器的 -v 輸出（"<key> = + 0x80"）也可以直接作為輸入。
+ * 空行與 '#' 開頭的行跳過；無法識別的行計為壞行並記錄行號，不中斷加載。
+ * 結果按文件中的順序排列。
+ */
+#ifndef KEYLIST_H
+#define KEYLIST_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// keylist_load 的 accept：接受的條目種類，其他種類的行計為壞行
+enum {
+    KEYLIST_PUBKEY = 1 << 0,
+    KEYLIST_H160   = 1 << 1     // hash160 與地址
+};
+
+// 記錄行號的壞行個數上限，bad_count 仍統計全部
+#define KEYLIST_BAD_REPORT 16
+
+typedef struct {
+    unsigned char *pubkeys;     // pubkey_count x 33
+    size_t pubkey_count;
+    unsigned char *h160;        // h160_count x 20
+    size_t h160_count;
+    size_t line_count;
+    size_t bad_count;
+    size_t bad_lines[KEYLIST_BAD_REPORT];   // 前幾個壞行的行號，從 1 起
+} KeyList;
+
+// 用 threads 個執行緒加載 path；打不開文件或內存不足時返回 0
+int  keylist_load(KeyList *list, const char *path, int threads, unsigned accept);
+void keylist_free(KeyList *list);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYLIST_H */
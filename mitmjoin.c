@@ -0,0 +1,268 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* mitmjoin.c
+ * https://github.com/8891689
+ * 分區取指紋的最高位，表內位置取最低位，兩者互不相關，各分區的表一樣均勻。
+ * 溢出模式下各執行緒的緩衝寫滿後在分區鎖內整塊 fwrite，分區文件內的順序無意義。
+ */
+#include "mitmjoin.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// relation 取這個值的槽是空槽
+#define JOIN_EMPTY 0xffffffffu
+// 讀分區文件時每次讀入的記錄數
+#define JOIN_READ_CHUNK 4096
+
+typedef struct {
+    JoinEntry *items;
+    size_t len;
+    size_t cap;
+} JoinBuffer;
+
+struct JoinSide {
+    int threads;
+    int partitions;
+    int shift;                  // 分區 = fp >> shift
+    JoinBuffer *buffers;        // [thread * partitions + p]
+    FILE **files;               // 內存模式為 NULL
+    char **paths;
+    pthread_mutex_t *locks;
+    uint64_t *counts;           // 每個分區已寫入文件的記錄數
+    int opened;                 // 已打開的分區文件數
+    volatile int failed;
+};
+
+static int partition_of(const JoinSide *s, uint64_t fp) {
+    return s->partitions == 1 ? 0 : (int)(fp >> s->shift);
+}
+
+JoinSide *join_side_create(int threads, int partitions, const char *spill_prefix) {
+    if (threads <= 0 || partitions <= 0 || partitions > JOIN_MAX_PARTITIONS || (partitions & (partitions - 1))) return NULL;
+    if (partitions > 1 && !spill_prefix) return NULL;
+    JoinSide *s = calloc(1, sizeof(JoinSide));
+    if (!s) return NULL;
+    s->threads = threads;
+    s->partitions = partitions;
+    int bits = 0;
+    while ((1 << bits) < partitions) bits++;
+    s->shift = 64 - bits;
+    s->buffers = calloc((size_t)threads * partitions, sizeof(JoinBuffer));
+    if (!s->buffers) {
+        free(s);
+        return NULL;
+    }
+    if (!spill_prefix) return s;
+
+    s->files = calloc(partitions, sizeof(FILE *));
+    s->paths = calloc(partitions, sizeof(char *));
+    s->locks = malloc(partitions * sizeof(pthread_mutex_t));
+    s->counts = calloc(partitions, sizeof(uint64_t));
+    int ok = s->files && s->paths && s->locks && s->counts;
+    for (int t = 0; ok && t < threads * partitions; ++t) {
+        s->buffers[t].items = malloc(JOIN_SPILL_BATCH * sizeof(JoinEntry));
+        s->buffers[t].cap = JOIN_SPILL_BATCH;
+        ok = s->buffers[t].items != NULL;
+    }
+    for (int p = 0; ok && p < partitions; ++p) {
+        size_t len = strlen(spill_prefix) + 16;
+        s->paths[p] = malloc(len);
+        if (!s->paths[p]) ok = 0;
+        else snprintf(s->paths[p], len, "%s.%d", spill_prefix, p);
+        if (ok && !(s->files[p] = fopen(s->paths[p], "w+b"))) ok = 0;
+        if (ok) pthread_mutex_init(&s->locks[p], NULL);
+        if (ok) s->opened++;
+    }
+    if (!ok) {
+        join_side_destroy(s);
+        return NULL;
+    }
+    return s;
+}
+
+static int spill_flush(JoinSide *s, int p, JoinBuffer *b) {
+    if (b->len == 0) return 1;
+    pthread_mutex_lock(&s->locks[p]);
+    int ok = fwrite(b->items, sizeof(JoinEntry), b->len, s->files[p]) == b->len;
+    s->counts[p] += b->len;
+    pthread_mutex_unlock(&s->locks[p]);
+    b->len = 0;
+    if (!ok) s->failed = 1;
+    return ok;
+}
+
+int join_side_add(JoinSide *s, int thread_id, const JoinEntry *e) {
+    if (s->failed) return 0;
+    int p = partition_of(s, e->fp);
+    JoinBuffer *b = &s->buffers[thread_id * s->partitions + p];
+    if (!s->files && b->len == b->cap) {
+        size_t cap = b->cap ? b->cap * 2 : JOIN_READ_CHUNK;
+        JoinEntry *items = realloc(b->items, cap * sizeof(JoinEntry));
+        if (!items) {
+            s->failed = 1;
+            return 0;
+        }
+        b->items = items;
+        b->cap = cap;
+    }
+    b->items[b->len++] = *e;
+    return !s->files || b->len < b->cap || spill_flush(s, p, b);
+}
+
+int join_side_finish(JoinSide *s) {
+    if (s->files) {
+        for (int t = 0; t < s->threads; ++t)
+            for (int p = 0; p < s->partitions; ++p) spill_flush(s, p, &s->buffers[t * s->partitions + p]);
+        for (int p = 0; p < s->partitions; ++p)
+            if (fflush(s->files[p]) != 0) s->failed = 1;
+    }
+    return !s->failed;
+}
+
+uint64_t join_side_count(const JoinSide *s) {
+    uint64_t total = 0;
+    if (s->files) {
+        for (int p = 0; p < s->partitions; ++p) total += s->counts[p];
+    } else {
+        for (int t = 0; t < s->threads; ++t) total += s->buffers[t].len;
+    }
+    return total;
+}
+
+int join_side_partitions(const JoinSide *s) {
+    return s->partitions;
+}
+
+int join_side_scan(JoinSide *s, int p, int (*fn)(const JoinEntry *e, void *user), void *user) {
+    if (!s->files) {
+        for (int t = 0; t < s->threads; ++t) {
+            const JoinBuffer *b = &s->buffers[t * s->partitions + p];
+            for (size_t i = 0; i < b->len; ++i)
+                if (fn(&b->items[i], user)) return 1;
+        }
+        return 1;
+    }
+    JoinEntry *chunk = malloc(JOIN_READ_CHUNK * sizeof(JoinEntry));
+    if (!chunk || fseek(s->files[p], 0, SEEK_SET) != 0) {
+        free(chunk);
+        return 0;
+    }
+    uint64_t left = s->counts[p];
+    int ok = 1;
+    while (left > 0) {
+        size_t want = left < JOIN_READ_CHUNK ? (size_t)left : JOIN_READ_CHUNK;
+        if (fread(chunk, sizeof(JoinEntry), want, s->files[p]) != want) {
+            ok = 0;
+            break;
+        }
+        left -= want;
+        size_t i = 0;
+        while (i < want && !fn(&chunk[i], user)) i++;
+        if (i < want) break;
+    }
+    free(chunk);
+    return ok;
+}
+
+void join_side_destroy(JoinSide *s) {
+    if (!s) return;
+    for (int t = 0; s->buffers && t < s->threads * s->partitions; ++t) free(s->buffers[t].items);
+    free(s->buffers);
+    if (s->files) {
+        for (int p = 0; p < s->opened; ++p) {
+            fclose(s->files[p]);
+            remove(s->paths[p]);
+            pthread_mutex_destroy(&s->locks[p]);
+        }
+    }
+    for (int p = 0; s->paths && p < s->partitions; ++p) free(s->paths[p]);
+    free(s->files);
+    free(s->paths);
+    free(s->locks);
+    free(s->counts);
+    free(s);
+}
+
+static void table_insert(JoinTable *t, const JoinEntry *e) {
+    uint64_t i = e->fp & t->mask;
+    while (t->slots[i].relation != JOIN_EMPTY) i = (i + 1) & t->mask;
+    t->slots[i] = *e;
+}
+
+static int table_insert_fn(const JoinEntry *e, void *user) {
+    table_insert((JoinTable *)user, e);
+    return 0;
+}
+
+int join_table_build(JoinTable *t, JoinSide *s, int p) {
+    uint64_t count = 0;
+    if (s->files) count = s->counts[p];
+    else
+        for (int t_id = 0; t_id < s->threads; ++t_id) count += s->buffers[t_id * s->partitions + p].len;
+    uint64_t slots = 1;
+    while (slots * 3 < count * 4 + 4) slots <<= 1;
+    t->mask = slots - 1;
+    t->slots = malloc(slots * sizeof(JoinEntry));
+    if (!t->slots) return 0;
+    for (uint64_t i = 0; i < slots; ++i) t->slots[i].relation = JOIN_EMPTY;
+    if (s->files) {
+        if (join_side_scan(s, p, table_insert_fn, t)) return 1;
+        join_table_free(t);
+        return 0;
+    }
+    for (int t_id = 0; t_id < s->threads; ++t_id) {
+        JoinBuffer *b = &s->buffers[t_id * s->partitions + p];
+        for (size_t i = 0; i < b->len; ++i) table_insert(t, &b->items[i]);
+        free(b->items);
+        b->items = NULL;
+        b->len = b->cap = 0;
+    }
+    return 1;
+}
+
+int join_table_probe(const JoinTable *t, const JoinEntry *e, JoinMatchList *out) {
+    for (uint64_t i = e->fp & t->mask; t->slots[i].relation != JOIN_EMPTY; i = (i + 1) & t->mask)
+        if (t->slots[i].fp == e->fp && !join_match_push(out, &t->slots[i], e)) return 0;
+    return 1;
+}
+
+void join_table_free(JoinTable *t) {
+    free(t->slots);
+    t->slots = NULL;
+}
+
+int join_match_push(JoinMatchList *l, const JoinEntry *a, const JoinEntry *b) {
+    if (l->count == l->cap) {
+        size_t cap = l->cap ? l->cap * 2 : 16;
+        JoinMatch *items = realloc(l->items, cap * sizeof(JoinMatch));
+        if (!items) return 0;
+        l->items = items;
+        l->cap = cap;
+    }
+    l->items[l->count].a = *a;
+    l->items[l->count].b = *b;
+    l->count++;
+    return 1;
+}
+
+void join_match_free(JoinMatchList *l) {
+    free(l->items);
+    l->items = NULL;
+    l->count = l->cap = 0;
+}
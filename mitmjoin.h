@@ -0,0 +1,104 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* mitmjoin.h — 兩個克隆集合按 x 座標求交（中間相遇）
+ *
+ * 集合 A 的每條記錄存成 24 字節的 JoinEntry：x 的低 64 位作指紋，再加 k 的低 64 位、
+ * 基準公鑰下標與 relation。A 放得進內存時建一張開放定址表，集合 B 在生成它的執行緒裏
+ * 直接查表；放不下時 A、B 都按指紋高位分成若干分區寫到臨時文件，之後逐個分區建表、
+ * 流式掃描 B 的同一分區（分區哈希連接），每次只有一個分區的表在內存中。
+ * 指紋相同只是候選，調用方應重新計算兩邊的點並比較完整的 x。
+ *
+ *   JoinSide *a = join_side_create(threads, 1, NULL);
+ *   join_side_add(a, thread_id, &entry);          // 在各執行緒中
+ *   join_side_finish(a);
+ *   JoinTable t;
+ *   join_table_build(&t, a, 0);
+ *   join_table_probe(&t, &b_entry, &matches);      // 只讀，可多執行緒
+ */
+#ifndef MITMJOIN_H
+#define MITMJOIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 分區文件的上限：A、B 兩邊的分區文件同時打開
+#define JOIN_MAX_PARTITIONS 256
+// 建表時負載不超過 3/4，槽數取 2 的冪：每條記錄 32 ~ 64 字節
+#define JOIN_TABLE_BYTES_PER_ENTRY 64
+// 溢出模式下每個執行緒、每個分區先攢這麼多條再寫文件
+#define JOIN_SPILL_BATCH 256
+
+typedef struct {
+    uint64_t fp;            // x 座標的低 64 位
+    uint64_t scalar;        // k 的低 64 位
+    uint32_t base;          // 基準公鑰下標
+    uint32_t relation;      // CLONE_REL_*
+} JoinEntry;
+
+typedef struct {
+    JoinEntry a;
+    JoinEntry b;
+} JoinMatch;
+
+typedef struct {
+    JoinMatch *items;
+    size_t count;
+    size_t cap;
+} JoinMatchList;
+
+typedef struct JoinSide JoinSide;
+
+typedef struct {
+    JoinEntry *slots;
+    uint64_t mask;          // 槽數 - 1
+} JoinTable;
+
+/* 一邊的記錄。partitions 為 1 且 spill_prefix 為 NULL 時全部留在內存；
+ * 否則 partitions（2 的冪，不超過 JOIN_MAX_PARTITIONS）個分區寫到 spill_prefix.<N>，
+ * 銷毀時刪除。threads 為會調用 join_side_add 的執行緒數。
+ */
+JoinSide *join_side_create(int threads, int partitions, const char *spill_prefix);
+// 同一 thread_id 不能並發；內存不足或寫文件失敗返回 0，之後的調用都失敗
+int  join_side_add(JoinSide *s, int thread_id, const JoinEntry *e);
+// 所有執行緒結束後調用一次，沖出緩衝；失敗返回 0
+int  join_side_finish(JoinSide *s);
+uint64_t join_side_count(const JoinSide *s);
+int  join_side_partitions(const JoinSide *s);
+// 依次對分區 p 的每條記錄調用 fn，fn 返回非 0 時停止；讀文件失敗返回 0
+int  join_side_scan(JoinSide *s, int p, int (*fn)(const JoinEntry *e, void *user), void *user);
+void join_side_destroy(JoinSide *s);
+
+/* 用分區 p 的記錄建表。內存模式下建表的同時釋放該分區的記錄，
+ * 所以每個分區只能建一次表。內存不足或讀文件失敗返回 0。
+ */
+int  join_table_build(JoinTable *t, JoinSide *s, int p);
+// 表中指紋與 e 相同的記錄各追加一條 (表中記錄, e)，內存不足返回 0
+int  join_table_probe(const JoinTable *t, const JoinEntry *e, JoinMatchList *out);
+void join_table_free(JoinTable *t);
+
+int  join_match_push(JoinMatchList *l, const JoinEntry *a, const JoinEntry *b);
+void join_match_free(JoinMatchList *l);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MITMJOIN_H */
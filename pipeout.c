@@ -0,0 +1,118 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* pipeout.c
+ * https://github.com/8891689
+ * 管道中尚未讀的字節數用 FIONREAD 取得；管道按先進先出讀取，所以
+ * 已交出的總數減去它就是讀端已經取走的前綴長度。
+ */
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+#include "pipeout.h"
+#include <stdlib.h>
+#include <errno.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#endif
+
+int pipe_out_init(PipeOut *p, int fd) {
+    p->fd = fd;
+    p->spliced = 0;
+    p->broken = 0;
+    p->written = 0;
+#ifdef __linux__
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || !S_ISFIFO(st.st_mode)) return 0;
+    // 超過 /proc/sys/fs/pipe-max-size 時失敗，保持原大小即可
+    fcntl(fd, F_SETPIPE_SZ, PIPE_OUT_PIPE_SIZE);
+    p->spliced = 1;
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+int pipe_out_write(PipeOut *p, const void *data, size_t len) {
+#ifdef __linux__
+    const char *ptr = (const char *)data;
+    while (len > 0 && !p->broken) {
+        ssize_t n;
+        if (p->spliced) {
+            struct iovec iov = { (void *)ptr, len };
+            n = vmsplice(p->fd, &iov, 1, 0);
+            // 內核不支持或 fd 不接受 vmsplice：改用 write，已交出的頁照常按偏移回收
+            if (n < 0 && (errno == EINVAL || errno == ENOSYS || errno == EBADF)) {
+                p->spliced = 0;
+                continue;
+            }
+        } else {
+            n = write(p->fd, ptr, len);
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            p->broken = 1;
+            break;
+        }
+        ptr += n;
+        len -= (size_t)n;
+        p->written += (uint64_t)n;
+    }
+    return !p->broken;
+#else
+    (void)p; (void)data; (void)len;
+    return 0;
+#endif
+}
+
+uint64_t pipe_out_consumed(const PipeOut *p) {
+#ifdef __linux__
+    int unread = 0;
+    // 讀端提前退出時管道裏的數據永遠不會被取走，不能再按偏移等待；下一次寫出照常得到 SIGPIPE / EPIPE
+    struct pollfd pfd = { p->fd, 0, 0 };
+    if (p->broken || (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLERR))) return p->written;
+    if (ioctl(p->fd, FIONREAD, &unread) != 0 || unread < 0) return p->written;
+    return (uint64_t)unread > p->written ? 0 : p->written - (uint64_t)unread;
+#else
+    return p->written;
+#endif
+}
+
+void *pipe_out_alloc(size_t size) {
+#ifdef __linux__
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return ptr == MAP_FAILED ? NULL : ptr;
+#else
+    return malloc(size);
+#endif
+}
+
+void pipe_out_free(void *ptr, size_t size) {
+    if (!ptr) return;
+#ifdef __linux__
+    munmap(ptr, size);
+#else
+    (void)size;
+    free(ptr);
+#endif
+}
@@ -0,0 +1,59 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* pipeout.h — 管道輸出：vmsplice 把緩衝的頁直接掛進管道，省去 stdio 與 write() 的拷貝
+ *
+ * 頁掛進管道後，讀端取走之前緩衝不能改寫。pipe_out_consumed 給出讀端已取走的字節數
+ * （已交出的字節數減去管道中尚未讀的字節數），調用者按交出時的偏移回收緩衝。
+ * 緩衝用 pipe_out_alloc 分配（整頁對齊的匿名映射）；pipe_out_free 即使在頁還留在管道中時
+ * 也是安全的，內核持有頁的引用，內容不會再變。
+ * 非 Linux、vmsplice 不可用或出錯時退化為 write()，調用方式不變。
+ */
+#ifndef PIPEOUT_H
+#define PIPEOUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 嘗試把管道容量設為這麼大，減少讀寫兩端的喚醒次數
+#define PIPE_OUT_PIPE_SIZE (1 << 20)
+
+typedef struct {
+    int fd;
+    int spliced;            // 0：已退化為 write()
+    int broken;             // 寫出失敗（讀端已關閉），之後的數據丟棄
+    uint64_t written;       // 已交出的字節數
+} PipeOut;
+
+// fd 是管道時初始化並返回 1；否則返回 0，應使用普通輸出
+int  pipe_out_init(PipeOut *p, int fd);
+// 全部交出返回 1；寫出失敗返回 0，此後 broken 置位
+int  pipe_out_write(PipeOut *p, const void *data, size_t len);
+// 讀端已取走的字節數；broken 或讀端已關閉時等於 written
+uint64_t pipe_out_consumed(const PipeOut *p);
+
+void *pipe_out_alloc(size_t size);
+void  pipe_out_free(void *ptr, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PIPEOUT_H */
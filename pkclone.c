@@ -0,0 +1,1020 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* pkclone.c — 公鑰克隆引擎
+ * 隨機模式每個 k 做一次 tweak_add；增量模式與其他點族用 ecbatch 的多通道批量步進。
+ *
+ * 流水線：EC 執行緒 --(SPSC 環)--> 哈希執行緒（序列化、hash160、調用回調）
+ * 每個 EC 執行緒有 PKC_RING_SLOTS 個批次緩衝，經 full 環交給哈希階段，用完從 empty 環還回，
+ * 緩衝本身不複製。下游慢時 empty 環取不到緩衝，EC 執行緒就地等待。
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <secp256k1.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#define getpid GetCurrentProcessId
+#else
+#include <unistd.h>
+#endif
+
+#include "pkclone.h"
+#include "spsc.h"
+#include "sha256.h"
+#include "ripemd160.h"
+
+#define SHA256_DIGEST_SIZE 32
+#define HASH160_SIZE 20
+// 增量模式每個執行緒同時推進的通道數（共用一次求逆）
+#define WALK_BATCH 256
+#define PKC_DEFAULT_BATCH 1024
+// 每個 EC 執行緒在流水線中循環使用的批次緩衝數
+#define PKC_RING_SLOTS 4
+
+static const char *SECP256K1_N_HEX = "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141";
+// λ：n 的三次單位根，與 ecbatch.c 的 β 配對，λ·(x, y) = (β·x, y)
+static const char *SECP256K1_LAMBDA_HEX = "5363AD4CC05C30E0A5261C028812645A122E22EA20816678DF02967C1B23BD72";
+
+struct PkcContext {
+    secp256k1_context *secp;
+    secp256k1_pubkey *bases;
+    int base_count;
+    int base_cap;
+    mpz_t n;
+};
+
+// 每個執行緒自己的批次緩衝
+typedef struct {
+    PkcBatch view;
+    size_t cap;
+    AffinePoint *points;
+    unsigned char *pubkeys;
+    unsigned char *pubkeys_u;
+    unsigned char *h160;
+    unsigned char *h160_u;
+    uint8_t *relations;
+    unsigned char *scalars;
+} BatchBuffer;
+
+// EC 階段
+typedef struct {
+    int thread_id;
+    int thread_count;
+    long long start_count;
+    long long end_count;
+    PkcContext *ctx;
+    const PkcParams *params;
+    int *stop;              // 所有執行緒共用，回調要求停止時置 1
+    int error;
+    int base_index;
+    const FeistelPerm *perm;    // permute 時所有執行緒共用
+    BatchBuffer *batch;     // 正在填充的緩衝
+    BatchBuffer slots[PKC_RING_SLOTS];
+    SpscRing full;          // 填滿的緩衝 → 哈希階段
+    SpscRing empty;         // 哈希階段用完 → 還回
+    gmp_randstate_t randstate;
+} PkcWorker;
+
+// 哈希階段：消費 thread_id, thread_id + H, ... 號 EC 執行緒的 full 環
+typedef struct {
+    int thread_id;
+    const PkcParams *params;
+    PkcBatchFn fn;
+    void *user;
+    int *stop;
+    SpscRing **rings;
+    PkcWorker **producers;  // 與 rings 同下標
+    int ring_count;
+} HashWorker;
+
+void pkc_hash160(const unsigned char *data, size_t len, unsigned char *out20) {
+    unsigned char sha256_hash[SHA256_DIGEST_SIZE];
+    sha256(data, len, sha256_hash);
+    ripemd160(sha256_hash, SHA256_DIGEST_SIZE, out20);
+}
+
+void pkc_params_init(PkcParams *params) {
+    params->count = 1;
+    params->threads = 1;
+    params->hash_threads = 0;
+    params->random_mode = false;
+    params->permute = false;
+    memset(params->perm_key, 0, sizeof(params->perm_key));
+    params->endo = false;
+    params->forms = PKC_FORM_PUBKEY;
+    params->batch_size = 0;
+    params->seed = 0;
+    params->pin = TOPO_PIN_NONE;
+    params->family = PKC_FAMILY_SHIFT;
+    params->div_min = 2;
+    params->div_max = 2;
+    params->div_iterations = 1;
+    params->mul_inverse = false;
+    params->h160_predicate = NULL;
+    params->predicate_user = NULL;
+    mpz_inits(params->min_scalar, params->max_scalar, params->step, params->perm_start, NULL);
+    mpz_set_ui(params->min_scalar, 1);
+    mpz_set_str(params->max_scalar, SECP256K1_N_HEX, 16);
+    mpz_sub_ui(params->max_scalar, params->max_scalar, 1);
+    mpz_set_ui(params->step, 1);
+}
+
+void pkc_params_clear(PkcParams *params) {
+    mpz_clears(params->min_scalar, params->max_scalar, params->step, params->perm_start, NULL);
+}
+
+// pkc_warm 建好的上下文模板，之後的 pkc_create 只需複製
+static secp256k1_context *pkc_secp_template;
+
+void pkc_warm(void) {
+    if (!pkc_secp_template)
+        pkc_secp_template = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
+    ec_get_backend();
+    topo_cpu_count();
+}
+
+PkcContext *pkc_create(void) {
+    PkcContext *ctx = calloc(1, sizeof(PkcContext));
+    if (!ctx) return NULL;
+    ctx->secp = pkc_secp_template ? secp256k1_context_clone(pkc_secp_template)
+                                  : secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
+    if (!ctx->secp) { free(ctx); return NULL; }
+    mpz_init_set_str(ctx->n, SECP256K1_N_HEX, 16);
+    return ctx;
+}
+
+void pkc_destroy(PkcContext *ctx) {
+    if (!ctx) return;
+    secp256k1_context_destroy(ctx->secp);
+    mpz_clear(ctx->n);
+    free(ctx->bases);
+    free(ctx);
+}
+
+int pkc_add_base(PkcContext *ctx, const unsigned char *pubkey, size_t len) {
+    secp256k1_pubkey parsed;
+    if (!secp256k1_ec_pubkey_parse(ctx->secp, &parsed, pubkey, len)) return -1;
+    if (ctx->base_count == ctx->base_cap) {
+        int cap = ctx->base_cap ? ctx->base_cap * 2 : 4;
+        secp256k1_pubkey *grown = realloc(ctx->bases, cap * sizeof(secp256k1_pubkey));
+        if (!grown) return -1;
+        ctx->bases = grown;
+        ctx->base_cap = cap;
+    }
+    ctx->bases[ctx->base_count] = parsed;
+    return ctx->base_count++;
+}
+
+int pkc_base_count(const PkcContext *ctx) {
+    return ctx->base_count;
+}
+
+int pkc_base_point(const PkcContext *ctx, int index, AffinePoint *out) {
+    if (index < 0 || index >= ctx->base_count) return 0;
+    unsigned char uncompressed[65];
+    size_t len = sizeof(uncompressed);
+    secp256k1_ec_pubkey_serialize(ctx->secp, uncompressed, &len, &ctx->bases[index], SECP256K1_EC_UNCOMPRESSED);
+    return ec_point_from_uncompressed(out, uncompressed);
+}
+
+static bool mpz_to_scalar32(mpz_srcptr scalar_mpz, mpz_srcptr n, unsigned char *scalar_bytes) {
+    mpz_t temp_scalar;
+    mpz_init(temp_scalar);
+    mpz_mod(temp_scalar, scalar_mpz, n);
+    memset(scalar_bytes, 0, 32);
+    size_t needed_bytes;
+    mpz_export(scalar_bytes + 32 - (mpz_sizeinbase(temp_scalar, 256)), &needed_bytes, 1, 1, 1, 0, temp_scalar);
+    mpz_clear(temp_scalar);
+    return needed_bytes <= 32;
+}
+
+// 在 [min, max] 內隨機取 min + i*step
+static bool generate_random_scalar_in_range(mpz_t result, gmp_randstate_t state, mpz_srcptr min, mpz_srcptr max, mpz_srcptr step) {
+    if (mpz_cmp(min, max) > 0) return false;
+
+    mpz_t range_size;
+    mpz_init(range_size);
+    mpz_sub(range_size, max, min);
+    mpz_fdiv_q(range_size, range_size, step);
+    mpz_add_ui(range_size, range_size, 1);
+
+    mpz_urandomm(result, state, range_size);
+    mpz_mul(result, result, step);
+    mpz_add(result, result, min);
+
+    mpz_clear(range_size);
+    return true;
+}
+
+// 標量的低 256 位，32 字節大端
+static void scalar_to_bytes32(mpz_srcptr scalar, unsigned char *out32) {
+    memset(out32, 0, 32);
+    size_t limbs = mpz_size(scalar);
+    for (size_t l = 0; l < limbs && l * sizeof(mp_limb_t) < 32; ++l) {
+        mp_limb_t limb = mpz_getlimbn(scalar, l);
+        for (size_t b = 0; b < sizeof(mp_limb_t) && l * sizeof(mp_limb_t) + b < 32; ++b) {
+            out32[31 - (l * sizeof(mp_limb_t) + b)] = (unsigned char)limb;
+            limb >>= 8;
+        }
+    }
+}
+
+static void pubkey_to_point(const secp256k1_context *secp, const secp256k1_pubkey *pk, AffinePoint *out) {
+    unsigned char uncompressed[65];
+    size_t len = sizeof(uncompressed);
+    secp256k1_ec_pubkey_serialize(secp, uncompressed, &len, pk, SECP256K1_EC_UNCOMPRESSED);
+    ec_point_from_uncompressed(out, uncompressed);
+}
+
+// P + tweak*G 轉為仿射點；結果為無窮遠點時 tweak_add 失敗，標記 infinity
+static void tweak_to_point(const secp256k1_context *secp, const secp256k1_pubkey *base, const unsigned char *tweak, AffinePoint *out) {
+    secp256k1_pubkey pk = *base;
+    out->infinity = 1;
+    if (!secp256k1_ec_pubkey_tweak_add(secp, &pk, tweak)) return;
+    pubkey_to_point(secp, &pk, out);
+}
+
+// u·P + v·G；u、v 為 0 (mod n) 時對應項為無窮遠點
+static void combo_to_point(const PkcContext *ctx, const secp256k1_pubkey *base, mpz_srcptr u, mpz_srcptr v, AffinePoint *out) {
+    AffinePoint up, vg;
+    unsigned char scalar_bytes[32];
+    secp256k1_pubkey pk = *base;
+    up.infinity = vg.infinity = 1;
+    if (mpz_to_scalar32(u, ctx->n, scalar_bytes) && secp256k1_ec_pubkey_tweak_mul(ctx->secp, &pk, scalar_bytes))
+        pubkey_to_point(ctx->secp, &pk, &up);
+    if (mpz_to_scalar32(v, ctx->n, scalar_bytes) && secp256k1_ec_pubkey_create(ctx->secp, &pk, scalar_bytes))
+        pubkey_to_point(ctx->secp, &pk, &vg);
+    ec_point_add(out, &up, &vg);
+}
+
+int pkc_record_point(const PkcContext *ctx, int base_index, int relation, const unsigned char *scalar32, AffinePoint *out) {
+    if (base_index < 0 || base_index >= ctx->base_count || relation < CLONE_REL_PLUS || relation > CLONE_REL_LAMBDA2_MINUS)
+        return 0;
+    // 偶數為 P + kG、奇數為 P − kG，relation / 2 是再乘 λ 的次數
+    mpz_t k;
+    unsigned char tweak[32];
+    mpz_init(k);
+    mpz_import(k, 32, 1, 1, 1, 0, scalar32);
+    if (relation & 1) mpz_neg(k, k);
+    mpz_to_scalar32(k, ctx->n, tweak);
+    mpz_clear(k);
+    tweak_to_point(ctx->secp, &ctx->bases[base_index], tweak, out);
+    for (int e = relation / 2; e > 0 && !out->infinity; --e) ec_point_endo(out, out);
+    return !out->infinity;
+}
+
+int pkc_record_relation(const PkcContext *ctx, int relation, const unsigned char *scalar32, mpz_ptr a, mpz_ptr b) {
+    mpz_t k, field;
+    mpz_inits(k, field, NULL);
+    mpz_import(k, 32, 1, 1, 1, 0, scalar32);
+    mpz_set_ui(b, 0);
+    bool ok = true;
+    if (relation >= CLONE_REL_PLUS && relation <= CLONE_REL_LAMBDA2_MINUS) {
+        mpz_set_ui(a, 1);
+        mpz_set_str(field, SECP256K1_LAMBDA_HEX, 16);
+        for (int e = relation / 2; e > 0; --e) mpz_mul(a, a, field);
+        mpz_mul(b, a, k);
+        if (relation & 1) mpz_neg(b, b);
+    } else if (relation == CLONE_REL_FISSION && mpz_sgn(k) > 0) {
+        // 最高位是深度 d，其餘是 j
+        mp_bitcnt_t depth = mpz_sizeinbase(k, 2) - 1;
+        mpz_clrbit(k, depth);
+        mpz_set_ui(a, 0);
+        mpz_setbit(a, depth);
+        ok = mpz_invert(a, a, ctx->n) != 0;
+        mpz_mul(b, a, k);
+        mpz_neg(b, b);
+    } else if (relation == CLONE_REL_GRID) {
+        mpz_fdiv_q_2exp(field, k, PKC_GRID_D_SHIFT);
+        unsigned long t = mpz_get_ui(field) >> (PKC_GRID_T_SHIFT - PKC_GRID_D_SHIFT);
+        mpz_fdiv_r_2exp(field, field, PKC_GRID_T_SHIFT - PKC_GRID_D_SHIFT);
+        ok = t > 0 && mpz_invert(field, field, ctx->n) != 0;
+        mpz_pow_ui(a, field, t);
+        mpz_fdiv_r_2exp(k, k, PKC_GRID_S_BITS);
+        mpz_mul(b, a, k);
+        mpz_neg(b, b);
+    } else if (relation == CLONE_REL_MUL || relation == CLONE_REL_MUL_INV) {
+        mpz_set(a, k);
+        if (relation == CLONE_REL_MUL_INV) ok = mpz_invert(a, a, ctx->n) != 0;
+    } else {
+        ok = false;
+    }
+    mpz_mod(a, a, ctx->n);
+    mpz_mod(b, b, ctx->n);
+    mpz_clears(k, field, NULL);
+    return ok && mpz_sgn(a) != 0;
+}
+
+int pkc_relation_point(const PkcContext *ctx, int base_index, mpz_srcptr a, mpz_srcptr b, AffinePoint *out) {
+    if (base_index < 0 || base_index >= ctx->base_count) return 0;
+    combo_to_point(ctx, &ctx->bases[base_index], a, b, out);
+    return !out->infinity;
+}
+
+static bool batch_buffer_init(BatchBuffer *b, size_t cap, unsigned forms) {
+    memset(b, 0, sizeof(*b));
+    b->cap = cap;
+    b->points = malloc(cap * sizeof(AffinePoint));
+    b->relations = malloc(cap);
+    b->scalars = malloc(cap * CLONE_SCALAR_SIZE);
+    if (forms & (PKC_FORM_PUBKEY | PKC_FORM_H160)) b->pubkeys = malloc(cap * 33);
+    if (forms & (PKC_FORM_PUBKEY_U | PKC_FORM_H160_U)) b->pubkeys_u = malloc(cap * 65);
+    if (forms & PKC_FORM_H160) b->h160 = malloc(cap * HASH160_SIZE);
+    if (forms & PKC_FORM_H160_U) b->h160_u = malloc(cap * HASH160_SIZE);
+
+    if (!b->points || !b->relations || !b->scalars
+        || ((forms & (PKC_FORM_PUBKEY | PKC_FORM_H160)) && !b->pubkeys)
+        || ((forms & (PKC_FORM_PUBKEY_U | PKC_FORM_H160_U)) && !b->pubkeys_u)
+        || ((forms & PKC_FORM_H160) && !b->h160)
+        || ((forms & PKC_FORM_H160_U) && !b->h160_u)) return false;
+
+    b->view.points = b->points;
+    b->view.pubkeys = b->pubkeys;
+    b->view.pubkeys_u = b->pubkeys_u;
+    b->view.h160 = b->h160;
+    b->view.h160_u = b->h160_u;
+    b->view.relations = b->relations;
+    b->view.scalars = b->scalars;
+    return true;
+}
+
+static void batch_buffer_free(BatchBuffer *b) {
+    free(b->points);
+    free(b->pubkeys);
+    free(b->pubkeys_u);
+    free(b->h160);
+    free(b->h160_u);
+    free(b->relations);
+    free(b->scalars);
+}
+
+static int worker_stopped(const PkcWorker *w) {
+    return __atomic_load_n(w->stop, __ATOMIC_RELAXED);
+}
+
+// 把當前緩衝交給哈希階段，並取回一個空緩衝（下游忙時在此等待）
+static void batch_flush(PkcWorker *w) {
+    BatchBuffer *b = w->batch;
+    if (b->view.count == 0) return;
+    b->view.base_index = w->base_index;
+    spsc_push(&w->full, b);
+    w->batch = spsc_pop(&w->empty);
+}
+
+// 追加一條記錄；只存點、relation 與標量，派生形式由哈希階段整批計算
+static void batch_push(PkcWorker *w, const AffinePoint *pt, int relation, const unsigned char *scalar32) {
+    if (pt->infinity) return;
+    BatchBuffer *b = w->batch;
+    size_t i = b->view.count;
+    b->points[i] = *pt;
+    b->relations[i] = (uint8_t)relation;
+    memcpy(b->scalars + i * CLONE_SCALAR_SIZE, scalar32, CLONE_SCALAR_SIZE);
+    if (++b->view.count == b->cap) batch_flush(w);
+}
+
+// 整批計算派生形式：先序列化全部點，再逐個求 hash160
+static void batch_derive_forms(BatchBuffer *b, unsigned forms) {
+    size_t count = b->view.count;
+    if (b->pubkeys) {
+        for (size_t i = 0; i < count; ++i) ec_point_serialize(b->pubkeys + i * 33, &b->points[i], 1);
+        if (forms & PKC_FORM_H160)
+            for (size_t i = 0; i < count; ++i) pkc_hash160(b->pubkeys + i * 33, 33, b->h160 + i * HASH160_SIZE);
+    }
+    if (b->pubkeys_u) {
+        for (size_t i = 0; i < count; ++i) ec_point_serialize(b->pubkeys_u + i * 65, &b->points[i], 0);
+        if (forms & PKC_FORM_H160_U)
+            for (size_t i = 0; i < count; ++i) pkc_hash160(b->pubkeys_u + i * 65, 65, b->h160_u + i * HASH160_SIZE);
+    }
+}
+
+// 只保留 hash160 滿足謂詞的記錄，原地前移
+static void batch_filter(BatchBuffer *b, const PkcParams *params) {
+    size_t kept = 0;
+    for (size_t i = 0; i < b->view.count; ++i) {
+        if (!(b->h160 && params->h160_predicate(b->h160 + i * HASH160_SIZE, params->predicate_user))
+            && !(b->h160_u && params->h160_predicate(b->h160_u + i * HASH160_SIZE, params->predicate_user))) continue;
+        if (kept != i) {
+            b->points[kept] = b->points[i];
+            b->relations[kept] = b->relations[i];
+            memcpy(b->scalars + kept * CLONE_SCALAR_SIZE, b->scalars + i * CLONE_SCALAR_SIZE, CLONE_SCALAR_SIZE);
+            if (b->pubkeys) memcpy(b->pubkeys + kept * 33, b->pubkeys + i * 33, 33);
+            if (b->pubkeys_u) memcpy(b->pubkeys_u + kept * 65, b->pubkeys_u + i * 65, 65);
+            if (b->h160) memcpy(b->h160 + kept * HASH160_SIZE, b->h160 + i * HASH160_SIZE, HASH160_SIZE);
+            if (b->h160_u) memcpy(b->h160_u + kept * HASH160_SIZE, b->h160_u + i * HASH160_SIZE, HASH160_SIZE);
+        }
+        kept++;
+    }
+    b->view.count = kept;
+}
+
+/* 記錄一個點；endo 時再記錄 λ·Q 與 λ²·Q，relation 為 LAMBDA_* / LAMBDA2_*。
+ * 若 Q = P ± kG 且 λ^e·Q 的私鑰為 m，則 P 的私鑰為 m·λ^(3-e) ∓ k (mod n)。
+ */
+static void push_point_family(PkcWorker *w, const AffinePoint *pt, int relation, const unsigned char *scalar32) {
+    batch_push(w, pt, relation, scalar32);
+    if (!w->params->endo || pt->infinity) return;
+
+    AffinePoint lambda_pt;
+    ec_point_endo(&lambda_pt, pt);
+    batch_push(w, &lambda_pt, relation + CLONE_REL_LAMBDA_PLUS, scalar32);
+    ec_point_endo(&lambda_pt, &lambda_pt);
+    batch_push(w, &lambda_pt, relation + CLONE_REL_LAMBDA2_PLUS, scalar32);
+}
+
+// 隨機模式：每個標量獨立做一次 tweak_add；permute 時按下標取置換後的項，不重複
+static void random_worker(PkcWorker *w, const secp256k1_pubkey *base) {
+    const PkcParams *params = w->params;
+    mpz_t current_scalar_mpz, neg_current_scalar_mpz, index_mpz;
+    mpz_inits(current_scalar_mpz, neg_current_scalar_mpz, index_mpz, NULL);
+    pkc_mpz_set_count(index_mpz, w->start_count);
+    mpz_add(index_mpz, index_mpz, params->perm_start);
+
+    unsigned char scalar_bytes[32];
+    unsigned char neg_scalar_bytes[32];
+    unsigned char record_scalar[CLONE_SCALAR_SIZE];
+
+    for (long long i = w->start_count; i < w->end_count && !worker_stopped(w); ++i) {
+        if (w->perm) {
+            feistel_apply(w->perm, current_scalar_mpz, index_mpz);
+            mpz_add_ui(index_mpz, index_mpz, 1);
+            mpz_mul(current_scalar_mpz, current_scalar_mpz, params->step);
+            mpz_add(current_scalar_mpz, current_scalar_mpz, params->min_scalar);
+        } else if (!generate_random_scalar_in_range(current_scalar_mpz, w->randstate, params->min_scalar, params->max_scalar, params->step))
+            break;
+
+        if (!mpz_to_scalar32(current_scalar_mpz, w->ctx->n, scalar_bytes)) continue;
+        mpz_neg(neg_current_scalar_mpz, current_scalar_mpz);
+        if (!mpz_to_scalar32(neg_current_scalar_mpz, w->ctx->n, neg_scalar_bytes)) continue;
+        scalar_to_bytes32(current_scalar_mpz, record_scalar);
+
+        AffinePoint pt;
+        tweak_to_point(w->ctx->secp, base, scalar_bytes, &pt);
+        push_point_family(w, &pt, CLONE_REL_PLUS, record_scalar);
+        tweak_to_point(w->ctx->secp, base, neg_scalar_bytes, &pt);
+        push_point_family(w, &pt, CLONE_REL_MINUS, record_scalar);
+    }
+
+    mpz_clears(current_scalar_mpz, neg_current_scalar_mpz, index_mpz, NULL);
+}
+
+/* 增量模式：k_i = min + i*step。
+ * 執行緒把自己的區段拆成 lanes 條通道，通道 j 從 P ± k_j·G 出發，
+ * 每輪所有 2*lanes 個點同時加上 ±(lanes*step)·G，共用一次求逆。
+ * 通道按 k 順序記錄，因此單執行緒的記錄順序與逐個計算時完全一致。
+ */
+static void incremental_worker(PkcWorker *w, const secp256k1_pubkey *base) {
+    const PkcParams *params = w->params;
+    long long total = w->end_count - w->start_count;
+    if (total <= 0) return;
+    size_t lanes = total < WALK_BATCH ? (size_t)total : WALK_BATCH;
+
+    AffinePoint *points = malloc(2 * lanes * sizeof(AffinePoint));
+    AffinePoint *deltas = malloc(2 * lanes * sizeof(AffinePoint));
+    FieldElement *scratch = malloc(ec_batch_scratch_len(2 * lanes) * sizeof(FieldElement));
+    if (!points || !deltas || !scratch) {
+        w->error = 1;
+        free(points); free(deltas); free(scratch);
+        return;
+    }
+
+    mpz_t current_scalar_mpz, lane_scalar_mpz;
+    mpz_inits(current_scalar_mpz, lane_scalar_mpz, NULL);
+    unsigned char scalar_bytes[32];
+
+    pkc_mpz_set_count(current_scalar_mpz, w->start_count);
+    mpz_mul(current_scalar_mpz, current_scalar_mpz, params->step);
+    mpz_add(current_scalar_mpz, current_scalar_mpz, params->min_scalar);
+
+    // 各通道起點 P + k_j·G 與 P - k_j·G
+    mpz_set(lane_scalar_mpz, current_scalar_mpz);
+    for (size_t j = 0; j < lanes; ++j) {
+        points[j].infinity = points[lanes + j].infinity = 1;
+        if (mpz_to_scalar32(lane_scalar_mpz, w->ctx->n, scalar_bytes))
+            tweak_to_point(w->ctx->secp, base, scalar_bytes, &points[j]);
+        mpz_neg(lane_scalar_mpz, lane_scalar_mpz);
+        if (mpz_to_scalar32(lane_scalar_mpz, w->ctx->n, scalar_bytes))
+            tweak_to_point(w->ctx->secp, base, scalar_bytes, &points[lanes + j]);
+        mpz_neg(lane_scalar_mpz, lane_scalar_mpz);
+        mpz_add(lane_scalar_mpz, lane_scalar_mpz, params->step);
+    }
+
+    // 每輪步進 D = (lanes*step)·G；D 為 0 (mod n) 時點不動，infinity 正好表達這一點
+    AffinePoint delta;
+    delta.infinity = 1;
+    mpz_mul_ui(lane_scalar_mpz, params->step, lanes);
+    if (mpz_to_scalar32(lane_scalar_mpz, w->ctx->n, scalar_bytes)) {
+        secp256k1_pubkey delta_pubkey;
+        if (secp256k1_ec_pubkey_create(w->ctx->secp, &delta_pubkey, scalar_bytes))
+            pubkey_to_point(w->ctx->secp, &delta_pubkey, &delta);
+    }
+    for (size_t j = 0; j < lanes; ++j) {
+        deltas[j] = delta;
+        ec_point_neg(&deltas[lanes + j], &delta);
+    }
+
+    for (long long base_i = w->start_count; base_i < w->end_count && !worker_stopped(w); base_i += (long long)lanes) {
+        for (size_t j = 0; j < lanes && base_i + (long long)j < w->end_count; ++j) {
+            scalar_to_bytes32(current_scalar_mpz, scalar_bytes);
+            push_point_family(w, &points[j], CLONE_REL_PLUS, scalar_bytes);
+            push_point_family(w, &points[lanes + j], CLONE_REL_MINUS, scalar_bytes);
+            mpz_add(current_scalar_mpz, current_scalar_mpz, params->step);
+        }
+        if (base_i + (long long)lanes < w->end_count)
+            ec_add_batch(points, deltas, 1, 2 * lanes, scratch);
+    }
+
+    mpz_clears(current_scalar_mpz, lane_scalar_mpz, NULL);
+    free(points);
+    free(deltas);
+    free(scratch);
+}
+
+/* 等差點列：第 i 個點為 (u + i·du)·P + (v + i·dv)·G，記錄的標量為 label + i·dlabel。
+ * 相鄰兩點相差常數點 du·P + dv·G，與增量模式一樣用多通道批量加法推進。
+ */
+typedef struct {
+    mpz_t u, du;
+    mpz_t v, dv;
+    mpz_t label, dlabel;
+    long long count;
+    int relation;
+} PkcProgression;
+
+static void progression_init(PkcProgression *prog) {
+    mpz_inits(prog->u, prog->du, prog->v, prog->dv, prog->label, prog->dlabel, NULL);
+    prog->count = 0;
+    prog->relation = 0;
+}
+
+static void progression_clear(PkcProgression *prog) {
+    mpz_clears(prog->u, prog->du, prog->v, prog->dv, prog->label, prog->dlabel, NULL);
+}
+
+// 第 i 個點的係數：out_u = u + i·du，out_v = v + i·dv
+static void progression_coeffs(const PkcProgression *prog, long long i, mpz_t out_u, mpz_t out_v) {
+    pkc_mpz_set_count(out_u, i);
+    mpz_mul(out_v, out_u, prog->dv);
+    mpz_add(out_v, out_v, prog->v);
+    mpz_mul(out_u, out_u, prog->du);
+    mpz_add(out_u, out_u, prog->u);
+}
+
+// 本執行緒負責的下標區間 [start, end)，與 pkc_run 切分 count 的方式相同
+static void progression_slice(const PkcWorker *w, long long count, long long *start, long long *end) {
+    long long per_thread = count / w->thread_count;
+    long long remainder = count % w->thread_count;
+    long long t = w->thread_id;
+    *start = t * per_thread + (t < remainder ? t : remainder);
+    *end = *start + per_thread + (t < remainder ? 1 : 0);
+}
+
+// 推進點列中下標 [start, end) 的部分；通道按下標順序記錄
+static void progression_walk(PkcWorker *w, const secp256k1_pubkey *base, const PkcProgression *prog, long long start, long long end) {
+    long long total = end - start;
+    if (total <= 0) return;
+    size_t lanes = total < WALK_BATCH ? (size_t)total : WALK_BATCH;
+
+    AffinePoint *points = malloc(lanes * sizeof(AffinePoint));
+    FieldElement *scratch = malloc(ec_batch_scratch_len(lanes) * sizeof(FieldElement));
+    if (!points || !scratch) {
+        w->error = 1;
+        free(points); free(scratch);
+        return;
+    }
+
+    mpz_t u, v, label;
+    mpz_inits(u, v, label, NULL);
+    unsigned char scalar_bytes[32];
+
+    // 只對第一個通道做標量乘法，其餘通道按 1, 2, 4, ... 倍步長成段複製後批量相加
+    AffinePoint stride, delta;
+    progression_coeffs(prog, start, u, v);
+    combo_to_point(w->ctx, base, u, v, &points[0]);
+    combo_to_point(w->ctx, base, prog->du, prog->dv, &stride);
+    size_t filled = 1;
+    for (; filled < lanes; filled *= 2) {
+        size_t copies = filled < lanes - filled ? filled : lanes - filled;
+        memcpy(points + filled, points, copies * sizeof(AffinePoint));
+        ec_add_batch(points + filled, &stride, 0, copies, scratch);
+        ec_point_double(&stride, &stride);
+    }
+    // 每輪步進 lanes·(du·P + dv·G)；lanes 為 2 的冪時正好是最後的 stride
+    if (filled == lanes) {
+        delta = stride;
+    } else {
+        mpz_mul_ui(u, prog->du, lanes);
+        mpz_mul_ui(v, prog->dv, lanes);
+        combo_to_point(w->ctx, base, u, v, &delta);
+    }
+
+    pkc_mpz_set_count(label, start);
+    mpz_mul(label, label, prog->dlabel);
+    mpz_add(label, label, prog->label);
+    for (long long base_i = start; base_i < end && !worker_stopped(w); base_i += (long long)lanes) {
+        for (size_t j = 0; j < lanes && base_i + (long long)j < end; ++j) {
+            scalar_to_bytes32(label, scalar_bytes);
+            batch_push(w, &points[j], prog->relation, scalar_bytes);
+            mpz_add(label, label, prog->dlabel);
+        }
+        if (base_i + (long long)lanes < end)
+            ec_add_batch(points, &delta, 0, lanes, scratch);
+    }
+
+    mpz_clears(u, v, label, NULL);
+    free(points);
+    free(scratch);
+}
+
+/* 分裂樹：第 d 層為 (P − j·G)·2⁻ᵈ，j ∈ [0, 2ᵈ)，即 u = 2⁻ᵈ、dv = −2⁻ᵈ 的點列。
+ * 每層一次標量乘法定起點，其餘全是批量加法；內存與深度無關，不需要逐層保存節點。
+ */
+static void fission_worker(PkcWorker *w, const secp256k1_pubkey *base) {
+    PkcProgression prog;
+    progression_init(&prog);
+    mpz_t half;
+    mpz_init(half);
+    // 2⁻¹ = (n + 1) / 2
+    mpz_add_ui(half, w->ctx->n, 1);
+    mpz_fdiv_q_2exp(half, half, 1);
+
+    mpz_set_ui(prog.u, 1);
+    prog.relation = CLONE_REL_FISSION;
+    mpz_set_ui(prog.dlabel, 1);
+    for (long long depth = 1; depth <= w->params->count && !w->error && !worker_stopped(w); ++depth) {
+        mpz_mul(prog.u, prog.u, half);
+        mpz_mod(prog.u, prog.u, w->ctx->n);
+        mpz_neg(prog.dv, prog.u);
+        mpz_set_ui(prog.label, 0);
+        mpz_setbit(prog.label, (mp_bitcnt_t)depth);
+        prog.count = 1LL << depth;
+
+        long long start, end;
+        progression_slice(w, prog.count, &start, &end);
+        progression_walk(w, base, &prog, start, end);
+    }
+
+    mpz_clear(half);
+    progression_clear(&prog);
+}
+
+/* 先減後除網格：每個 (d, t) 一條點列，u = d⁻ᵗ，v = −min·d⁻ᵗ，dv = −step·d⁻ᵗ。
+ * 每條點列兩次標量乘法（起點與步長），與 s 的個數無關。
+ */
+static void grid_worker(PkcWorker *w, const secp256k1_pubkey *base) {
+    const PkcParams *params = w->params;
+    PkcProgression prog;
+    progression_init(&prog);
+    mpz_t inv_d, field;
+    mpz_inits(inv_d, field, NULL);
+
+    prog.relation = CLONE_REL_GRID;
+    prog.count = params->count;
+    mpz_set(prog.dlabel, params->step);
+    long long start, end;
+    progression_slice(w, prog.count, &start, &end);
+    for (uint64_t d = params->div_min; d <= params->div_max && !w->error && !worker_stopped(w); ++d) {
+        mpz_set_ui(inv_d, (unsigned long)d);
+        if (!mpz_invert(inv_d, inv_d, w->ctx->n)) continue;
+        mpz_set_ui(prog.u, 1);
+        for (int t = 1; t <= params->div_iterations && !w->error && !worker_stopped(w); ++t) {
+            mpz_mul(prog.u, prog.u, inv_d);
+            mpz_mod(prog.u, prog.u, w->ctx->n);
+            mpz_mul(prog.v, params->min_scalar, prog.u);
+            mpz_neg(prog.v, prog.v);
+            mpz_mul(prog.dv, params->step, prog.u);
+            mpz_neg(prog.dv, prog.dv);
+
+            // label = t·2²⁴⁸ + d·2²¹⁶ + (min mod 2²¹⁶)
+            mpz_fdiv_r_2exp(prog.label, params->min_scalar, PKC_GRID_S_BITS);
+            mpz_set_ui(field, (unsigned long)d);
+            mpz_mul_2exp(field, field, PKC_GRID_D_SHIFT);
+            mpz_add(prog.label, prog.label, field);
+            mpz_set_ui(field, (unsigned long)t);
+            mpz_mul_2exp(field, field, PKC_GRID_T_SHIFT);
+            mpz_add(prog.label, prog.label, field);
+            progression_walk(w, base, &prog, start, end);
+        }
+    }
+
+    mpz_clears(inv_d, field, NULL);
+    progression_clear(&prog);
+}
+
+/* k⁻¹·P 不構成等差點列，每個點都是任意倍數：用 P 的窗口表，
+ * 每 WALK_BATCH 個 k 一起做 64 輪批量加法。
+ */
+static void mul_inverse_walk(PkcWorker *w, const secp256k1_pubkey *base, long long start, long long end) {
+    const PkcParams *params = w->params;
+    long long total = end - start;
+    if (total <= 0) return;
+    size_t lanes = total < WALK_BATCH ? (size_t)total : WALK_BATCH;
+
+    AffinePoint p;
+    EcWindowTable table;
+    pubkey_to_point(w->ctx->secp, base, &p);
+    AffinePoint *points = malloc(lanes * sizeof(AffinePoint));
+    AffinePoint *addends = malloc(lanes * sizeof(AffinePoint));
+    FieldElement *scratch = malloc(ec_batch_scratch_len(lanes) * sizeof(FieldElement));
+    unsigned char *inverses = malloc(lanes * 32);
+    unsigned char *labels = malloc(lanes * CLONE_SCALAR_SIZE);
+    if (!points || !addends || !scratch || !inverses || !labels || !ec_window_init(&table, &p)) {
+        w->error = 1;
+        free(points); free(addends); free(scratch); free(inverses); free(labels);
+        return;
+    }
+
+    mpz_t k, inv;
+    mpz_inits(k, inv, NULL);
+    pkc_mpz_set_count(k, start);
+    mpz_mul(k, k, params->step);
+    mpz_add(k, k, params->min_scalar);
+    for (long long base_i = start; base_i < end && !worker_stopped(w); base_i += (long long)lanes) {
+        size_t chunk = end - base_i < (long long)lanes ? (size_t)(end - base_i) : lanes;
+        for (size_t j = 0; j < chunk; ++j) {
+            scalar_to_bytes32(k, labels + j * CLONE_SCALAR_SIZE);
+            // k ≡ 0 (mod n) 沒有逆元，全 0 標量得到無窮遠點，不會被記錄
+            if (mpz_invert(inv, k, w->ctx->n)) mpz_to_scalar32(inv, w->ctx->n, inverses + j * 32);
+            else memset(inverses + j * 32, 0, 32);
+            mpz_add(k, k, params->step);
+        }
+        ec_window_mul_batch(&table, inverses, points, chunk, addends, scratch);
+        for (size_t j = 0; j < chunk; ++j)
+            batch_push(w, &points[j], CLONE_REL_MUL_INV, labels + j * CLONE_SCALAR_SIZE);
+    }
+
+    mpz_clears(k, inv, NULL);
+    ec_window_free(&table);
+    free(points);
+    free(addends);
+    free(scratch);
+    free(inverses);
+    free(labels);
+}
+
+// 乘法族：k·P 是 u = min、du = step 的點列，(k+step)·P = k·P + step·P
+static void mul_worker(PkcWorker *w, const secp256k1_pubkey *base) {
+    const PkcParams *params = w->params;
+    long long start, end;
+    progression_slice(w, params->count, &start, &end);
+    if (params->mul_inverse) {
+        mul_inverse_walk(w, base, start, end);
+        return;
+    }
+
+    PkcProgression prog;
+    progression_init(&prog);
+    mpz_set(prog.u, params->min_scalar);
+    mpz_set(prog.du, params->step);
+    mpz_set(prog.label, params->min_scalar);
+    mpz_set(prog.dlabel, params->step);
+    prog.count = params->count;
+    prog.relation = CLONE_REL_MUL;
+    progression_walk(w, base, &prog, start, end);
+    progression_clear(&prog);
+}
+
+// 批次緩衝在綁核之後由 EC 執行緒自己分配，首次寫入落在本節點
+static bool worker_alloc_slots(PkcWorker *w) {
+    size_t batch_size = w->params->batch_size ? w->params->batch_size : PKC_DEFAULT_BATCH;
+    for (int s = 0; s < PKC_RING_SLOTS; ++s) {
+        if (!batch_buffer_init(&w->slots[s], batch_size, w->params->forms)) return false;
+        if (s > 0) spsc_push(&w->empty, &w->slots[s]);
+    }
+    w->batch = &w->slots[0];
+    return true;
+}
+
+static void *worker_thread(void *arg) {
+    PkcWorker *w = (PkcWorker *)arg;
+    topo_pin_self(topo_place(w->params->pin, w->thread_id, 0, NULL));
+    if (!worker_alloc_slots(w)) {
+        w->error = 1;
+        spsc_close(&w->full);
+        return NULL;
+    }
+    for (int b = 0; b < w->ctx->base_count && !w->error && !worker_stopped(w); ++b) {
+        w->base_index = b;
+        if (w->params->family == PKC_FAMILY_FISSION) fission_worker(w, &w->ctx->bases[b]);
+        else if (w->params->family == PKC_FAMILY_GRID) grid_worker(w, &w->ctx->bases[b]);
+        else if (w->params->family == PKC_FAMILY_MUL) mul_worker(w, &w->ctx->bases[b]);
+        else if (w->params->random_mode) random_worker(w, &w->ctx->bases[b]);
+        else incremental_worker(w, &w->ctx->bases[b]);
+        batch_flush(w);
+    }
+    spsc_close(&w->full);
+    return NULL;
+}
+
+static void *hash_thread(void *arg) {
+    HashWorker *h = (HashWorker *)arg;
+    topo_pin_self(topo_place(h->params->pin, h->thread_id, 1, NULL));
+    BatchBuffer *b;
+    int which = -1;
+    while ((b = spsc_pop_any(h->rings, h->ring_count, &which)) != NULL) {
+        // 停止後仍要把緩衝還回，EC 執行緒才能退出
+        if (!__atomic_load_n(h->stop, __ATOMIC_RELAXED)) {
+            batch_derive_forms(b, h->params->forms);
+            if (h->params->h160_predicate) batch_filter(b, h->params);
+            b->view.thread_id = h->thread_id;
+            if (b->view.count > 0 && h->fn(&b->view, h->user)) __atomic_store_n(h->stop, 1, __ATOMIC_RELAXED);
+        }
+        b->view.count = 0;
+        spsc_push(&h->producers[which]->empty, b);
+    }
+    return NULL;
+}
+
+int pkc_sink_threads(const PkcParams *params) {
+    int threads = params->threads > 0 ? params->threads : 1;
+    if (params->hash_threads <= 0 || params->hash_threads > threads) return threads;
+    return params->hash_threads;
+}
+
+static bool worker_init(PkcWorker *w) {
+    return spsc_init(&w->full, PKC_RING_SLOTS) && spsc_init(&w->empty, PKC_RING_SLOTS);
+}
+
+static void worker_free(PkcWorker *w) {
+    for (int s = 0; s < PKC_RING_SLOTS; ++s) batch_buffer_free(&w->slots[s]);
+    spsc_free(&w->full);
+    spsc_free(&w->empty);
+}
+
+// 最後一個 s = min + (count-1)·step 必須放得進標量的 s 字段
+static bool grid_label_fits(const PkcParams *params) {
+    mpz_t last;
+    mpz_init(last);
+    pkc_mpz_set_count(last, params->count - 1);
+    mpz_mul(last, last, params->step);
+    mpz_add(last, last, params->min_scalar);
+    bool fits = mpz_sizeinbase(last, 2) <= PKC_GRID_S_BITS;
+    mpz_clear(last);
+    return fits;
+}
+
+void pkc_mpz_set_count(mpz_ptr out, long long count) {
+    uint64_t value = (uint64_t)count;
+    mpz_import(out, 1, 1, sizeof(value), 0, 0, &value);
+}
+
+int pkc_mpz_get_count(mpz_srcptr v, long long *out) {
+    if (mpz_sgn(v) < 0 || mpz_sizeinbase(v, 2) > 63) return 0;
+    uint64_t value = 0;
+    mpz_export(&value, NULL, 1, sizeof(value), 0, 0, v);
+    *out = (long long)value;
+    return 1;
+}
+
+void pkc_range_terms(const PkcParams *params, mpz_ptr out) {
+    mpz_sub(out, params->max_scalar, params->min_scalar);
+    if (mpz_sgn(out) < 0) {
+        mpz_set_ui(out, 0);
+        return;
+    }
+    mpz_fdiv_q(out, out, params->step);
+    mpz_add_ui(out, out, 1);
+}
+
+// 下標 [perm_start, perm_start + count) 必須都在 [0, 項數) 內
+static bool permutation_init(const PkcParams *params, FeistelPerm *perm) {
+    mpz_t terms, end;
+    mpz_inits(terms, end, NULL);
+    pkc_range_terms(params, terms);
+    pkc_mpz_set_count(end, params->count);
+    mpz_add(end, end, params->perm_start);
+    bool ok = mpz_sgn(params->perm_start) >= 0 && mpz_cmp(end, terms) <= 0
+              && feistel_init(perm, terms, params->perm_key);
+    mpz_clears(terms, end, NULL);
+    return ok;
+}
+
+int pkc_run(PkcContext *ctx, const PkcParams *params, PkcBatchFn fn, void *user) {
+    int num_threads = params->threads;
+    if (!fn || params->count <= 0 || num_threads <= 0 || mpz_sgn(params->step) <= 0) return -1;
+    if (params->h160_predicate && !(params->forms & (PKC_FORM_H160 | PKC_FORM_H160_U))) return -1;
+    // 增量模式只用 min 與 step
+    if (params->random_mode && mpz_cmp(params->min_scalar, params->max_scalar) > 0) return -1;
+    if (params->family != PKC_FAMILY_SHIFT && (params->random_mode || params->endo)) return -1;
+    if (params->family == PKC_FAMILY_FISSION && params->count > PKC_FISSION_MAX_DEPTH) return -1;
+    if (params->family == PKC_FAMILY_GRID
+        && (params->div_min == 0 || params->div_min > params->div_max
+            || params->div_iterations < 1 || params->div_iterations > PKC_GRID_MAX_ITERATIONS
+            || mpz_sgn(params->min_scalar) < 0 || !grid_label_fits(params))) return -1;
+    FeistelPerm perm;
+    if (params->permute && (!params->random_mode || !permutation_init(params, &perm))) return -1;
+    if (ctx->base_count == 0) return 0;
+    // 工作執行緒開始前確定批量加法後端
+    ec_get_backend();
+
+    int num_hash = pkc_sink_threads(params);
+    pthread_t *threads = malloc((num_threads + num_hash) * sizeof(pthread_t));
+    PkcWorker *workers = calloc(num_threads, sizeof(PkcWorker));
+    HashWorker *hashers = calloc(num_hash, sizeof(HashWorker));
+    SpscRing **rings = malloc(num_threads * sizeof(SpscRing *));
+    PkcWorker **producers = malloc(num_threads * sizeof(PkcWorker *));
+    int result = 0;
+    if (!threads || !workers || !hashers || !rings || !producers) result = -1;
+    for (int i = 0; result == 0 && i < num_threads; i++)
+        if (!worker_init(&workers[i])) result = -1;
+    if (result < 0) {
+        for (int i = 0; workers && i < num_threads; i++) worker_free(&workers[i]);
+        free(threads); free(workers); free(hashers); free(rings); free(producers);
+        return -1;
+    }
+
+    int stop = 0;
+    long long count_per_thread = params->count / num_threads;
+    long long remainder = params->count % num_threads;
+    long long current_start = 0;
+    unsigned long seed = params->seed ? params->seed : (unsigned long)time(NULL) ^ (unsigned long)getpid();
+
+    // EC 執行緒 i 交給哈希執行緒 i % num_hash
+    int ring_pos = 0;
+    for (int h = 0; h < num_hash; h++) {
+        HashWorker *hw = &hashers[h];
+        hw->thread_id = h;
+        hw->params = params;
+        hw->fn = fn;
+        hw->user = user;
+        hw->stop = &stop;
+        hw->rings = rings + ring_pos;
+        hw->producers = producers + ring_pos;
+        for (int i = h; i < num_threads; i += num_hash) {
+            rings[ring_pos] = &workers[i].full;
+            producers[ring_pos++] = &workers[i];
+            hw->ring_count++;
+        }
+    }
+
+    int started = 0;
+    for (int i = 0; i < num_threads; i++) {
+        PkcWorker *w = &workers[i];
+        w->thread_id = i;
+        w->thread_count = num_threads;
+        w->start_count = current_start;
+        w->end_count = current_start + count_per_thread + (i < remainder ? 1 : 0);
+        current_start = w->end_count;
+        w->ctx = ctx;
+        w->params = params;
+        w->stop = &stop;
+        w->perm = params->permute ? &perm : NULL;
+
+        // 每個執行緒的隨機狀態獨立播種
+        gmp_randinit_default(w->randstate);
+        gmp_randseed_ui(w->randstate, seed ^ (unsigned long)(i + 1));
+        if (pthread_create(&threads[i], NULL, worker_thread, w) != 0) {
+            gmp_randclear(w->randstate);
+            __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+            result = -1;
+            break;
+        }
+        started++;
+    }
+    // 未啟動的 EC 執行緒的環直接關閉，哈希階段才能結束
+    for (int i = started; i < num_threads; i++) spsc_close(&workers[i].full);
+
+    int hash_started = 0;
+    for (int h = 0; h < num_hash; h++) {
+        if (pthread_create(&threads[num_threads + h], NULL, hash_thread, &hashers[h]) != 0) {
+            // 沒有消費者的 EC 執行緒會卡在 empty 環上，由本執行緒代為消費
+            __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+            result = -1;
+            for (int r = h; r < num_hash; r++) hash_thread(&hashers[r]);
+            break;
+        }
+        hash_started++;
+    }
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+        if (workers[i].error) result = -1;
+        gmp_randclear(workers[i].randstate);
+    }
+    for (int h = 0; h < hash_started; h++) pthread_join(threads[num_threads + h], NULL);
+    for (int i = 0; i < num_threads; i++) worker_free(&workers[i]);
+    if (result == 0 && stop) result = 1;
+
+    free(threads);
+    free(workers);
+    free(hashers);
+    free(rings);
+    free(producers);
+    return result;
+}
@@ -0,0 +1,195 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* pkclone.h — 公鑰克隆引擎 (libpkclone)
+ *
+ * 對每個基準公鑰 P 生成 P ± k·G（可選 λ / λ² 像）或 PkcFamily 中的其他點族，結果以批次交給回調：
+ * 同一批內的點、公鑰、hash160、relation 與標量都是連續數組，按下標一一對應。
+ * 批次緩衝屬於工作執行緒，回調返回後即被覆蓋；需要保留的數據請自行複製。
+ *
+ *   PkcContext *ctx = pkc_create();
+ *   pkc_add_base(ctx, pubkey33, 33);
+ *   PkcParams params;
+ *   pkc_params_init(&params);
+ *   params.count = 1000000;
+ *   params.forms = PKC_FORM_H160;
+ *   pkc_run(ctx, &params, my_sink, my_state);
+ *   pkc_params_clear(&params);
+ *   pkc_destroy(ctx);
+ */
+#ifndef PKCLONE_H
+#define PKCLONE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <gmp.h>
+
+#include "ecbatch.h"
+#include "clonefile.h"
+#include "topology.h"
+#include "feistel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 每批需要計算的派生形式（位掩碼）；仿射點、relation 與標量總是提供
+enum {
+    PKC_FORM_PUBKEY   = 1 << 0,   // 33 字節壓縮公鑰
+    PKC_FORM_PUBKEY_U = 1 << 1,   // 65 字節未壓縮公鑰
+    PKC_FORM_H160     = 1 << 2,   // 壓縮公鑰的 hash160
+    PKC_FORM_H160_U   = 1 << 3    // 未壓縮公鑰的 hash160
+};
+
+typedef struct {
+    int thread_id;
+    int base_index;                   // pkc_add_base 返回的下標
+    size_t count;                     // 本批記錄數，不含無窮遠點
+    const AffinePoint *points;
+    const unsigned char *pubkeys;     // count x 33，未計算時為 NULL
+    const unsigned char *pubkeys_u;   // count x 65
+    const unsigned char *h160;        // count x 20
+    const unsigned char *h160_u;      // count x 20
+    const uint8_t *relations;         // count 個 CLONE_REL_*
+    const unsigned char *scalars;     // count x 32，k 的低 256 位大端
+} PkcBatch;
+
+/* 批次回調，在哈希階段的執行緒中調用，多個執行緒同時調用（同一 thread_id 不會並發），
+ * thread_id ∈ [0, pkc_sink_threads(params))。返回非 0 時所有執行緒在當前批次後停止。
+ * 同一 EC 執行緒產生的批次按順序到達同一個 thread_id。
+ */
+typedef int (*PkcBatchFn)(const PkcBatch *batch, void *user);
+
+/* 可選的 hash160 謂詞，在哈希執行緒中求出 hash160 之後、調用回調之前判斷；
+ * 一條記錄算出的各個 hash160（PKC_FORM_H160 / PKC_FORM_H160_U）任一返回非 0 即保留，
+ * 其餘記錄從批次中移除，整批都不保留時不調用回調。
+ */
+typedef int (*PkcH160Predicate)(const unsigned char *h160, void *user);
+
+/* 點族。除 SHIFT 外每一族都是若干條等差點列，用批量加法推進，不支持 random_mode 與 endo。
+ * FISSION：分裂樹，count 為深度。X 的子節點為 X·2⁻¹ 與 (X−G)·2⁻¹，第 d 層恰為
+ *   (P − j·G)·2⁻ᵈ，j ∈ [0, 2ᵈ)，j 的第 i 位是第 i+1 次分裂的選擇。
+ *   按層輸出 d = 1..count，relation 為 CLONE_REL_FISSION，標量為 2ᵈ + j；
+ *   記錄的私鑰為 m 時 P 的私鑰為 m·2ᵈ + j (mod n)。
+ * GRID：先減後除，(P − s·G)·d⁻ᵗ，s = min + i·step (i < count)，d ∈ [div_min, div_max]，
+ *   t ∈ [1, div_iterations]。每個 (d, t) 一條點列，相鄰 s 只差常數點 step·G·d⁻ᵗ。
+ *   relation 為 CLONE_REL_GRID，標量佈局見下方 PKC_GRID_*；私鑰為 m 時 P 的私鑰為 m·dᵗ + s。
+ * MUL：乘法族 k·P，k = min + i·step (i < count)，相鄰兩點相差 step·P，relation 為 CLONE_REL_MUL。
+ *   mul_inverse 時改為 k⁻¹·P (CLONE_REL_MUL_INV)，由 P 的窗口表整批計算。標量為 k；
+ *   私鑰為 m 時 P 的私鑰為 m·k⁻¹（MUL）或 m·k（MUL_INV）。
+ */
+typedef enum {
+    PKC_FAMILY_SHIFT,       // P ± kG
+    PKC_FAMILY_FISSION,
+    PKC_FAMILY_GRID,
+    PKC_FAMILY_MUL
+} PkcFamily;
+
+#define PKC_FISSION_MAX_DEPTH 62
+
+/* GRID 記錄標量的佈局（32 字節大端）：byte 0 = t，bytes 1..4 = d，bytes 5..31 = s 的低 216 位，
+ * 即 t·2²⁴⁸ + d·2²¹⁶ + s。
+ */
+#define PKC_GRID_S_BITS 216
+#define PKC_GRID_D_SHIFT 216
+#define PKC_GRID_T_SHIFT 248
+#define PKC_GRID_MAX_ITERATIONS 255
+
+typedef struct {
+    long long count;        // 每個基準公鑰的標量個數 (k 的個數，每個 k 產生 + 和 - 兩條)；FISSION 時為深度
+    PkcFamily family;
+    int threads;            // EC 階段執行緒數
+    int hash_threads;       // 哈希 + 回調階段執行緒數，0 或大於 threads 時與 threads 相同
+    bool random_mode;       // true：k 在 [min, max] 內按 step 隨機取；false：k_i = min + i*step
+    /* random_mode 下不重複：第 i 個 k = min + π(perm_start + i)·step，π 是 perm_key 決定的
+     * [0, 項數) 上的置換（feistel.h）。下標 perm_start + count 之後接著跑即可續上；
+     * perm_start + count 不能超過項數。
+     */
+    bool permute;
+    unsigned char perm_key[FEISTEL_KEY_SIZE];
+    mpz_t perm_start;
+    bool endo;              // 同時輸出 λ·Q、λ²·Q
+    unsigned forms;         // PKC_FORM_*
+    size_t batch_size;      // 每批最多記錄數，0 表示默認
+    unsigned long seed;     // 隨機模式種子，0 表示 time ^ pid
+    TopoPinMode pin;        // EC 執行緒 i 與消費它的哈希執行緒綁在同一節點的相鄰 CPU 上
+    uint32_t div_min;       // GRID：除數範圍，默認 [2, 2]
+    uint32_t div_max;
+    int div_iterations;     // GRID：每個除數連除 1..div_iterations 次，默認 1
+    bool mul_inverse;       // MUL：輸出 k⁻¹·P 而不是 k·P
+    PkcH160Predicate h160_predicate;  // NULL 表示不過濾；非 NULL 時 forms 須含 H160 或 H160_U
+    void *predicate_user;
+    mpz_t min_scalar;
+    mpz_t max_scalar;
+    mpz_t step;
+} PkcParams;
+
+typedef struct PkcContext PkcContext;
+
+// 默認：count 1，各階段 1 個執行緒，增量模式，PKC_FORM_PUBKEY，k ∈ [1, n-1]，step 1
+void pkc_params_init(PkcParams *params);
+void pkc_params_clear(PkcParams *params);
+
+/* 預先建立進程級狀態：secp256k1 上下文模板（之後的 pkc_create 只複製它）、
+ * 批量加法後端的選擇與 CPU 拓撲。常駐進程在 fork 出子進程前調用一次，子進程直接繼承。
+ * 不是執行緒安全的，應在創建任何執行緒之前調用。
+ */
+void pkc_warm(void);
+PkcContext *pkc_create(void);
+void pkc_destroy(PkcContext *ctx);
+
+// 添加基準公鑰（33 或 65 字節），返回其下標，解析失敗返回 -1
+int pkc_add_base(PkcContext *ctx, const unsigned char *pubkey, size_t len);
+int pkc_base_count(const PkcContext *ctx);
+// 取基準公鑰的仿射點，下標越界返回 0
+int pkc_base_point(const PkcContext *ctx, int index, AffinePoint *out);
+/* 重新計算 SHIFT 族記錄 (base_index, relation, scalar) 的點，relation 為 CLONE_REL_PLUS ..
+ * CLONE_REL_LAMBDA2_MINUS。下標越界、其他 relation 或結果為無窮遠點時返回 0。
+ */
+int pkc_record_point(const PkcContext *ctx, int base_index, int relation, const unsigned char *scalar32, AffinePoint *out);
+/* 任一點族的記錄 (relation, scalar) 化成統一的標量關係 Q = a·P + b·G (mod n)：
+ *   ±：        a = λ^e，b = ±λ^e·k（e = relation / 2）
+ *   FISSION：  標量 2^d + j，a = 2^-d，b = −j·2^-d
+ *   GRID：     a = d^-t，b = −s·d^-t
+ *   MUL：      a = k，b = 0；MUL_INV：a = k^-1，b = 0
+ * 於是 P 的私鑰 = (Q 的私鑰 − b)·a^-1。未知的 relation 或 a ≡ 0 時返回 0。
+ */
+int pkc_record_relation(const PkcContext *ctx, int relation, const unsigned char *scalar32, mpz_ptr a, mpz_ptr b);
+// 按關係用 libsecp256k1 的點乘重算 a·P + b·G，不經批量加法；下標越界或結果為無窮遠點時返回 0
+int pkc_relation_point(const PkcContext *ctx, int base_index, mpz_srcptr a, mpz_srcptr b, AffinePoint *out);
+
+/* 對所有基準公鑰運行，阻塞直到完成。
+ * 返回 0 正常完成，1 被回調中止，-1 參數錯誤或內存不足。
+ */
+int pkc_run(PkcContext *ctx, const PkcParams *params, PkcBatchFn fn, void *user);
+// [min, max] 內按 step 的項數 (max − min) / step + 1，即 permute 時置換的定義域大小
+void pkc_range_terms(const PkcParams *params, mpz_ptr out);
+// 回調可能收到的 thread_id 個數，用於按執行緒分配回調側的狀態
+int pkc_sink_threads(const PkcParams *params);
+// out = count ≥ 0；unsigned long 在 LLP64（Windows）上只有 32 位，不能直接用 mpz_*_ui
+void pkc_mpz_set_count(mpz_ptr out, long long count);
+// v ∈ [0, 2^63) 時寫入 out 並返回 1，否則返回 0
+int pkc_mpz_get_count(mpz_srcptr v, long long *out);
+
+// sha256 + ripemd160
+void pkc_hash160(const unsigned char *data, size_t len, unsigned char *out20);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PKCLONE_H */
@@ -15,8 +15,8 @@
    Author: 8891689 (https://github.com/8891689)
 */
 /* pubkey_cloning.c 
- * gcc pubkey_cloning.c random.c bitrange.c sha256.c ripemd160.c base58.c -o p -pthread -lsecp256k1 -lgmp -Wall -Wextra -O3
- * gcc -static -DSECP256K1_STATIC pubkey_cloning.c random.c bitrange.c sha256.c ripemd160.c base58.c -o p.exe -pthread -march=native -lsecp256k1 -lgmp -Wall -Wextra -O3
+ * gcc pubkey_cloning.c random.c bitrange.c sha256.c ripemd160.c base58.c ecbatch.c hexcodec.c clonefile.c pkclone.c spsc.c topology.c keylist.c kangaroo.c bsgs.c autotune.c h160filter.c pipeout.c jobserver.c feistel.c mitmjoin.c coverage.c segcache.c hitverify.c -o p -pthread -lsecp256k1 -lgmp -Wall -Wextra -O3
+ * gcc -static -DSECP256K1_STATIC pubkey_cloning.c random.c bitrange.c sha256.c ripemd160.c base58.c ecbatch.c hexcodec.c clonefile.c pkclone.c spsc.c topology.c keylist.c kangaroo.c bsgs.c autotune.c h160filter.c pipeout.c jobserver.c feistel.c mitmjoin.c coverage.c segcache.c hitverify.c -o p.exe -pthread -march=native -lsecp256k1 -lgmp -Wall -Wextra -O3
  * p.exe -m a -n 10 -b 8 -v 0279be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798
  * ./p 0279be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798 -m a -n 10 -b 8 -v
  */
@@ -26,236 +26,1751 @@
 #include <stdbool.h>
 #include <unistd.h>
 #include <gmp.h>
-#include <secp256k1.h>
-#include <time.h>
 #include <limits.h>
 #include <pthread.h>
 #include <stdint.h>
-
-#ifdef _WIN32
-#include <windows.h>
-#define getpid GetCurrentProcessId
-#else
-#include <unistd.h>
-#endif
+#include <getopt.h>
+#include <signal.h>
+#include <time.h>
 
 #include "random.h"
 #include "bitrange.h"
-#include "sha256.h"
-#include "ripemd160.h"
 #include "base58.h"
+#include "ecbatch.h"
+#include "hexcodec.h"
+#include "clonefile.h"
+#include "pkclone.h"
+#include "spsc.h"
+#include "keylist.h"
+#include "kangaroo.h"
+#include "bsgs.h"
+#include "autotune.h"
+#include "h160filter.h"
+#include "pipeout.h"
+#include "jobserver.h"
+#include "mitmjoin.h"
+#include "coverage.h"
+#include "segcache.h"
+#include "hitverify.h"
 
-#define SHA256_DIGEST_SIZE 32
 #define HASH160_SIZE 20
+// 每個執行緒每個輸出文件的緩衝大小，滿了才交給寫出執行緒
+#define OUTPUT_BUFFER_SIZE (1 << 16)
+// 每個 RecordWriter 除正在填充的緩衝外，還可以有這麼多個在等待寫出
+#define OUTPUT_SPARE_BUFFERS 4
+// --dp-load 最多可給的文件數
+#define KANGAROO_LOAD_MAX 16
+// --kangaroo 的進度行間隔（秒）
+#define KANGAROO_REPORT_SECONDS 10
+// --bsgs-mem 的默認值（MB）
+#define BSGS_DEFAULT_MEM_MB 256
+// --autotune 每次試驗的秒數
+#define AUTOTUNE_TRIAL_SECONDS 0.5
+// vmsplice 輸出時，寫出執行緒等待讀端取走數據的輪詢間隔（微秒）
+#define SPLICE_POLL_US 100
+// --join-mem 的默認值（MB）
+#define JOIN_DEFAULT_MEM_MB 1024
+// --coverage 分段運行：第一段的項數；一段比沖出間隔的一半還快時下一段加倍
+#define COVERAGE_FIRST_CHUNK (1 << 20)
+#define COVERAGE_FLUSH_SECONDS 60
+// --cache：每段的下標個數（分段鍵的一部分，改動後舊條目不再命中）與默認容量
+#define CACHE_SEGMENT_TERMS (1 << 20)
+#define CACHE_DEFAULT_MB 16384
+// -n 0 或超出 long long 時每段的標量個數
+#define STREAM_CHUNK (1LL << 28)
 
 const char* SECP256K1_N_HEX = "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141";
 
 typedef enum { 
-    MODE_PUBKEY, 
-    MODE_HASH160, 
-    MODE_ADDRESS 
+    MODE_PUBKEY,                  // p  壓縮公鑰
+    MODE_PUBKEY_UNCOMPRESSED,     // u  未壓縮公鑰
+    MODE_HASH160,                 // h  壓縮公鑰的 hash160
+    MODE_HASH160_UNCOMPRESSED,    // hu 未壓縮公鑰的 hash160
+    MODE_ADDRESS,                 // a  壓縮公鑰的地址
+    MODE_ADDRESS_UNCOMPRESSED,    // au 未壓縮公鑰的地址
+    MODE_COUNT
 } OutputMode;
 
+static const char *MODE_NAMES[MODE_COUNT] = { "p", "u", "h", "hu", "a", "au" };
+// 二進制記錄中各模式的 key 長度，0 表示不支持二進制輸出
+static const uint8_t MODE_KEY_LEN[MODE_COUNT] = { 33, 65, HASH160_SIZE, HASH160_SIZE, 0, 0 };
+// 按 CLONE_REL_* 下標的文本標記
+static const char *RELATION_TAGS[] = { "+", "-", "L+", "L-", "L2+", "L2-", "F", "D", "M", "MI" };
+// -m 中選擇點族的關鍵字，按 PkcFamily 下標；SHIFT 是默認，沒有關鍵字
+static const char *FAMILY_NAMES[] = { NULL, "fission", "grid", "mul" };
+
+// -m 給出的格式集合（保持用戶給出的順序）
 typedef struct {
-    int thread_id;
-    long long start_count;
-    long long end_count;
-    secp256k1_context *ctx;
-    secp256k1_pubkey pubkey_orig;
-    mpz_t min_scalar;
-    mpz_t max_scalar;
-    mpz_t n;
-    bool random_mode;
+    OutputMode modes[MODE_COUNT];
+    int mode_count;
+    bool need[MODE_COUNT];
+    bool split;                 // 每種格式寫到各自的 <file>.<mode>，否則按列寫在同一行
+    bool binary;                // 寫 clonefile.h 定義的定長二進制記錄
+    FILE *fps[MODE_COUNT];      // 與 modes 同下標；非 split 時只用 fps[0]
+    bool spliced;               // fps[0] 是管道：寫出執行緒用 vmsplice 交出緩衝
+    PipeOut pipe;
+} OutputSpec;
+
+// 批次中一條記錄的各種派生形式：公鑰與 hash160 指向引擎的批次數組，地址在此生成
+typedef struct {
+    const unsigned char *pubkey;
+    const unsigned char *pubkey_u;
+    const unsigned char *h160;
+    const unsigned char *h160_u;
+    char address[64];
+    char address_u[64];
+} KeyForms;
+
+typedef struct OutputBuffer {
+    char *data;
+    size_t len;
+    size_t cap;
+    FILE *fp;
+    // vmsplice 輸出時：交出後的管道偏移與所屬 RecordWriter，讀端越過偏移才回收
+    uint64_t pipe_end;
+    int owner;
+    struct OutputBuffer *next;
+} OutputBuffer;
+
+/* 記錄先格式化進執行緒自己的緩衝區。piped 時寫滿的緩衝經 full 環交給寫出執行緒，
+ * 再從 empty 環取回空緩衝；磁盤慢時 empty 環取不到緩衝，回調就地等待（反壓）。
+ * 非 piped 時直接 fwrite。
+ */
+typedef struct {
+    OutputBuffer *files[MODE_COUNT];  // 正在填充的緩衝，與 OutputSpec.fps 同下標
+    OutputBuffer pool[MODE_COUNT + OUTPUT_SPARE_BUFFERS];
+    SpscRing full;
+    SpscRing empty;
+    bool piped;
+    bool mapped;                // 緩衝是 pipe_out_alloc 的整頁映射（vmsplice 輸出）
+} RecordWriter;
+
+// 引擎回調的狀態：每個回調執行緒一個 RecordWriter
+typedef struct {
+    const OutputSpec *output;
     bool verbose;
-    OutputMode output_mode;
-    FILE *output_fp;
-    pthread_mutex_t *output_mutex;
-    gmp_randstate_t randstate; 
-} ThreadData;
+    bool show_base;             // 多個基準公鑰時在 -v 後綴中標出下標
+    RecordWriter *writers;
+} CloneSink;
+
+// 唯一的寫出執行緒，輪流消費各 RecordWriter 的 full 環
+typedef struct {
+    RecordWriter *writers;
+    SpscRing **rings;
+    int count;
+    PipeOut *pipe;              // 非 NULL 時用 vmsplice 寫出
+} WriterStage;
+
+// --kangaroo 的選項
+typedef struct {
+    int dp_bits;                            // -1 自動
+    const char *load[KANGAROO_LOAD_MAX];
+    int load_count;
+    const char *save;
+    uint64_t max_jumps;                     // -n，0 表示不限
+} KangarooOptions;
+
+// --join 的回調狀態：收集一邊的記錄，或（A 放得進內存時）用 B 的記錄直接查 A 的表
+typedef struct {
+    JoinSide *side;
+    const JoinTable *table;     // 非 NULL 時查表
+    JoinMatchList *matches;     // 每個回調執行緒一個
+} JoinSink;
+
+// --coverage 記錄的下標空間
+typedef enum {
+    COVER_SPACE_INCREMENTAL,    // 下標 i 對應 k = i·step + offset
+    COVER_SPACE_PERMUTE,        // 置換的下標
+    COVER_SPACE_RANDOM          // 沒有區間，只累計抽樣次數
+} CoverSpace;
+
+// --coverage：每個基準公鑰一個分節，本次完成的區間分段沖出到文件
+typedef struct {
+    const char *path;
+    bool skip;                  // --skip-covered：只跑所有基準公鑰都沒覆蓋到的空隙
+    CoverSpace space;
+    char **names;
+    int base_count;
+    mpz_t first;                // 下標空間 [first, last]
+    mpz_t last;
+    mpz_t offset;
+    CoverMap known;             // --skip-covered 時運行前讀入的文件
+    CoverMap done;
+} CoveragePlan;
+
+// 正在運行的求解器，Ctrl-C 時讓它停下並照常保存 DP 表
+static Kangaroo *volatile active_kangaroo = NULL;
+static Bsgs *volatile active_bsgs = NULL;
+// 分段克隆時 Ctrl-C 置 1，clone_sink 讓引擎停下
+static volatile sig_atomic_t clone_interrupted = 0;
 
 bool hex_to_bytes(const char *hex, unsigned char *bytes, size_t hex_len, size_t *bytes_len) {
     if (hex_len % 2 != 0) return false;
     *bytes_len = hex_len / 2;
-    if (*bytes_len == 0 && hex_len == 0) return true;
-    for (size_t i = 0; i < *bytes_len; ++i) {
-        if (sscanf(hex + 2 * i, "%2hhx", &bytes[i]) != 1) return false;
+    return hex_decode(bytes, hex, hex_len);
+}
+
+void hash160_to_address(const unsigned char *h160, char *address_str, size_t size) {
+    unsigned char payload[1 + HASH160_SIZE];
+    payload[0] = 0x00; // P2PKH Mainnet version byte
+    memcpy(payload + 1, h160, HASH160_SIZE);
+
+    address_str[0] = '\0';
+    char *encoded = base58_encode_check(payload, sizeof(payload));
+    if (encoded) {
+        snprintf(address_str, size, "%s", encoded);
+        free(encoded);
     }
-    return true;
 }
 
-void print_bytes_hex(FILE *fp, const unsigned char *bytes, size_t len) {
-    for (size_t i = 0; i < len; ++i) {
-        fprintf(fp, "%02x", bytes[i]);
+/* 解析 -m 的逗號分隔集合，如 "p,u,h,hu,a"。集合中可以有一個點族關鍵字，如 "fission,h"，
+ * 只給點族時輸出格式為 p。
+ */
+bool parse_output_modes(const char *param, OutputSpec *out, PkcFamily *family) {
+    char buffer[64];
+    if (strlen(param) >= sizeof(buffer)) return false;
+    strcpy(buffer, param);
+
+    out->mode_count = 0;
+    memset(out->need, 0, sizeof(out->need));
+    *family = PKC_FAMILY_SHIFT;
+    for (char *tok = strtok(buffer, ","); tok; tok = strtok(NULL, ",")) {
+        int mode = -1, fam = -1;
+        for (int m = 0; m < MODE_COUNT; ++m) {
+            if (strcmp(tok, MODE_NAMES[m]) == 0) { mode = m; break; }
+        }
+        for (int f = 0; mode < 0 && f < (int)(sizeof(FAMILY_NAMES) / sizeof(FAMILY_NAMES[0])); ++f) {
+            if (FAMILY_NAMES[f] && strcmp(tok, FAMILY_NAMES[f]) == 0) { fam = f; break; }
+        }
+        if (fam >= 0) {
+            if (*family != PKC_FAMILY_SHIFT) return false;
+            *family = (PkcFamily)fam;
+            continue;
+        }
+        if (mode < 0 || out->need[mode]) return false;
+        out->need[mode] = true;
+        out->modes[out->mode_count++] = (OutputMode)mode;
     }
+    if (out->mode_count == 0 && *family != PKC_FAMILY_SHIFT) {
+        out->need[MODE_PUBKEY] = true;
+        out->modes[out->mode_count++] = MODE_PUBKEY;
+    }
+    return out->mode_count > 0;
 }
 
-bool mpz_to_scalar32(mpz_t scalar_mpz, mpz_t n, unsigned char* scalar_bytes) {
-    mpz_t temp_scalar;
-    mpz_init(temp_scalar);
-    mpz_mod(temp_scalar, scalar_mpz, n);
-    memset(scalar_bytes, 0, 32);
-    size_t needed_bytes;
-    unsigned char* exported_bytes = mpz_export(NULL, &needed_bytes, 1, 1, 1, 0, temp_scalar);
-    if (needed_bytes > 32) {
-        fprintf(stderr, "Internal Error: Exported scalar (%zu bytes) is larger than 32 bytes.\n", needed_bytes);
-        free(exported_bytes);
-        mpz_clear(temp_scalar);
-        return false;
+// --div 的十進制除數範圍 "A:B" 或單個 "A"，要求 1 <= A <= B < 2^32
+bool parse_divisors(const char *param, uint32_t *min, uint32_t *max) {
+    char *end;
+    unsigned long long lo = strtoull(param, &end, 10), hi = lo;
+    if (end == param) return false;
+    if (*end == ':') {
+        const char *second = end + 1;
+        hi = strtoull(second, &end, 10);
+        if (end == second) return false;
     }
-    memcpy(scalar_bytes + (32 - needed_bytes), exported_bytes, needed_bytes);
-    free(exported_bytes);
-    mpz_clear(temp_scalar);
+    if (*end != '\0' || lo == 0 || lo > hi || hi > UINT32_MAX) return false;
+    *min = (uint32_t)lo;
+    *max = (uint32_t)hi;
     return true;
 }
 
-bool generate_random_scalar_in_range(mpz_t result, gmp_randstate_t state, mpz_t min, mpz_t max) {
-    if (mpz_cmp(min, max) > 0) return false;
-    
-    mpz_t range_size;
-    mpz_init(range_size);
-    mpz_sub(range_size, max, min);
-    mpz_add_ui(range_size, range_size, 1);
-    
-    mpz_urandomm(result, state, range_size);
-    mpz_add(result, result, min);
+// -m 集合需要引擎計算的形式；地址由 hash160 得出
+unsigned engine_forms(const OutputSpec *out) {
+    const bool *need = out->need;
+    unsigned forms = 0;
+    if (need[MODE_PUBKEY]) forms |= PKC_FORM_PUBKEY;
+    if (need[MODE_PUBKEY_UNCOMPRESSED]) forms |= PKC_FORM_PUBKEY_U;
+    if (need[MODE_HASH160] || need[MODE_ADDRESS]) forms |= PKC_FORM_H160;
+    if (need[MODE_HASH160_UNCOMPRESSED] || need[MODE_ADDRESS_UNCOMPRESSED]) forms |= PKC_FORM_H160_U;
+    return forms;
+}
+
+// --h160-prefix 等謂詞要檢查的 hash160：-m 中壓縮與未壓縮的形式各自對應的那一個
+unsigned filter_forms(const OutputSpec *out) {
+    const bool *need = out->need;
+    unsigned forms = 0;
+    if (need[MODE_PUBKEY] || need[MODE_HASH160] || need[MODE_ADDRESS]) forms |= PKC_FORM_H160;
+    if (need[MODE_PUBKEY_UNCOMPRESSED] || need[MODE_HASH160_UNCOMPRESSED] || need[MODE_ADDRESS_UNCOMPRESSED]) forms |= PKC_FORM_H160_U;
+    return forms;
+}
+
+int filter_predicate(const unsigned char *h160, void *user) {
+    return h160_filter_match((const H160Filter *)user, h160);
+}
+
+/* --permute：解析或生成密鑰與起始下標，把 total 限制在剩餘的項數內（-n 0 時即剩餘的項數），
+ * 並打印續跑所需的參數。項數為 [min, max] 內按 step 的標量個數。
+ */
+bool setup_permutation(const char *key_hex, const char *start_hex, mpz_srcptr min, mpz_srcptr max, mpz_srcptr step,
+                       unsigned char *key, mpz_ptr start, mpz_ptr total) {
+    mpz_t value, terms, end;
+    mpz_inits(value, terms, end, NULL);
+    bool ok = true;
+    if (key_hex) {
+        ok = mpz_set_str(value, key_hex, 16) == 0 && mpz_sgn(value) >= 0 && mpz_sizeinbase(value, 2) <= 8 * FEISTEL_KEY_SIZE;
+        if (!ok) fprintf(stderr, "Error: --perm-key must be at most 64 hexadecimal digits.\n");
+    } else {
+        rseed((uint64_t)time(NULL) ^ (uint64_t)getpid() << 32 ^ (uint64_t)clock());
+        for (int i = 0; i < FEISTEL_KEY_SIZE / 4; ++i) {
+            mpz_mul_2exp(value, value, 32);
+            mpz_add_ui(value, value, rndu32());
+        }
+    }
+    if (ok && start_hex && (mpz_set_str(start, start_hex, 16) != 0 || mpz_sgn(start) < 0)) {
+        fprintf(stderr, "Error: --perm-start must be a hexadecimal index.\n");
+        ok = false;
+    }
+    mpz_sub(terms, max, min);
+    if (ok && mpz_sgn(terms) < 0) {
+        fprintf(stderr, "Error: Range minimum is greater than maximum.\n");
+        ok = false;
+    }
+    mpz_fdiv_q(terms, terms, step);
+    mpz_add_ui(terms, terms, 1);
+    if (ok && mpz_cmp(start, terms) >= 0) {
+        gmp_fprintf(stderr, "Error: --perm-start is past the last index %Zx.\n", terms);
+        ok = false;
+    }
+    if (ok) {
+        mpz_sub(end, terms, start);
+        if (mpz_sgn(total) == 0) {
+            mpz_set(total, end);
+        } else if (mpz_cmp(end, total) < 0) {
+            mpz_set(total, end);
+            gmp_fprintf(stderr, "[+] permute: only %Zx indices left, count reduced.\n", end);
+        }
+        memset(key, 0, FEISTEL_KEY_SIZE);
+        size_t words;
+        mpz_export(key + FEISTEL_KEY_SIZE - (mpz_sgn(value) ? mpz_sizeinbase(value, 256) : 0), &words, 1, 1, 1, 0, value);
+        mpz_add(end, start, total);
+        gmp_fprintf(stderr, "[+] permute: key %064Zx, indices %Zx..%Zx of %Zx; continue with --perm-start %Zx\n",
+                    value, start, end, terms, end);
+    }
+    mpz_clears(value, terms, end, NULL);
+    return ok;
+}
+
+// 取批次第 i 條記錄的派生形式
+void key_forms_at(const OutputSpec *out, const PkcBatch *batch, size_t i, KeyForms *forms) {
+    forms->pubkey = batch->pubkeys ? batch->pubkeys + i * 33 : NULL;
+    forms->pubkey_u = batch->pubkeys_u ? batch->pubkeys_u + i * 65 : NULL;
+    forms->h160 = batch->h160 ? batch->h160 + i * HASH160_SIZE : NULL;
+    forms->h160_u = batch->h160_u ? batch->h160_u + i * HASH160_SIZE : NULL;
+    if (out->need[MODE_ADDRESS]) hash160_to_address(forms->h160, forms->address, sizeof(forms->address));
+    if (out->need[MODE_ADDRESS_UNCOMPRESSED]) hash160_to_address(forms->h160_u, forms->address_u, sizeof(forms->address_u));
+}
 
-    mpz_clear(range_size);
+static char *output_data_alloc(const RecordWriter *w, size_t size) {
+    return w->mapped ? pipe_out_alloc(size) : malloc(size);
+}
+
+static void output_data_free(const RecordWriter *w, char *data, size_t size) {
+    if (w->mapped) pipe_out_free(data, size);
+    else free(data);
+}
+
+bool record_writer_init(RecordWriter *w, const OutputSpec *out, bool piped) {
+    memset(w, 0, sizeof(*w));
+    w->piped = piped;
+    // vmsplice 交出的是頁本身，緩衝必須整頁對齊，且回收前不能 realloc
+    w->mapped = piped && out->spliced;
+    if (piped && (!spsc_init(&w->full, MODE_COUNT + OUTPUT_SPARE_BUFFERS)
+                  || !spsc_init(&w->empty, MODE_COUNT + OUTPUT_SPARE_BUFFERS))) return false;
+    for (int i = 0; i < MODE_COUNT + OUTPUT_SPARE_BUFFERS; ++i) {
+        OutputBuffer *b = &w->pool[i];
+        bool used = i < MODE_COUNT ? out->fps[i] != NULL : piped;
+        b->fp = i < MODE_COUNT ? out->fps[i] : NULL;
+        b->cap = used ? OUTPUT_BUFFER_SIZE : 0;
+        b->data = used ? output_data_alloc(w, b->cap) : NULL;
+        if (used && !b->data) return false;
+        if (i < MODE_COUNT) w->files[i] = b;
+        else if (used) spsc_push(&w->empty, b);
+    }
     return true;
 }
 
-void hash160(const unsigned char *data, size_t len, unsigned char *out_h160) {
-    unsigned char sha256_hash[SHA256_DIGEST_SIZE];
-    sha256(data, len, sha256_hash);
-    ripemd160(sha256_hash, SHA256_DIGEST_SIZE, out_h160);
+// 寫出第 i 個文件的當前緩衝：piped 時換一個空緩衝繼續填
+void output_buffer_flush(RecordWriter *w, int i) {
+    OutputBuffer *b = w->files[i];
+    if (b->len == 0) return;
+    if (!w->piped) {
+        fwrite(b->data, 1, b->len, b->fp);
+        b->len = 0;
+        return;
+    }
+    spsc_push(&w->full, b);
+    OutputBuffer *next = spsc_pop(&w->empty);
+    next->fp = b->fp;
+    next->len = 0;
+    w->files[i] = next;
+}
+
+// 交出所有剩餘數據並關閉 full 環
+void record_writer_close(RecordWriter *w) {
+    for (int i = 0; i < MODE_COUNT; ++i) output_buffer_flush(w, i);
+    if (w->piped) spsc_close(&w->full);
 }
 
-void pubkey_to_address(const unsigned char *pubkey, size_t pubkey_len, char **address_str) {
-    unsigned char h160[HASH160_SIZE];
-    hash160(pubkey, pubkey_len, h160);
+// 寫出執行緒結束後才能釋放
+void record_writer_free(RecordWriter *w) {
+    for (int i = 0; i < MODE_COUNT + OUTPUT_SPARE_BUFFERS; ++i) {
+        output_data_free(w, w->pool[i].data, w->pool[i].cap);
+        w->pool[i].data = NULL;
+    }
+    if (w->piped) {
+        spsc_free(&w->full);
+        spsc_free(&w->empty);
+    }
+}
 
-    unsigned char payload[1 + HASH160_SIZE];
-    payload[0] = 0x00; // P2PKH Mainnet version byte
-    memcpy(payload + 1, h160, HASH160_SIZE);
+/* vmsplice 寫出：緩衝按交出順序排隊，讀端越過其末尾偏移才還給 empty 環。
+ * 隊列非空時不能阻塞在 full 環上——哈希執行緒可能正等著這些緩衝——所以輪詢。
+ */
+static void splice_writer(WriterStage *stage) {
+    OutputBuffer *head = NULL, *tail = NULL, *b;
+    int which = -1;
+    for (;;) {
+        uint64_t consumed = head ? pipe_out_consumed(stage->pipe) : 0;
+        while (head && head->pipe_end <= consumed) {
+            b = head;
+            head = b->next;
+            if (!head) tail = NULL;
+            b->len = 0;
+            spsc_push(&stage->writers[b->owner].empty, b);
+        }
+        if (head) {
+            b = spsc_try_pop_any(stage->rings, stage->count, &which);
+            if (!b) {
+                usleep(SPLICE_POLL_US);
+                continue;
+            }
+        } else if ((b = spsc_pop_any(stage->rings, stage->count, &which)) == NULL) {
+            break;
+        }
+        pipe_out_write(stage->pipe, b->data, b->len);
+        b->pipe_end = stage->pipe->written;
+        b->owner = which;
+        b->next = NULL;
+        if (tail) tail->next = b;
+        else head = b;
+        tail = b;
+    }
+}
+
+void *writer_thread(void *arg) {
+    WriterStage *stage = (WriterStage *)arg;
+    OutputBuffer *b;
+    int which = -1;
+    if (stage->pipe) {
+        splice_writer(stage);
+        return NULL;
+    }
+    while ((b = spsc_pop_any(stage->rings, stage->count, &which)) != NULL) {
+        fwrite(b->data, 1, b->len, b->fp);
+        b->len = 0;
+        spsc_push(&stage->writers[which].empty, b);
+    }
+    return NULL;
+}
+
+// 保證第 i 個文件的緩衝還有 need 字節可寫，返回寫入位置
+char *output_buffer_reserve(RecordWriter *w, int i, size_t need) {
+    OutputBuffer *b = w->files[i];
+    if (b->len + need > b->cap) {
+        output_buffer_flush(w, i);
+        b = w->files[i];
+    }
+    if (need > b->cap) {
+        // 剛換上的空緩衝，不在管道中，可以直接換掉
+        char *grown = output_data_alloc(w, need);
+        if (!grown) return NULL;
+        output_data_free(w, b->data, b->cap);
+        b->data = grown;
+        b->cap = need;
+    }
+    return b->data + b->len;
+}
+
+size_t format_field(char *dst, OutputMode mode, const KeyForms *forms) {
+    size_t len;
+    switch(mode) {
+        case MODE_PUBKEY: return hex_encode(dst, forms->pubkey, 33);
+        case MODE_PUBKEY_UNCOMPRESSED: return hex_encode(dst, forms->pubkey_u, 65);
+        case MODE_HASH160: return hex_encode(dst, forms->h160, HASH160_SIZE);
+        case MODE_HASH160_UNCOMPRESSED: return hex_encode(dst, forms->h160_u, HASH160_SIZE);
+        case MODE_ADDRESS:
+            len = strlen(forms->address);
+            memcpy(dst, forms->address, len);
+            return len;
+        case MODE_ADDRESS_UNCOMPRESSED:
+            len = strlen(forms->address_u);
+            memcpy(dst, forms->address_u, len);
+            return len;
+        default: return 0;
+    }
+}
+
+// 無符號整數的十進制形式，返回寫入長度
+size_t format_decimal(char *dst, unsigned long value) {
+    char digits[20];
+    size_t count = 0;
+    do { digits[count++] = (char)('0' + value % 10); value /= 10; } while (value);
+    for (size_t i = 0; i < count; ++i) dst[i] = digits[count - 1 - i];
+    return count;
+}
+
+// 網格標量拆成 " 0x<s> /<d>^<t>"，見 pkclone.h 的 PKC_GRID_*
+size_t format_grid_label(char *dst, const unsigned char *scalar32) {
+    size_t pos = 0;
+    unsigned long divisor = ((unsigned long)scalar32[1] << 24) | ((unsigned long)scalar32[2] << 16)
+                          | ((unsigned long)scalar32[3] << 8) | scalar32[4];
+    memcpy(dst + pos, " 0x", 3); pos += 3;
+    pos += hex_encode_trimmed(dst + pos, scalar32 + 5, CLONE_SCALAR_SIZE - 5);
+    memcpy(dst + pos, " /", 2); pos += 2;
+    pos += format_decimal(dst + pos, divisor);
+    dst[pos++] = '^';
+    pos += format_decimal(dst + pos, scalar32[0]);
+    return pos;
+}
+
+/* " = <tag>" 或 " = <tag> 0x<scalar>"，與原先 gmp_fprintf(" = + 0x%Zx") 輸出一致；
+ * base_index >= 0 時再加 " @<下標>"，下標為基準公鑰在輸入文件中有效條目的序號（從 0 起）。
+ */
+size_t format_suffix(char *dst, const char *tag, int relation, const unsigned char *scalar32, int base_index) {
+    if (!tag) return 0;
+    size_t pos = 0, tag_len = strlen(tag);
+    memcpy(dst + pos, " = ", 3); pos += 3;
+    memcpy(dst + pos, tag, tag_len); pos += tag_len;
+    if (scalar32 && relation == CLONE_REL_GRID) {
+        pos += format_grid_label(dst + pos, scalar32);
+    } else if (scalar32) {
+        memcpy(dst + pos, " 0x", 3); pos += 3;
+        pos += hex_encode_trimmed(dst + pos, scalar32, CLONE_SCALAR_SIZE);
+    }
+    if (base_index >= 0) {
+        memcpy(dst + pos, " @", 2); pos += 2;
+        pos += format_decimal(dst + pos, (unsigned long)base_index);
+    }
+    return pos;
+}
+
+// 網格標籤比 " 0x" + 64 位十六進制多出 " /4294967295^255" 的餘量，基準下標最長 " @2147483647"
+size_t suffix_max_len(const char *tag, const unsigned char *scalar32) {
+    if (!tag) return 0;
+    return 6 + strlen(tag) + (scalar32 ? 2 * CLONE_SCALAR_SIZE + 16 : 0) + 12;
+}
 
-    *address_str = base58_encode_check(payload, sizeof(payload));
+const unsigned char *binary_key(OutputMode mode, const KeyForms *forms) {
+    switch(mode) {
+        case MODE_PUBKEY: return forms->pubkey;
+        case MODE_PUBKEY_UNCOMPRESSED: return forms->pubkey_u;
+        case MODE_HASH160: return forms->h160;
+        case MODE_HASH160_UNCOMPRESSED: return forms->h160_u;
+        default: return NULL;
+    }
+}
+
+// 二進制記錄：key | relation | scalar，每個文件一條
+void write_binary_record(RecordWriter *w, const OutputSpec *out, const KeyForms *forms, int relation, const unsigned char *scalar32) {
+    int files = out->split ? out->mode_count : 1;
+    for (int i = 0; i < files; ++i) {
+        size_t key_len = MODE_KEY_LEN[out->modes[i]];
+        unsigned char *dst = (unsigned char *)output_buffer_reserve(w, i, clone_record_size(key_len));
+        if (!dst) continue;
+        memcpy(dst, binary_key(out->modes[i], forms), key_len);
+        dst[key_len] = (unsigned char)relation;
+        memcpy(dst + key_len + 1, scalar32, CLONE_SCALAR_SIZE);
+        w->files[i]->len += clone_record_size(key_len);
+    }
+}
+
+// 寫出一個點的一條記錄到執行緒緩衝區。tag 為 NULL 時不加 " = ..." 後綴
+void write_point_record(RecordWriter *w, const OutputSpec *out, const KeyForms *forms, const char *tag, int relation,
+                        const unsigned char *scalar32, int base_index) {
+    // 單列最長為未壓縮公鑰的 130 個十六進制字符
+    const size_t field_max = 130;
+    size_t suffix_max = suffix_max_len(tag, scalar32);
+
+    if (out->split) {
+        for (int i = 0; i < out->mode_count; ++i) {
+            char *dst = output_buffer_reserve(w, i, field_max + suffix_max + 1);
+            if (!dst) continue;
+            size_t pos = format_field(dst, out->modes[i], forms);
+            pos += format_suffix(dst + pos, tag, relation, scalar32, base_index);
+            dst[pos++] = '\n';
+            w->files[i]->len += pos;
+        }
+        return;
+    }
+    char *dst = output_buffer_reserve(w, 0, out->mode_count * (field_max + 1) + suffix_max + 1);
+    if (!dst) return;
+    size_t pos = 0;
+    for (int i = 0; i < out->mode_count; ++i) {
+        if (i > 0) dst[pos++] = ' ';
+        pos += format_field(dst + pos, out->modes[i], forms);
+    }
+    pos += format_suffix(dst + pos, tag, relation, scalar32, base_index);
+    dst[pos++] = '\n';
+    w->files[0]->len += pos;
+}
+
+void output_path(const OutputSpec *out, const char *filename, int i, char *path, size_t size) {
+    if (out->split) snprintf(path, size, "%s.%s", filename, MODE_NAMES[out->modes[i]]);
+    else snprintf(path, size, "%s", filename);
+}
+
+// 打開輸出：無 -o 時寫 stdout；split 時每種格式一個 <file>.<mode>；二進制時先寫文件頭
+bool open_outputs(OutputSpec *out, const char *filename) {
+    int files = out->split ? out->mode_count : 1;
+    for (int i = 0; i < MODE_COUNT; ++i) out->fps[i] = NULL;
+    for (int i = 0; i < files; ++i) {
+        if (!filename) {
+            out->fps[i] = stdout;
+        } else {
+            char path[4096];
+            output_path(out, filename, i, path, sizeof(path));
+            out->fps[i] = fopen(path, out->binary ? "wb" : "w");
+            if (!out->fps[i]) {
+                fprintf(stderr, "Error: Could not open output file '%s'.\n", path);
+                while (i-- > 0) fclose(out->fps[i]);
+                return false;
+            }
+        }
+        if (out->binary) {
+            CloneFileInfo info = { MODE_KEY_LEN[out->modes[i]], 0 };
+            clone_write_header(out->fps[i], &info);
+        }
+    }
+    return true;
+}
+
+void close_outputs(OutputSpec *out) {
+    for (int i = 0; i < MODE_COUNT; ++i) {
+        if (out->fps[i] && out->fps[i] != stdout) fclose(out->fps[i]);
+        out->fps[i] = NULL;
+    }
 }
 
 // --- 程序主邏輯 ---
 void print_usage(const char *prog_name) {
-    fprintf(stderr, "Usage: %s <public key hex> [options]\n", prog_name);
+    fprintf(stderr, "Usage: %s <public key hex | key file> [options]\n", prog_name);
+    fprintf(stderr, "       %s --daemon <socket> [--jobs <n>]\n", prog_name);
+    fprintf(stderr, "       %s --connect <socket> <public key hex | key file> [options]\n", prog_name);
+    fprintf(stderr, "  A key file holds one public key (33 or 65 bytes in hex) per line; only the first field\n");
+    fprintf(stderr, "  of a line is read, so -v output works as input. It is loaded in parallel (-t threads)\n");
+    fprintf(stderr, "  and every key is cloned; with -v each line gets @<index of the key in the file>.\n");
     fprintf(stderr, "Options:\n");
-    fprintf(stderr, "  -m <mode>   Output mode: p (pubkey, default), h (hash160), a (address).\n");
-    fprintf(stderr, "  -t <num>    Number of threads (default: 1).\n");
-    fprintf(stderr, "  -n <count>  Total number of operations (default: 1, must be > 0).\n");
+    fprintf(stderr, "  -m <mode>   Output mode: p (pubkey, default), h (hash160), a (address),\n");
+    fprintf(stderr, "              u / hu / au (the same for the uncompressed pubkey). A comma-separated\n");
+    fprintf(stderr, "              set such as p,u,h,hu,a computes each point once and writes columns.\n");
+    fprintf(stderr, "  -m fission  Fission (halving) tree instead of P +/- kG; may be combined with the\n");
+    fprintf(stderr, "              output modes, e.g. -m fission,h. -n is the depth (at most 62). Every node X\n");
+    fprintf(stderr, "              splits into X/2 and (X-G)/2, so level d is (P - j*G)/2^d for all j < 2^d,\n");
+    fprintf(stderr, "              bit i of j being the (i+1)-th choice. Levels 1..n are written in order and\n");
+    fprintf(stderr, "              each one is walked with batched additions in constant memory. -v tags a\n");
+    fprintf(stderr, "              key F 0x<2^d + j>; if it has private key m, P has m*2^d + j mod n.\n");
+    fprintf(stderr, "  -m grid     Subtract-then-divide grid (P - s*G)/d^t: s = min + i*step for -n values\n");
+    fprintf(stderr, "              (-b/-r give min, default 0), d over --div, t = 1..--iter. Each (d, t) costs\n");
+    fprintf(stderr, "              two scalar multiplications; every s after that is one batched addition.\n");
+    fprintf(stderr, "              -v tags a key D 0x<s> /<d>^<t>; if it has private key m, P has m*d^t + s.\n");
+    fprintf(stderr, "  -m mul      Multiplicative family k*P, k = min + i*step for -n values (-b/-r give min,\n");
+    fprintf(stderr, "              default 1), walked as (k+step)*P = k*P + step*P with batched additions.\n");
+    fprintf(stderr, "              -v tags a key M 0x<k>; if it has private key m, P has m/k mod n.\n");
+    fprintf(stderr, "  --inverse   With -m mul, write k^-1*P instead (tag MI; P has m*k). Every point is\n");
+    fprintf(stderr, "              computed from a 4-bit window table of P, 256 scalars per batch.\n");
+    fprintf(stderr, "  --div <A:B> Decimal divisor range for -m grid (default: 2).\n");
+    fprintf(stderr, "  --iter <t>  Divide each s up to t times by every divisor, -m grid (default: 1, max 255).\n");
+    fprintf(stderr, "  --kangaroo  Instead of cloning, solve for the private key in the -b/-r range with\n");
+    fprintf(stderr, "              Pollard's kangaroo method, about 2*sqrt(range) jumps. 256 kangaroos per thread\n");
+    fprintf(stderr, "              walk with batched additions; distinguished points go to a shared lock-free\n");
+    fprintf(stderr, "              table. Writes \"<pubkey> <private key>\" per solved key. -n limits the total\n");
+    fprintf(stderr, "              jumps; Ctrl-C stops the walk and --dp-save still writes the table.\n");
+    fprintf(stderr, "  --dp <bits> Distinguished-point bits for --kangaroo (default: from range and threads).\n");
+    fprintf(stderr, "  --dp-load <file>  Merge a saved DP table before walking; may be given several times.\n");
+    fprintf(stderr, "              A resumed run reuses the jump table of the first file.\n");
+    fprintf(stderr, "  --dp-save <file>  Write the DP table after the run, to resume or merge later.\n");
+    fprintf(stderr, "  --bsgs      Instead of cloning, solve for the private keys of all given public keys in\n");
+    fprintf(stderr, "              the -b/-r range by baby-step giant-step. One table of m baby steps serves\n");
+    fprintf(stderr, "              every key; each giant step covers 2m+1 keys. Writes \"<pubkey> <private key>\".\n");
+    fprintf(stderr, "  --bsgs-mem <MB>  Memory for the baby-step table (default: 256), 8 bytes per slot.\n");
+    fprintf(stderr, "  --bsgs-table <file>  Map this baby-step table if it exists, else build and save it.\n");
+    fprintf(stderr, "  --join <public key hex | key file>  Clone these keys as a second set B with the same\n");
+    fprintf(stderr, "              options and report where B meets the first set A instead of writing keys:\n");
+    fprintf(stderr, "              \"<A key> <tag> 0x<a> <B key> <tag> 0x<b> same|neg\", i.e. A +/- a*G equals\n");
+    fprintf(stderr, "              (same) or is the negation of (neg) B +/- b*G. Set A is kept as 24-byte x\n");
+    fprintf(stderr, "              fingerprints; B is probed in its hash threads and every hit is recomputed.\n");
+    fprintf(stderr, "              Shift family only; the scalars must span less than 2^64.\n");
+    fprintf(stderr, "  --join-mem <MB>  Memory for the table of set A (default: 1024). A larger A is split by\n");
+    fprintf(stderr, "              fingerprint into partition files for A and B, joined one partition at a time.\n");
+    fprintf(stderr, "  --join-dir <dir>  Directory of the partition files (default: $TMPDIR or /tmp).\n");
+    fprintf(stderr, "  --coverage <file>  Record the scalar intervals this run completes, per public key and\n");
+    fprintf(stderr, "              mode, in this interval file (default: $PKCLONE_COVERAGE if set). The run goes\n");
+    fprintf(stderr, "              in segments and the file is updated after each one (about every minute).\n");
+    fprintf(stderr, "              -R records the number of draws; -R --permute records permutation indices.\n");
+    fprintf(stderr, "  --skip-covered  Only run what the coverage file does not list yet for every given key:\n");
+    fprintf(stderr, "              the first -n uncovered scalars (or --permute indices) up to the range end.\n");
+    fprintf(stderr, "  --cache <dir>  Keep aligned segments of 2^20 scalars of --binary output in <dir>,\n");
+    fprintf(stderr, "              named by the hash of key, modes, step and segment; later runs copy them\n");
+    fprintf(stderr, "              instead of computing. Incremental P +/- kG cloning only.\n");
+    fprintf(stderr, "  --cache-size <MB>  Cache size; least recently used entries are removed after the\n");
+    fprintf(stderr, "              run (default: 16384).\n");
+    fprintf(stderr, "  --verify <file>  Instead of writing keys, check them against the public keys, hash160s\n");
+    fprintf(stderr, "              or addresses in <file> (one per line). Hash threads look up an 8-byte\n");
+    fprintf(stderr, "              fingerprint; a verifier thread recomputes each candidate exactly and writes\n");
+    fprintf(stderr, "              \"<key> <tag> 0x<k> <clone> <hash160> p = 0x<c>*q + 0x<d>\", p being the private\n");
+    fprintf(stderr, "              key of <key> and q that of the target. Any -m family, --endo, -R, -n 0.\n");
+    fprintf(stderr, "  -t <num>    Number of EC threads (default: 1, or the autotune profile).\n");
+    fprintf(stderr, "  --hash-threads <num>  Threads that hash and format the EC batches (default: same as -t).\n");
+    fprintf(stderr, "              One more thread writes the output.\n");
+    fprintf(stderr, "  --affinity  Pin each EC thread and its hash thread to adjacent CPUs.\n");
+    fprintf(stderr, "  --numa      Like --affinity, but spread the thread pairs evenly over the NUMA nodes;\n");
+    fprintf(stderr, "              each pair allocates its batch buffers on its own node.\n");
+    fprintf(stderr, "  --h160-prefix <hex>  Only write keys whose hash160 starts with these hex digits.\n");
+    fprintf(stderr, "  --h160-mask <value:mask>  Only write keys with (hash160 & mask) == value; both hex,\n");
+    fprintf(stderr, "              left-aligned (shorter ones are padded with 0 on the right).\n");
+    fprintf(stderr, "  --addr-prefix <1...>  Only write keys whose P2PKH address starts with this prefix.\n");
+    fprintf(stderr, "              The three filters may be repeated and are ORed; each is checked on the\n");
+    fprintf(stderr, "              hash160 right after hashing, before any formatting. A key is kept when\n");
+    fprintf(stderr, "              the hash160 of its compressed (p, h, a) or uncompressed (u, hu, au) form,\n");
+    fprintf(stderr, "              whichever -m writes, matches.\n");
+    fprintf(stderr, "  --autotune  Time short runs of this -m mode to pick the EC backend, -t, --hash-threads,\n");
+    fprintf(stderr, "              batch size and --affinity, then save them per CPU model in ~/.pkclone_profile\n");
+    fprintf(stderr, "              ($PKCLONE_PROFILE); later runs of the same mode reuse them. Options given on\n");
+    fprintf(stderr, "              the command line are kept as given.\n");
+    fprintf(stderr, "  -n <count>  Total number of operations (default: 1), decimal, below 2^256. 0 runs to the\n");
+    fprintf(stderr, "              end of the range (n - 1 without -b/-r; without end for plain -R). 0 and counts\n");
+    fprintf(stderr, "              of 2^63 and up run in segments; Ctrl-C stops after the last full segment\n");
+    fprintf(stderr, "              and prints where to continue.\n");
     fprintf(stderr, "  -o <file>   Write output to the specified file (default is to the console).\n");
+    fprintf(stderr, "  --split     With -o and a mode set, write one file per mode: <file>.p, <file>.h, ...\n");
+    fprintf(stderr, "  --binary    Write fixed-size binary records (key | relation | 32-byte scalar) after a\n");
+    fprintf(stderr, "              16-byte header instead of text. Modes p, u, h, hu only.\n");
+    fprintf(stderr, "  --sort      With --binary and -o, sort the output by key and drop duplicate keys.\n");
+    fprintf(stderr, "  --sort-input <file>  Sort an existing binary clone file into -o and exit.\n");
+    fprintf(stderr, "  --sort-mem <MB>  Memory per in-memory sort run (default: 1024).\n");
+    fprintf(stderr, "  --no-splice Write to a pipe with write() instead of handing pages over with vmsplice.\n");
+    fprintf(stderr, "  --daemon <socket>  Stay resident on a Unix socket and run the jobs sent with --connect\n");
+    fprintf(stderr, "              in arrival order, --jobs <n> at a time (default: 1). Must be the first option.\n");
+    fprintf(stderr, "  --connect <socket>  Run the rest of the command line in the daemon, with this shell's\n");
+    fprintf(stderr, "              directory, stdin, stdout and stderr; exits with the job's status.\n");
     fprintf(stderr, "  -R          Generate a random scalar. If not specified, enters incremental mode.\n");
+    fprintf(stderr, "  --permute   With -R, never repeat: the i-th scalar is min + pi(i)*step for a keyed\n");
+    fprintf(stderr, "              pseudorandom permutation pi of all terms in the range (Feistel network).\n");
+    fprintf(stderr, "  --perm-key <hex>  Permutation key, up to 64 hex digits (default: new, printed).\n");
+    fprintf(stderr, "  --perm-start <hex>  First permutation index (default: 0). A run covers indices\n");
+    fprintf(stderr, "              [start, start + n); the same key from start + n continues it.\n");
     fprintf(stderr, "  -b <bits>   Specifies a bit range for the scalar, e.g., -b 32 means [2^31, 2^32-1].\n");
     fprintf(stderr, "  -r <A:B>    Specifies a hexadecimal range for the scalar, e.g., -r 100:200.\n");
     fprintf(stderr, "  -v          Verbose: prints the scalar value (in hex) for each operation.\n");
+    fprintf(stderr, "  --endo      Also emit the GLV endomorphism images L*Q = (beta*x, y) and L2*Q of\n");
+    fprintf(stderr, "              every key Q (3x keys for one field multiplication each). If the key\n");
+    fprintf(stderr, "              tagged L+/L- (L2+/L2-) has private key m, the original key is\n");
+    fprintf(stderr, "              m*lambda^2 -/+ k (m*lambda -/+ k) mod n, where\n");
+    fprintf(stderr, "              lambda = 5363ad4cc05c30e0a5261c028812645a122e22ea20816678df02967c1b23bd72.\n");
+    fprintf(stderr, "  --backend <auto|scalar|ifma>  Field backend for the batched point additions\n");
+    fprintf(stderr, "              (default: auto, AVX-512 IFMA when the CPU has it).\n");
+    fprintf(stderr, "  --step <hex> Scalar stride: k = min + i*step. With -b/-r, stops at the range end;\n");
+    fprintf(stderr, "              with -R, samples only multiples of step above min.\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "Example:\n");
     fprintf(stderr, "  %s 02... -n 1000 -t 4 -m a -R   # Generate 1000 random addresses using 4 threads.\n", prog_name);
     fprintf(stderr, "  %s 02... -n 100 -b 64 -v        # Incrementally generate 100 pubkeys from bit 64.\n", prog_name);
+    fprintf(stderr, "  %s 02... -n 100 -b 64 --step 100 -v  # Every multiple of 2^8 from bit 64.\n", prog_name);
+    fprintf(stderr, "  %s 02... -n 100 -b 64 -m p,h,a -o out.txt --split  # out.txt.p, out.txt.h, out.txt.a\n", prog_name);
+    fprintf(stderr, "  %s 02... -n 100000000 -b 64 -t 8 --binary --sort -o set.bin  # Sorted comparison set.\n", prog_name);
+    fprintf(stderr, "  %s 02... -m fission,h -n 24 -t 8 -o tree.txt  # All 2^25-2 nodes of a depth-24 tree.\n", prog_name);
+    fprintf(stderr, "  %s 02... -m mul,h -r 2:2 -n 1000000 -t 8 -o mul.txt  # 2P .. 1000001P.\n", prog_name);
+    fprintf(stderr, "  %s 02... -m grid -r 0:ffff -n 65536 --div 2:16 --iter 4 -t 8 -o grid.txt  # 60 cells.\n", prog_name);
+    fprintf(stderr, "  %s 02... --kangaroo -b 48 -t 8 --dp-save k48.dp  # Key in [2^47, 2^48-1], resumable.\n", prog_name);
+    fprintf(stderr, "  %s 02... --join 03... -b 40 -R -n 100000000 -t 8 --endo  # Relations between two keys.\n", prog_name);
+    fprintf(stderr, "  %s keys.txt --bsgs -b 56 -t 8 --bsgs-mem 4096 --bsgs-table m.tbl  # Many keys, one table.\n", prog_name);
 }
 
-void *worker_thread(void *arg) {
-    ThreadData *data = (ThreadData *)arg;
+// 引擎批次回調：在工作執行緒內格式化進該執行緒的緩衝區
+int clone_sink(const PkcBatch *batch, void *user) {
+    CloneSink *sink = (CloneSink *)user;
+    const OutputSpec *out = sink->output;
+    RecordWriter *w = &sink->writers[batch->thread_id];
+    KeyForms forms;
+    if (clone_interrupted) return 1;
+    for (size_t i = 0; i < batch->count; ++i) {
+        const unsigned char *scalar32 = batch->scalars + i * CLONE_SCALAR_SIZE;
+        key_forms_at(out, batch, i, &forms);
+        if (out->binary)
+            write_binary_record(w, out, &forms, batch->relations[i], scalar32);
+        else
+            write_point_record(w, out, &forms, sink->verbose ? RELATION_TAGS[batch->relations[i]] : NULL,
+                               batch->relations[i], scalar32, sink->show_base ? batch->base_index : -1);
+    }
+    return 0;
+}
 
-    mpz_t current_scalar_mpz, neg_current_scalar_mpz;
-    mpz_inits(current_scalar_mpz, neg_current_scalar_mpz, NULL);
+// -v 時最後輸出原公鑰本身，base_index 含義同 format_suffix
+void write_original_record(const OutputSpec *out, const AffinePoint *pt, int base_index) {
+    unsigned char pubkey[33], pubkey_u[65], h160[HASH160_SIZE], h160_u[HASH160_SIZE];
+    ec_point_serialize(pubkey, pt, 1);
+    ec_point_serialize(pubkey_u, pt, 0);
+    pkc_hash160(pubkey, 33, h160);
+    pkc_hash160(pubkey_u, 65, h160_u);
+    PkcBatch single = { .count = 1, .points = pt, .pubkeys = pubkey, .pubkeys_u = pubkey_u, .h160 = h160, .h160_u = h160_u };
 
-    unsigned char scalar_bytes[32];
-    unsigned char neg_scalar_bytes[32];
-    
-    if (!data->random_mode) {
-        mpz_add_ui(current_scalar_mpz, data->min_scalar, data->start_count);
+    KeyForms forms;
+    key_forms_at(out, &single, 0, &forms);
+    RecordWriter writer;
+    if (record_writer_init(&writer, out, false)) {
+        write_point_record(&writer, out, &forms, "original", -1, NULL, base_index);
+        record_writer_close(&writer);
     }
+    record_writer_free(&writer);
+}
 
-    for (long long i = data->start_count; i < data->end_count; ++i) {
-        if (data->random_mode) {
-            // 使用傳入的 randstate 生成隨機數
-            if (!generate_random_scalar_in_range(current_scalar_mpz, data->randstate, data->min_scalar, data->max_scalar)) {
-                fprintf(stderr, "Thread %d: Error generating random scalar.\n", data->thread_id);
-                continue;
+/* 基準公鑰：參數是 33 / 65 字節的十六進制公鑰，或者每行一個公鑰的文件。
+ * 文件中無法解析或不在曲線上的行只報告，不中止。
+ */
+bool add_base_keys(PkcContext *engine, const char *arg, int threads) {
+    unsigned char pubkey_bytes[65];
+    size_t pubkey_bytes_len, arg_len = strlen(arg);
+    if ((arg_len == 66 || arg_len == 130) && hex_to_bytes(arg, pubkey_bytes, arg_len, &pubkey_bytes_len)) {
+        if (pkc_add_base(engine, pubkey_bytes, pubkey_bytes_len) < 0) {
+            fprintf(stderr, "Error: Failed to parse public key.\n");
+            return false;
+        }
+        return true;
+    }
+    if (access(arg, R_OK) != 0) {
+        fprintf(stderr, "Error: Invalid public key hex string or length.\n");
+        return false;
+    }
+
+    KeyList keys;
+    if (!keylist_load(&keys, arg, threads, KEYLIST_PUBKEY)) {
+        fprintf(stderr, "Error: Could not load public keys from '%s'.\n", arg);
+        return false;
+    }
+    size_t off_curve = 0;
+    for (size_t i = 0; i < keys.pubkey_count; ++i)
+        if (pkc_add_base(engine, keys.pubkeys + i * 33, 33) < 0) off_curve++;
+    fprintf(stderr, "[+] loaded %d public keys from %s (%zu lines)\n", pkc_base_count(engine), arg, keys.line_count);
+    for (size_t b = 0; b < keys.bad_count && b < KEYLIST_BAD_REPORT; ++b)
+        fprintf(stderr, "[!] line %zu: not a public key, skipped\n", keys.bad_lines[b]);
+    if (keys.bad_count > KEYLIST_BAD_REPORT)
+        fprintf(stderr, "[!] ... %zu unparsable lines in total\n", keys.bad_count);
+    if (off_curve) fprintf(stderr, "[!] %zu keys are not on the curve, skipped\n", off_curve);
+    keylist_free(&keys);
+    if (pkc_base_count(engine) == 0) {
+        fprintf(stderr, "Error: No valid public keys in '%s'.\n", arg);
+        return false;
+    }
+    return true;
+}
+
+void on_interrupt(int sig) {
+    (void)sig;
+    Kangaroo *k = active_kangaroo;
+    if (k) kangaroo_stop(k);
+    Bsgs *b = active_bsgs;
+    if (b) bsgs_stop(b);
+    clone_interrupted = 1;
+}
+
+void kangaroo_progress(const KangarooStats *stats, void *user) {
+    double *last = (double *)user;
+    if (stats->seconds - *last < KANGAROO_REPORT_SECONDS) return;
+    *last = stats->seconds;
+    fprintf(stderr, "[+] kangaroo: %.3g jumps, %llu DPs, %.2f Mjumps/s\n", (double)stats->jumps,
+            (unsigned long long)stats->dps, stats->seconds > 0 ? stats->jumps / stats->seconds / 1e6 : 0.0);
+}
+
+/* 對每個基準公鑰在 [min, max] 內求私鑰，求出的寫成 "<壓縮公鑰> <私鑰>"。
+ * 跳躍次數用完或被中斷不算錯誤；參數錯誤、內存不足、文件讀寫失敗返回 false。
+ */
+bool run_kangaroo(PkcContext *engine, const KangarooOptions *opt, mpz_srcptr min, mpz_srcptr max,
+                  int threads, TopoPinMode pin, FILE *out) {
+    KangarooParams params;
+    kangaroo_params_init(&params);
+    mpz_set(params.min_scalar, min);
+    mpz_set(params.max_scalar, max);
+    params.threads = threads;
+    params.pin = pin;
+    params.dp_bits = opt->dp_bits;
+    params.max_jumps = opt->max_jumps;
+    // 合併的文件要放得進表；續跑時沿用第一個文件的跳躍表，否則舊路徑接不上
+    for (int i = 0; i < opt->load_count; ++i) {
+        KangarooFileInfo info;
+        if (!kangaroo_file_info(opt->load[i], &info)) {
+            fprintf(stderr, "Error: '%s' is not a kangaroo DP file.\n", opt->load[i]);
+            kangaroo_params_clear(&params);
+            return false;
+        }
+        params.reserve += (size_t)info.count;
+        if (i == 0) params.mean_jump = info.mean_jump;
+        else if (info.mean_jump != params.mean_jump)
+            fprintf(stderr, "[!] %s uses another jump table; only exact DP hits will match it\n", opt->load[i]);
+    }
+
+    bool ok = true;
+    for (int b = 0; ok && b < pkc_base_count(engine); ++b) {
+        AffinePoint pt;
+        unsigned char pubkey[33], key[32];
+        char pubkey_hex[67], key_hex[65];
+        pkc_base_point(engine, b, &pt);
+        ec_point_serialize(pubkey, &pt, 1);
+        pubkey_hex[hex_encode(pubkey_hex, pubkey, 33)] = '\0';
+
+        Kangaroo *k = kangaroo_create(pubkey, 33, &params);
+        if (!k) {
+            fprintf(stderr, "Error: Could not set up the kangaroo solver (invalid range, --dp or out of memory).\n");
+            ok = false;
+            break;
+        }
+        fprintf(stderr, "[+] kangaroo %s: %d kangaroos, dp %d, mean jump %llu, expected %.3g jumps\n", pubkey_hex,
+                kangaroo_count(k), kangaroo_dp_bits(k), (unsigned long long)kangaroo_mean_jump(k), kangaroo_expected_jumps(k));
+        for (int i = 0; ok && i < opt->load_count; ++i) {
+            long long merged = kangaroo_load(k, opt->load[i]);
+            if (merged < 0) {
+                fprintf(stderr, "Error: Could not merge '%s' (read error or DP table full).\n", opt->load[i]);
+                ok = false;
+            } else {
+                fprintf(stderr, "[+] merged %lld DPs from %s\n", merged, opt->load[i]);
             }
         }
-        
-        if (!mpz_to_scalar32(current_scalar_mpz, data->n, scalar_bytes)) continue;
-        
-        mpz_neg(neg_current_scalar_mpz, current_scalar_mpz);
-        if (!mpz_to_scalar32(neg_current_scalar_mpz, data->n, neg_scalar_bytes)) continue;
-
-        // Process addition
-        secp256k1_pubkey pubkey_plus = data->pubkey_orig;
-        if (secp256k1_ec_pubkey_tweak_add(data->ctx, &pubkey_plus, scalar_bytes)) {
-            unsigned char serialized_pubkey[33];
-            size_t len = sizeof(serialized_pubkey);
-            secp256k1_ec_pubkey_serialize(data->ctx, serialized_pubkey, &len, &pubkey_plus, SECP256K1_EC_COMPRESSED);
-
-            pthread_mutex_lock(data->output_mutex);
-            switch(data->output_mode) {
-                case MODE_PUBKEY:
-                    print_bytes_hex(data->output_fp, serialized_pubkey, len);
-                    break;
-                case MODE_HASH160: {
-                    unsigned char h160[HASH160_SIZE];
-                    hash160(serialized_pubkey, len, h160);
-                    print_bytes_hex(data->output_fp, h160, HASH160_SIZE);
-                    break;
-                }
-                case MODE_ADDRESS: {
-                    char *addr_str = NULL;
-                    pubkey_to_address(serialized_pubkey, len, &addr_str);
-                    if(addr_str) { fprintf(data->output_fp, "%s", addr_str); free(addr_str); }
-                    break;
-                }
+
+        KangarooResult result = KANGAROO_ERROR;
+        if (ok) {
+            double last_report = 0;
+            active_kangaroo = k;
+            signal(SIGINT, on_interrupt);
+            result = kangaroo_run(k, kangaroo_progress, &last_report);
+            signal(SIGINT, SIG_DFL);
+            active_kangaroo = NULL;
+        }
+        KangarooStats stats;
+        kangaroo_stats(k, &stats);
+        switch (result) {
+            case KANGAROO_SOLVED:
+                kangaroo_key(k, key);
+                key_hex[hex_encode(key_hex, key, 32)] = '\0';
+                fprintf(out, "%s %s\n", pubkey_hex, key_hex);
+                fflush(out);
+                fprintf(stderr, "[+] solved after %.3g jumps in %.1f s\n", (double)stats.jumps, stats.seconds);
+                break;
+            case KANGAROO_STOPPED:
+                fprintf(stderr, "[!] stopped after %.3g jumps, %llu DPs, no collision yet\n",
+                        (double)stats.jumps, (unsigned long long)stats.dps);
+                break;
+            case KANGAROO_TABLE_FULL:
+                fprintf(stderr, "[!] DP table full after %.3g jumps; resume with a larger --dp\n", (double)stats.jumps);
+                break;
+            case KANGAROO_ERROR:
+                if (ok) fprintf(stderr, "Error: Kangaroo threads could not start (out of memory).\n");
+                ok = false;
+                break;
+        }
+        if (opt->save) {
+            long long saved = kangaroo_save(k, opt->save);
+            if (saved < 0) {
+                fprintf(stderr, "Error: Could not write '%s'.\n", opt->save);
+                ok = false;
+            } else {
+                fprintf(stderr, "[+] saved %lld DPs to %s\n", saved, opt->save);
             }
-            if (data->verbose) gmp_fprintf(data->output_fp, " = + 0x%Zx", current_scalar_mpz);
-            fprintf(data->output_fp, "\n");
-            pthread_mutex_unlock(data->output_mutex);
-        }
-
-        // Process subtraction
-        secp256k1_pubkey pubkey_minus = data->pubkey_orig;
-        if (secp256k1_ec_pubkey_tweak_add(data->ctx, &pubkey_minus, neg_scalar_bytes)) {
-            unsigned char serialized_pubkey[33];
-            size_t len = sizeof(serialized_pubkey);
-            secp256k1_ec_pubkey_serialize(data->ctx, serialized_pubkey, &len, &pubkey_minus, SECP256K1_EC_COMPRESSED);
-
-            pthread_mutex_lock(data->output_mutex);
-            switch(data->output_mode) {
-                case MODE_PUBKEY:
-                    print_bytes_hex(data->output_fp, serialized_pubkey, len);
-                    break;
-                case MODE_HASH160: {
-                    unsigned char h160[HASH160_SIZE];
-                    hash160(serialized_pubkey, len, h160);
-                    print_bytes_hex(data->output_fp, h160, HASH160_SIZE);
-                    break;
-                }
-                case MODE_ADDRESS: {
-                    char *addr_str = NULL;
-                    pubkey_to_address(serialized_pubkey, len, &addr_str);
-                    if(addr_str) { fprintf(data->output_fp, "%s", addr_str); free(addr_str); }
-                    break;
-                }
+        }
+        kangaroo_destroy(k);
+    }
+    kangaroo_params_clear(&params);
+    return ok;
+}
+
+void bsgs_progress(const BsgsStats *stats, void *user) {
+    double *last = (double *)user;
+    if (stats->seconds - *last < KANGAROO_REPORT_SECONDS) return;
+    *last = stats->seconds;
+    fprintf(stderr, "[+] bsgs: %.3g / %.3g giant steps, %d found, %.2f Msteps/s\n", (double)stats->giant_steps,
+            (double)stats->giant_total, stats->found, stats->seconds > 0 ? stats->giant_steps / stats->seconds / 1e6 : 0.0);
+}
+
+/* 所有基準公鑰共用一張嬰兒步表，在 [min, max] 內求私鑰，求出的寫成 "<壓縮公鑰> <私鑰>"。
+ * 走完區間沒求出或被中斷不算錯誤；區間非法、表文件損壞、內存不足返回 false。
+ */
+bool run_bsgs(PkcContext *engine, size_t mem_bytes, const char *table_path, mpz_srcptr min, mpz_srcptr max,
+              int threads, TopoPinMode pin, FILE *out) {
+    BsgsParams params;
+    bsgs_params_init(&params);
+    mpz_set(params.min_scalar, min);
+    mpz_set(params.max_scalar, max);
+    params.threads = threads;
+    params.pin = pin;
+    params.mem_bytes = mem_bytes;
+    FILE *existing = table_path ? fopen(table_path, "rb") : NULL;
+    if (existing) fclose(existing);
+    else fprintf(stderr, "[+] bsgs: building the baby-step table...\n");
+    Bsgs *b = bsgs_create(&params, table_path);
+    bsgs_params_clear(&params);
+    if (!b) {
+        if (existing) fprintf(stderr, "Error: '%s' is not a usable bsgs table, or the range needs more than 2^63 giant steps.\n", table_path);
+        else fprintf(stderr, "Error: Could not set up the bsgs solver (invalid range, out of memory or '%s' not writable).\n",
+                     table_path ? table_path : "-");
+        return false;
+    }
+    if (bsgs_table_mapped(b))
+        fprintf(stderr, "[+] bsgs: m = %llu, table %.1f MB mapped from %s\n", (unsigned long long)bsgs_baby_count(b),
+                bsgs_table_bytes(b) / 1048576.0, table_path);
+    else
+        fprintf(stderr, "[+] bsgs: m = %llu, table %.1f MB (%.1f bytes per baby step), %s in %.1f s\n",
+                (unsigned long long)bsgs_baby_count(b), bsgs_table_bytes(b) / 1048576.0,
+                (double)bsgs_table_bytes(b) / bsgs_baby_count(b), existing ? "read" : "built", bsgs_build_seconds(b));
+
+    bool ok = true;
+    for (int i = 0; ok && i < pkc_base_count(engine); ++i) {
+        AffinePoint pt;
+        unsigned char pubkey[33];
+        pkc_base_point(engine, i, &pt);
+        ec_point_serialize(pubkey, &pt, 1);
+        if (bsgs_add_target(b, pubkey, 33) < 0) {
+            fprintf(stderr, "Error: Out of memory adding bsgs targets.\n");
+            ok = false;
+        }
+    }
+    fprintf(stderr, "[+] bsgs: %d keys x %llu giant steps; doubling --bsgs-mem halves the giant steps\n",
+            bsgs_target_count(b), (unsigned long long)bsgs_giant_steps(b));
+
+    int found = -1;
+    if (ok) {
+        double last_report = 0;
+        active_bsgs = b;
+        signal(SIGINT, on_interrupt);
+        found = bsgs_run(b, bsgs_progress, &last_report);
+        signal(SIGINT, SIG_DFL);
+        active_bsgs = NULL;
+        if (found < 0) {
+            fprintf(stderr, "Error: Bsgs threads could not start (out of memory).\n");
+            ok = false;
+        }
+    }
+    if (ok) {
+        for (int i = 0; i < bsgs_target_count(b); ++i) {
+            AffinePoint pt;
+            unsigned char pubkey[33], key[32];
+            char pubkey_hex[67], key_hex[65];
+            if (!bsgs_key(b, i, key)) continue;
+            pkc_base_point(engine, i, &pt);
+            ec_point_serialize(pubkey, &pt, 1);
+            pubkey_hex[hex_encode(pubkey_hex, pubkey, 33)] = '\0';
+            key_hex[hex_encode(key_hex, key, 32)] = '\0';
+            fprintf(out, "%s %s\n", pubkey_hex, key_hex);
+        }
+        fflush(out);
+        BsgsStats stats;
+        bsgs_stats(b, &stats);
+        fprintf(stderr, "[+] bsgs: %d of %d keys found, %.3g giant steps in %.1f s (%.2f Msteps/s)\n", found,
+                bsgs_target_count(b), (double)stats.giant_steps, stats.seconds,
+                stats.seconds > 0 ? stats.giant_steps / stats.seconds / 1e6 : 0.0);
+    }
+    bsgs_destroy(b);
+    return ok;
+}
+
+// 記錄的 x 指紋與 k 的低 64 位
+void join_entry_at(const PkcBatch *batch, size_t i, JoinEntry *e) {
+    const unsigned char *scalar32 = batch->scalars + i * CLONE_SCALAR_SIZE;
+    e->fp = batch->points[i].x.n[0];
+    e->scalar = 0;
+    for (int b = CLONE_SCALAR_SIZE - 8; b < CLONE_SCALAR_SIZE; ++b) e->scalar = e->scalar << 8 | scalar32[b];
+    e->base = (uint32_t)batch->base_index;
+    e->relation = batch->relations[i];
+}
+
+int join_sink(const PkcBatch *batch, void *user) {
+    JoinSink *sink = (JoinSink *)user;
+    JoinEntry e;
+    for (size_t i = 0; i < batch->count; ++i) {
+        join_entry_at(batch, i, &e);
+        if (sink->table ? !join_table_probe(sink->table, &e, &sink->matches[batch->thread_id])
+                        : !join_side_add(sink->side, batch->thread_id, &e)) return 1;
+    }
+    return 0;
+}
+
+typedef struct {
+    const JoinTable *table;
+    JoinMatchList *matches;
+    int failed;
+} JoinScan;
+
+int join_scan_probe(const JoinEntry *e, void *user) {
+    JoinScan *scan = (JoinScan *)user;
+    if (join_table_probe(scan->table, e, scan->matches)) return 0;
+    scan->failed = 1;
+    return 1;
+}
+
+int compare_join_entries(const JoinEntry *x, const JoinEntry *y) {
+    if (x->base != y->base) return x->base < y->base ? -1 : 1;
+    if (x->relation != y->relation) return x->relation < y->relation ? -1 : 1;
+    if (x->scalar != y->scalar) return x->scalar < y->scalar ? -1 : 1;
+    return 0;
+}
+
+int compare_join_matches(const void *a, const void *b) {
+    const JoinMatch *x = (const JoinMatch *)a, *y = (const JoinMatch *)b;
+    int c = compare_join_entries(&x->a, &y->a);
+    return c ? c : compare_join_entries(&x->b, &y->b);
+}
+
+// 記錄只保存 k 的低 64 位；所有 k 落在 [min, min + 2^64) 內時 k = min + ((低位 − min) mod 2^64)
+void join_full_scalar(mpz_srcptr min, uint64_t low, unsigned char *out32) {
+    mpz_t k;
+    mpz_init(k);
+    mpz_import(k, 1, 1, sizeof(low), 0, 0, &low);
+    mpz_sub(k, k, min);
+    mpz_fdiv_r_2exp(k, k, 64);
+    mpz_add(k, k, min);
+    memset(out32, 0, CLONE_SCALAR_SIZE);
+    if (mpz_sgn(k)) mpz_export(out32 + CLONE_SCALAR_SIZE - mpz_sizeinbase(k, 256), NULL, 1, 1, 1, 0, k);
+    mpz_clear(k);
+}
+
+// 一邊記錄的 "<壓縮公鑰> <tag> 0x<k>"
+size_t format_join_side(char *dst, const PkcContext *engine, const JoinEntry *e, const unsigned char *scalar32) {
+    AffinePoint base;
+    unsigned char pubkey[33];
+    pkc_base_point(engine, (int)e->base, &base);
+    ec_point_serialize(pubkey, &base, 1);
+    size_t pos = hex_encode(dst, pubkey, 33);
+    dst[pos++] = ' ';
+    size_t tag_len = strlen(RELATION_TAGS[e->relation]);
+    memcpy(dst + pos, RELATION_TAGS[e->relation], tag_len); pos += tag_len;
+    memcpy(dst + pos, " 0x", 3); pos += 3;
+    return pos + hex_encode_trimmed(dst + pos, scalar32, CLONE_SCALAR_SIZE);
+}
+
+/* A 的記錄收集為指紋表（或分區文件），再生成 B 與之求交。指紋命中後重新計算兩邊的點，
+ * x 相同的寫成一行，按 A、B 的記錄排序。內存不足、分區文件讀寫失敗返回 false。
+ */
+bool run_join(PkcContext *set_a, PkcContext *set_b, const PkcParams *params, size_t mem_bytes,
+              const char *spill_dir, FILE *out) {
+    int threads = pkc_sink_threads(params);
+    double expected = (double)params->count * 2 * (params->endo ? 3 : 1) * pkc_base_count(set_a);
+    int partitions = 1;
+    while (partitions < JOIN_MAX_PARTITIONS && expected * JOIN_TABLE_BYTES_PER_ENTRY / partitions > (double)mem_bytes)
+        partitions <<= 1;
+    char prefix_a[4096], prefix_b[4096];
+    snprintf(prefix_a, sizeof(prefix_a), "%s/pkjoin.%ld.a", spill_dir, (long)getpid());
+    snprintf(prefix_b, sizeof(prefix_b), "%s/pkjoin.%ld.b", spill_dir, (long)getpid());
+    JoinSide *side_a = join_side_create(threads, partitions, partitions > 1 ? prefix_a : NULL);
+    JoinSide *side_b = partitions > 1 ? join_side_create(threads, partitions, prefix_b) : NULL;
+    JoinMatchList *matches = calloc(threads, sizeof(JoinMatchList));
+    if (!side_a || (partitions > 1 && !side_b) || !matches) {
+        fprintf(stderr, "Error: Could not set up the join (out of memory or '%s' not writable).\n", spill_dir);
+        join_side_destroy(side_a);
+        join_side_destroy(side_b);
+        free(matches);
+        return false;
+    }
+    if (partitions > 1)
+        fprintf(stderr, "[+] join: about %.3g records in set A, %d partitions in %s\n", expected, partitions, spill_dir);
+    else
+        fprintf(stderr, "[+] join: about %.3g records in set A, table in memory\n", expected);
+
+    JoinSink sink = { side_a, NULL, matches };
+    bool ok = pkc_run(set_a, params, join_sink, &sink) == 0 && join_side_finish(side_a);
+    uint64_t count_a = join_side_count(side_a);
+    if (ok && partitions == 1) {
+        // A 在內存中：B 在它的哈希執行緒裏直接查表，不落地
+        JoinTable table;
+        ok = join_table_build(&table, side_a, 0);
+        if (ok) {
+            sink.table = &table;
+            ok = pkc_run(set_b, params, join_sink, &sink) == 0;
+            join_table_free(&table);
+        }
+    } else if (ok) {
+        sink.side = side_b;
+        ok = pkc_run(set_b, params, join_sink, &sink) == 0 && join_side_finish(side_b);
+        for (int p = 0; ok && p < partitions; ++p) {
+            JoinTable table;
+            JoinScan scan = { &table, &matches[0], 0 };
+            ok = join_table_build(&table, side_a, p);
+            if (ok) {
+                ok = join_side_scan(side_b, p, join_scan_probe, &scan) && !scan.failed;
+                join_table_free(&table);
             }
-            if (data->verbose) gmp_fprintf(data->output_fp, " = - 0x%Zx", current_scalar_mpz);
-            fprintf(data->output_fp, "\n");
-            pthread_mutex_unlock(data->output_mutex);
         }
+    }
+    join_side_destroy(side_a);
+    join_side_destroy(side_b);
 
-        if (!data->random_mode) {
-            mpz_add_ui(current_scalar_mpz, current_scalar_mpz, 1);
+    size_t candidates = 0, written = 0;
+    for (int t = 0; t < threads; ++t) candidates += matches[t].count;
+    JoinMatch *all = candidates ? malloc(candidates * sizeof(JoinMatch)) : NULL;
+    if (ok && candidates && !all) ok = false;
+    if (!ok) fprintf(stderr, "Error: Join failed (invalid range, out of memory or partition file I/O error).\n");
+    size_t filled = 0;
+    for (int t = 0; t < threads; ++t) {
+        if (ok && matches[t].count) memcpy(all + filled, matches[t].items, matches[t].count * sizeof(JoinMatch));
+        filled += matches[t].count;
+        join_match_free(&matches[t]);
+    }
+    free(matches);
+    if (ok) {
+        qsort(all, candidates, sizeof(JoinMatch), compare_join_matches);
+        char line[2 * (66 + 8 + 2 * CLONE_SCALAR_SIZE) + 8];
+        for (size_t i = 0; i < candidates; ++i) {
+            const JoinMatch *m = &all[i];
+            unsigned char scalar_a[CLONE_SCALAR_SIZE], scalar_b[CLONE_SCALAR_SIZE];
+            AffinePoint pa, pb;
+            join_full_scalar(params->min_scalar, m->a.scalar, scalar_a);
+            join_full_scalar(params->min_scalar, m->b.scalar, scalar_b);
+            // 指紋只有 64 位：x 完全相同才算
+            if (!pkc_record_point(set_a, (int)m->a.base, (int)m->a.relation, scalar_a, &pa)
+                || !pkc_record_point(set_b, (int)m->b.base, (int)m->b.relation, scalar_b, &pb)
+                || !fe_equal(&pa.x, &pb.x)) continue;
+            size_t pos = format_join_side(line, set_a, &m->a, scalar_a);
+            line[pos++] = ' ';
+            pos += format_join_side(line + pos, set_b, &m->b, scalar_b);
+            pos += (size_t)sprintf(line + pos, " %s\n", fe_equal(&pa.y, &pb.y) ? "same" : "neg");
+            fwrite(line, 1, pos, out);
+            written++;
         }
+        fflush(out);
+        fprintf(stderr, "[+] join: %llu records in set A, %zu fingerprint hits, %zu pairs\n",
+                (unsigned long long)count_a, candidates, written);
+    }
+    free(all);
+    return ok;
+}
+
+/* 分節名 "<壓縮公鑰>/<-m 集合>[+endo]/<下標空間>"，下標空間為
+ *   inc:<step>:<offset>             增量，k = i·step + offset
+ *   perm:<key>:<min>:<max>:<step>   --permute 的置換下標，同一 key 與區間才可比
+ *   rand:<min>:<max>:<step>         -R，只記抽樣次數
+ * --skip-covered 與分段運行（params->count 為 0）時下標空間一直延伸到 range_end（增量）
+ * 或最後一個置換下標。
+ */
+bool coverage_plan_init(CoveragePlan *plan, const char *path, bool skip, const PkcContext *engine,
+                        const OutputSpec *out, const PkcParams *params, mpz_srcptr range_end) {
+    plan->path = path;
+    plan->skip = skip;
+    plan->space = !params->random_mode ? COVER_SPACE_INCREMENTAL : params->permute ? COVER_SPACE_PERMUTE : COVER_SPACE_RANDOM;
+    plan->base_count = pkc_base_count(engine);
+    plan->names = calloc(plan->base_count, sizeof(char *));
+    mpz_inits(plan->first, plan->last, plan->offset, NULL);
+    cover_init(&plan->known);
+    cover_init(&plan->done);
+    if (skip && !cover_load(&plan->known, path)) {
+        fprintf(stderr, "Error: '%s' is not a coverage file.\n", path);
+        return false;
+    }
+
+    char modes[64] = "", space[COVER_NAME_MAX], key_hex[2 * FEISTEL_KEY_SIZE + 1];
+    for (int m = 0; m < MODE_COUNT; ++m) {
+        if (!out->need[m]) continue;
+        if (modes[0]) strcat(modes, ",");
+        strcat(modes, MODE_NAMES[m]);
+    }
+    if (params->endo) strcat(modes, "+endo");
+    switch (plan->space) {
+        case COVER_SPACE_INCREMENTAL:
+            mpz_fdiv_qr(plan->first, plan->offset, params->min_scalar, params->step);
+            if (skip || params->count == 0) {
+                mpz_sub(plan->last, range_end, plan->offset);
+                mpz_fdiv_q(plan->last, plan->last, params->step);
+            } else {
+                pkc_mpz_set_count(plan->last, params->count - 1);
+                mpz_add(plan->last, plan->last, plan->first);
+            }
+            gmp_snprintf(space, sizeof(space), "inc:%Zx:%Zx", params->step, plan->offset);
+            break;
+        case COVER_SPACE_PERMUTE:
+            mpz_set(plan->first, params->perm_start);
+            if (skip || params->count == 0) {
+                pkc_range_terms(params, plan->last);
+                mpz_sub_ui(plan->last, plan->last, 1);
+            } else {
+                pkc_mpz_set_count(plan->last, params->count - 1);
+                mpz_add(plan->last, plan->last, plan->first);
+            }
+            key_hex[hex_encode(key_hex, params->perm_key, FEISTEL_KEY_SIZE)] = '\0';
+            gmp_snprintf(space, sizeof(space), "perm:%s:%Zx:%Zx:%Zx", key_hex, params->min_scalar, params->max_scalar, params->step);
+            break;
+        case COVER_SPACE_RANDOM:
+            gmp_snprintf(space, sizeof(space), "rand:%Zx:%Zx:%Zx", params->min_scalar, params->max_scalar, params->step);
+            break;
+    }
+    for (int b = 0; plan->names && b < plan->base_count; ++b) {
+        AffinePoint pt;
+        unsigned char pubkey[33];
+        char pubkey_hex[67];
+        pkc_base_point(engine, b, &pt);
+        ec_point_serialize(pubkey, &pt, 1);
+        pubkey_hex[hex_encode(pubkey_hex, pubkey, 33)] = '\0';
+        size_t len = strlen(pubkey_hex) + strlen(modes) + strlen(space) + 3;
+        if (!(plan->names[b] = malloc(len))) break;
+        snprintf(plan->names[b], len, "%s/%s/%s", pubkey_hex, modes, space);
+    }
+    if (!plan->names || (plan->base_count && !plan->names[plan->base_count - 1])) {
+        fprintf(stderr, "Error: Out of memory.\n");
+        return false;
+    }
+    return true;
+}
+
+void coverage_plan_free(CoveragePlan *plan) {
+    for (int b = 0; plan->names && b < plan->base_count; ++b) free(plan->names[b]);
+    free(plan->names);
+    mpz_clears(plan->first, plan->last, plan->offset, NULL);
+    cover_free(&plan->known);
+    cover_free(&plan->done);
+}
+
+double seconds_since(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* 分段運行引擎：每段是下一段空隙（--skip-covered）或接著上一段的下標，段結束後
+ * 把它併入覆蓋文件。被中斷時已完成的段都已記錄。一共運行 total 個標量（NULL 時為
+ * params->count，0 時不限，直到下標空間走完）。返回值同 pkc_run。
+ */
+int run_with_coverage(PkcContext *engine, PkcParams *params, PkcBatchFn fn, void *user, CoveragePlan *plan, mpz_srcptr total) {
+    CoverMap scratch;
+    cover_init(&scratch);
+    const CoverSection *covered = NULL;
+    mpz_t cur, gap_lo, gap_hi, value, remaining, recorded;
+    mpz_inits(cur, gap_lo, gap_hi, value, remaining, recorded, NULL);
+    if (total) mpz_set(remaining, total);
+    else pkc_mpz_set_count(remaining, params->count);
+    bool limited = mpz_sgn(remaining) > 0;
+    int result = 0;
+    if (plan->skip) {
+        // 只有所有基準公鑰都覆蓋了的下標才跳過
+        CoverSection *acc = cover_find(&scratch, "acc", 1), *tmp = cover_find(&scratch, "tmp", 1);
+        if (!acc || !tmp) result = -1;
+        for (int b = 0; result == 0 && b < plan->base_count; ++b) {
+            const CoverSection *s = cover_find(&plan->known, plan->names[b], 0);
+            if (!cover_intersect(tmp, b == 0 ? s : acc, s)) result = -1;
+            CoverSection *swap = acc; acc = tmp; tmp = swap;
+        }
+        covered = acc;
+        cover_count(covered, plan->first, plan->last, value);
+        mpz_sub(gap_hi, plan->last, plan->first);
+        mpz_add_ui(gap_hi, gap_hi, 1);
+        if (result == 0)
+            gmp_fprintf(stderr, "[+] coverage: %Zd of %Zd indices already covered for every key\n", value, gap_hi);
+    }
+
+    struct timespec start;
+    long long chunk = COVERAGE_FIRST_CHUNK;
+    unsigned long seed = params->seed ? params->seed : (unsigned long)time(NULL) ^ (unsigned long)getpid();
+    bool warned = false;
+    mpz_set(cur, plan->first);
+    for (unsigned long segment = 0; result == 0 && (!limited || mpz_sgn(remaining) > 0); ++segment) {
+        long long n = chunk;
+        pkc_mpz_set_count(value, n);
+        if (limited && mpz_cmp(remaining, value) < 0) pkc_mpz_get_count(remaining, &n);
+        if (plan->space == COVER_SPACE_RANDOM) {
+            // 每段重新播種，各段的抽樣互不相同
+            params->seed = seed + segment * 0x9e3779b9UL;
+        } else {
+            if (!cover_first_gap(covered, cur, plan->last, gap_lo, gap_hi)) break;
+            mpz_sub(value, gap_hi, gap_lo);
+            mpz_add_ui(value, value, 1);
+            long long gap;
+            if (pkc_mpz_get_count(value, &gap) && gap < n) n = gap;
+            if (plan->space == COVER_SPACE_INCREMENTAL) {
+                mpz_mul(params->min_scalar, gap_lo, params->step);
+                mpz_add(params->min_scalar, params->min_scalar, plan->offset);
+            } else {
+                mpz_set(params->perm_start, gap_lo);
+            }
+        }
+        params->count = n;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        result = pkc_run(engine, params, fn, user);
+        if (result != 0) break;
+        double elapsed = seconds_since(&start);
+
+        pkc_mpz_set_count(value, n);
+        if (limited) mpz_sub(remaining, remaining, value);
+        mpz_add(recorded, recorded, value);
+        mpz_sub_ui(value, value, 1);
+        mpz_add(value, value, gap_lo);
+        for (int b = 0; b < plan->base_count; ++b) {
+            CoverSection *s = cover_find(&plan->done, plan->names[b], 1);
+            if (!s) continue;
+            if (plan->space != COVER_SPACE_RANDOM) {
+                cover_add(s, gap_lo, value);
+            } else {
+                mpz_t draws;
+                mpz_init(draws);
+                pkc_mpz_set_count(draws, n);
+                cover_add_draws(s, draws);
+                mpz_clear(draws);
+            }
+        }
+        if (!cover_flush(plan->path, &plan->done) && !warned) {
+            fprintf(stderr, "[!] Could not update the coverage file '%s'.\n", plan->path);
+            warned = true;
+        }
+        mpz_add_ui(cur, value, 1);
+        if (elapsed < COVERAGE_FLUSH_SECONDS / 2.0 && chunk < LLONG_MAX / 2) chunk *= 2;
+    }
+    if (result == 0 && plan->skip && mpz_sgn(recorded) == 0)
+        fprintf(stderr, "[+] coverage: nothing left to run in this range\n");
+    else if (result >= 0)
+        gmp_fprintf(stderr, "[+] coverage: %Zd %s recorded in %s\n", recorded,
+                    plan->space == COVER_SPACE_RANDOM ? "draws" : "indices", plan->path);
+    mpz_clears(cur, gap_lo, gap_hi, value, remaining, recorded, NULL);
+    cover_free(&scratch);
+    return result;
+}
+
+/* -n 0 或 -n 不小於 2^63：每段至多 STREAM_CHUNK 個標量，段的起點 k（--permute 時為置換下標）
+ * 用 mpz 累加，所以 -b 256 的整個範圍也能一段段走完，寫出流水線在段之間不停。
+ * total 為 0 時（-R 不帶 --permute）一直運行到 Ctrl-C。被 Ctrl-C 停下時打印續跑的起點並返回 1，
+ * 其餘返回值同 pkc_run。
+ */
+int run_streaming(PkcContext *engine, PkcParams *params, PkcBatchFn fn, void *user, mpz_srcptr total) {
+    mpz_t remaining, done, value;
+    mpz_init_set(remaining, total);
+    mpz_inits(done, value, NULL);
+    bool limited = mpz_sgn(total) > 0;
+    unsigned long seed = params->seed ? params->seed : (unsigned long)time(NULL) ^ (unsigned long)getpid();
+    int result = 0;
+    for (unsigned long segment = 0; result == 0 && (!limited || mpz_sgn(remaining) > 0); ++segment) {
+        long long n = STREAM_CHUNK;
+        pkc_mpz_set_count(value, n);
+        if (limited && mpz_cmp(remaining, value) < 0) pkc_mpz_get_count(remaining, &n);
+        // 每段重新播種，各段的抽樣互不相同
+        if (params->random_mode && !params->permute) params->seed = seed + segment * 0x9e3779b9UL;
+        params->count = n;
+        result = pkc_run(engine, params, fn, user);
+        if (result != 0) break;
+        pkc_mpz_set_count(value, n);
+        if (limited) mpz_sub(remaining, remaining, value);
+        mpz_add(done, done, value);
+        if (!params->random_mode) mpz_addmul(params->min_scalar, value, params->step);
+        else if (params->permute) mpz_add(params->perm_start, params->perm_start, value);
+    }
+    if (result == 1 && !params->random_mode)
+        gmp_fprintf(stderr, "[+] stopped: %Zd scalars per key done in full segments, continue from k = %Zx\n",
+                    done, params->min_scalar);
+    else if (result == 1 && params->permute)
+        gmp_fprintf(stderr, "[+] stopped: %Zd indices per key done in full segments, continue with --perm-start %Zx\n",
+                    done, params->perm_start);
+    else if (result == 1)
+        gmp_fprintf(stderr, "[+] stopped: %Zd draws per key done in full segments\n", done);
+    mpz_clears(remaining, done, value, NULL);
+    return result;
+}
+
+/* 流水線：EC 執行緒 → 哈希 + 格式化執行緒 (clone_sink) → 寫出執行緒。
+ * plan 非 NULL 時分段運行並記錄覆蓋；total 非 NULL 時分段運行 total 個標量（見 run_streaming），
+ * 否則運行 params->count 個。返回值同 pkc_run，流水線建不起來時返回 -1。
+ */
+int run_pipeline(PkcContext *engine, PkcParams *params, OutputSpec *output, bool verbose, CoveragePlan *plan, mpz_srcptr total) {
+    int sink_threads = pkc_sink_threads(params);
+    CloneSink sink = { output, verbose, pkc_base_count(engine) > 1, calloc(sink_threads, sizeof(RecordWriter)) };
+    WriterStage stage = { sink.writers, malloc(sink_threads * sizeof(SpscRing *)), sink_threads,
+                          output->spliced ? &output->pipe : NULL };
+    pthread_t writer;
+    bool ok = sink.writers != NULL && stage.rings != NULL;
+    int writers_ready = 0;
+    for (; ok && writers_ready < sink_threads; writers_ready++) {
+        ok = record_writer_init(&sink.writers[writers_ready], output, true);
+        if (ok) stage.rings[writers_ready] = &sink.writers[writers_ready].full;
+    }
+    bool writer_started = ok && pthread_create(&writer, NULL, writer_thread, &stage) == 0;
+    int result = !writer_started ? -1
+               : plan ? run_with_coverage(engine, params, clone_sink, &sink, plan, total)
+               : total ? run_streaming(engine, params, clone_sink, &sink, total)
+               : pkc_run(engine, params, clone_sink, &sink);
+    for (int i = 0; i < writers_ready; i++) record_writer_close(&sink.writers[i]);
+    if (writer_started) pthread_join(writer, NULL);
+    for (int i = 0; i < writers_ready; i++) record_writer_free(&sink.writers[i]);
+    free(sink.writers);
+    free(stage.rings);
+    return result;
+}
+
+// --verify：哈希執行緒只查指紋並入隊，複核執行緒按批重算並寫出確認的命中
+typedef struct {
+    const PkcContext *engine;
+    const HitTargets *targets;
+    HitQueue queue;
+    unsigned forms;             // 要比較的 hash160：PKC_FORM_H160 / PKC_FORM_H160_U
+    FILE *out;
+    mpz_t n;
+    unsigned long long candidates, confirmed, dropped;
+} HitVerifier;
+
+int verify_predicate(const unsigned char *h160, void *user) {
+    return hit_targets_maybe((const HitTargets *)user, h160);
+}
+
+// 經過指紋的記錄都是候選；入隊只持鎖追加，不等複核
+int verify_sink(const PkcBatch *batch, void *user) {
+    HitVerifier *v = (HitVerifier *)user;
+    if (clone_interrupted) return 1;
+    for (size_t i = 0; i < batch->count; ++i)
+        hit_queue_push(&v->queue, batch->base_index, batch->relations[i], batch->scalars + i * CLONE_SCALAR_SIZE);
+    return 0;
+}
+
+/* 確認的命中一行："<基準公鑰> <tag> 0x<標量> <克隆公鑰> <hash160> p = 0x<c>*q + 0x<d>"，
+ * p 為基準公鑰的私鑰，q 為命中目標的私鑰；由 Q = a·P + b·G 得 c = a^-1，d = −b·a^-1（mod n）。
+ */
+void write_verified_hit(HitVerifier *v, const HitCandidate *c, const unsigned char *key, size_t key_len,
+                        const unsigned char *h160, mpz_srcptr a, mpz_srcptr b) {
+    char line[2 * 33 + 2 * 65 + 2 * HASH160_SIZE + 2 * CLONE_SCALAR_SIZE * 3 + 80];
+    AffinePoint base;
+    unsigned char pubkey[33];
+    mpz_t coef, shift;
+    mpz_inits(coef, shift, NULL);
+    mpz_invert(coef, a, v->n);
+    mpz_mul(shift, b, coef);
+    mpz_neg(shift, shift);
+    mpz_mod(shift, shift, v->n);
+
+    pkc_base_point(v->engine, c->base_index, &base);
+    ec_point_serialize(pubkey, &base, 1);
+    size_t pos = hex_encode(line, pubkey, 33);
+    line[pos++] = ' ';
+    size_t tag_len = strlen(RELATION_TAGS[c->relation]);
+    memcpy(line + pos, RELATION_TAGS[c->relation], tag_len); pos += tag_len;
+    if (c->relation == CLONE_REL_GRID) {
+        pos += format_grid_label(line + pos, c->scalar);
+    } else {
+        memcpy(line + pos, " 0x", 3); pos += 3;
+        pos += hex_encode_trimmed(line + pos, c->scalar, CLONE_SCALAR_SIZE);
     }
+    line[pos++] = ' ';
+    pos += hex_encode(line + pos, key, key_len);
+    line[pos++] = ' ';
+    pos += hex_encode(line + pos, h160, HASH160_SIZE);
+    memcpy(line + pos, " p = 0x", 7); pos += 7;
+    pos += hex_encode_mpz(line + pos, coef);
+    // 大於 n/2 的 d 寫成 − (n − d)，± 族即 p = q − k
+    mpz_mul_2exp(coef, shift, 1);
+    bool negative = mpz_cmp(coef, v->n) > 0;
+    if (negative) mpz_sub(shift, v->n, shift);
+    memcpy(line + pos, negative ? "*q - 0x" : "*q + 0x", 7); pos += 7;
+    pos += hex_encode_mpz(line + pos, shift);
+    line[pos++] = '\n';
+    fwrite(line, 1, pos, v->out);
+    mpz_clears(coef, shift, NULL);
+}
 
-    mpz_clears(current_scalar_mpz, neg_current_scalar_mpz, NULL);
+// 每次取走隊列中的全部候選：化成標量關係，用 libsecp256k1 重算點，完整比較 hash160
+void *verify_thread(void *arg) {
+    HitVerifier *v = (HitVerifier *)arg;
+    HitCandidate *items;
+    size_t count;
+    mpz_t a, b;
+    mpz_inits(a, b, NULL);
+    while ((count = hit_queue_take(&v->queue, &items)) > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            const HitCandidate *c = &items[i];
+            AffinePoint pt;
+            unsigned char pubkey[33], pubkey_u[65], h160[HASH160_SIZE];
+            bool hit = false;
+            if (pkc_record_relation(v->engine, c->relation, c->scalar, a, b)
+                && pkc_relation_point(v->engine, c->base_index, a, b, &pt)) {
+                if (v->forms & PKC_FORM_H160) {
+                    ec_point_serialize(pubkey, &pt, 1);
+                    pkc_hash160(pubkey, 33, h160);
+                    if (hit_targets_contains(v->targets, h160)) {
+                        write_verified_hit(v, c, pubkey, 33, h160, a, b);
+                        hit = true;
+                    }
+                }
+                if (v->forms & PKC_FORM_H160_U) {
+                    ec_point_serialize(pubkey_u, &pt, 0);
+                    pkc_hash160(pubkey_u, 65, h160);
+                    if (hit_targets_contains(v->targets, h160)) {
+                        write_verified_hit(v, c, pubkey_u, 65, h160, a, b);
+                        hit = true;
+                    }
+                }
+            }
+            if (hit) v->confirmed++;
+            else v->dropped++;
+        }
+        v->candidates += count;
+        fflush(v->out);
+        free(items);
+    }
+    mpz_clears(a, b, NULL);
     return NULL;
 }
 
+/* 流水線：EC 執行緒 → 哈希執行緒（params 中的指紋謂詞 + verify_sink）→ 複核執行緒。
+ * plan、total 的含義同 run_pipeline；返回值同 pkc_run，建不起複核執行緒時返回 -1。
+ */
+int run_verify(PkcContext *engine, PkcParams *params, const HitTargets *targets, FILE *out, CoveragePlan *plan,
+               mpz_srcptr total) {
+    HitVerifier v = { engine, targets, .forms = params->forms, .out = out };
+    if (!hit_queue_init(&v.queue)) return -1;
+    mpz_init_set_str(v.n, SECP256K1_N_HEX, 16);
+    pthread_t verifier;
+    bool started = pthread_create(&verifier, NULL, verify_thread, &v) == 0;
+    int result = !started ? -1
+               : plan ? run_with_coverage(engine, params, verify_sink, &v, plan, total)
+               : total ? run_streaming(engine, params, verify_sink, &v, total)
+               : pkc_run(engine, params, verify_sink, &v);
+    hit_queue_close(&v.queue);
+    if (started) pthread_join(verifier, NULL);
+    if (started)
+        fprintf(stderr, "[+] verify: %llu candidates, %llu confirmed, %llu fingerprint false positives dropped\n",
+                v.candidates, v.confirmed, v.dropped);
+    if (v.queue.failed) fprintf(stderr, "[!] verify: out of memory, some candidates were lost\n");
+    hit_queue_free(&v.queue);
+    mpz_clear(v.n);
+    return result;
+}
 
-int main(int argc, char **argv) {
+/* --verify 的目標：公鑰、hash160 或地址，每行一個；無法識別的行只報告 */
+bool load_hit_targets(HitTargets *targets, const char *path, int threads) {
+    KeyList keys;
+    if (!keylist_load(&keys, path, threads, KEYLIST_PUBKEY | KEYLIST_H160)) {
+        fprintf(stderr, "Error: Could not load verify targets from '%s'.\n", path);
+        return false;
+    }
+    size_t off_curve = 0;
+    bool ok = hit_targets_build(targets, &keys, &off_curve);
+    fprintf(stderr, "[+] verify: %zu public keys and %zu hash160s from %s (%zu lines), %zu distinct hash160s\n",
+            keys.pubkey_count, keys.h160_count, path, keys.line_count, ok ? targets->count : 0);
+    for (size_t b = 0; b < keys.bad_count && b < KEYLIST_BAD_REPORT; ++b)
+        fprintf(stderr, "[!] line %zu: not a public key, hash160 or address, skipped\n", keys.bad_lines[b]);
+    if (keys.bad_count > KEYLIST_BAD_REPORT)
+        fprintf(stderr, "[!] ... %zu unparsable lines in total\n", keys.bad_count);
+    if (off_curve) fprintf(stderr, "[!] %zu public keys are not on the curve; only their compressed hash160 is used\n", off_curve);
+    keylist_free(&keys);
+    if (!ok) fprintf(stderr, "Error: No verify targets in '%s' (or out of memory).\n", path);
+    return ok;
+}
+
+/* --cache：增量克隆按對齊的下標段 [j·S, (j+1)·S) 緩存（S = CACHE_SEGMENT_TERMS，
+ * 下標 i = (k − offset) / step），不滿一段的頭尾照常計算。每個基準公鑰、每段、每種格式
+ * 一個條目；缺的格式用只含該公鑰的引擎生成進緩存，再按段順序從緩存複製到輸出。
+ * 返回值同 pkc_run。
+ */
+int run_cached(PkcContext *engine, PkcParams *params, OutputSpec *output, const char *dir, uint64_t max_bytes) {
+    mpz_t first, offset, seg_lo, seg_end, value, saved_min;
+    mpz_inits(first, offset, seg_lo, seg_end, value, NULL);
+    mpz_init_set(saved_min, params->min_scalar);
+    long long saved_count = params->count;
+    mpz_fdiv_qr(first, offset, params->min_scalar, params->step);
+    mpz_cdiv_q_ui(seg_lo, first, CACHE_SEGMENT_TERMS);
+    pkc_mpz_set_count(value, params->count);
+    mpz_add(value, value, first);
+    mpz_fdiv_q_ui(seg_end, value, CACHE_SEGMENT_TERMS);
+    if (mpz_cmp(seg_lo, seg_end) >= 0) {
+        // 範圍裏沒有完整的段
+        mpz_clears(first, offset, seg_lo, seg_end, value, saved_min, NULL);
+        return run_pipeline(engine, params, output, false, NULL, NULL);
+    }
+    mpz_mul_ui(value, seg_lo, CACHE_SEGMENT_TERMS);
+    mpz_sub(value, value, first);
+    long long head = 0;
+    pkc_mpz_get_count(value, &head);
+    long long segments = 0;
+    mpz_sub(value, seg_end, seg_lo);
+    pkc_mpz_get_count(value, &segments);
+    long long tail = params->count - head - segments * CACHE_SEGMENT_TERMS;
+
+    int result = 0;
+    long long hits = 0, computed = 0;
+    int files = output->split ? output->mode_count : 1;
+    if (head > 0) {
+        params->count = head;
+        result = run_pipeline(engine, params, output, false, NULL, NULL);
+    }
+    for (int b = 0; result == 0 && b < pkc_base_count(engine); ++b) {
+        AffinePoint pt;
+        unsigned char pubkey[33];
+        char pubkey_hex[67];
+        pkc_base_point(engine, b, &pt);
+        ec_point_serialize(pubkey, &pt, 1);
+        pubkey_hex[hex_encode(pubkey_hex, pubkey, 33)] = '\0';
+        PkcContext *single = pkc_create();
+        if (!single || pkc_add_base(single, pubkey, 33) < 0) result = -1;
+        for (long long s = 0; result == 0 && s < segments; ++s) {
+            // 分段鍵：決定條目內容的全部參數，格式由文件後綴區分
+            char key[512], name[SEGCACHE_NAME_LEN + 1], path[4096];
+            pkc_mpz_set_count(value, s);
+            mpz_add(value, value, seg_lo);
+            gmp_snprintf(key, sizeof(key), "pkclone-v%d|%s|shift%s|inc:%Zx:%Zx|seg:%Zx*%x", CLONE_FILE_VERSION, pubkey_hex,
+                         params->endo ? "+endo" : "", params->step, offset, value, CACHE_SEGMENT_TERMS);
+            segcache_name(key, name);
+
+            OutputSpec missing;
+            memset(&missing, 0, sizeof(missing));
+            missing.split = true;
+            missing.binary = true;
+            for (int i = 0; i < files; ++i) {
+                OutputMode mode = output->modes[i];
+                if (segcache_hit(dir, name, MODE_NAMES[mode])) continue;
+                missing.modes[missing.mode_count++] = mode;
+                missing.need[mode] = true;
+            }
+            if (missing.mode_count > 0) {
+                // 寫到 <name>.tmp<pid>.<格式>，完整後才改名為條目
+                char tmp_base[4000], tmp_path[4096];
+                snprintf(tmp_base, sizeof(tmp_base), "%s/%s.tmp%ld", dir, name, (long)getpid());
+                params->forms = engine_forms(&missing);
+                mpz_mul_ui(params->min_scalar, value, CACHE_SEGMENT_TERMS);
+                mpz_mul(params->min_scalar, params->min_scalar, params->step);
+                mpz_add(params->min_scalar, params->min_scalar, offset);
+                params->count = CACHE_SEGMENT_TERMS;
+                result = open_outputs(&missing, tmp_base) ? run_pipeline(single, params, &missing, false, NULL, NULL) : -1;
+                for (int i = 0; i < missing.mode_count; ++i)
+                    if (missing.fps[i] && ferror(missing.fps[i])) result = -1;
+                close_outputs(&missing);
+                for (int i = 0; i < missing.mode_count; ++i) {
+                    output_path(&missing, tmp_base, i, tmp_path, sizeof(tmp_path));
+                    segcache_path(dir, name, MODE_NAMES[missing.modes[i]], path, sizeof(path));
+                    if (result != 0 || rename(tmp_path, path) != 0) {
+                        remove(tmp_path);
+                        result = -1;
+                    }
+                }
+                params->forms = engine_forms(output);
+                computed++;
+            } else {
+                hits++;
+            }
+            for (int i = 0; result == 0 && i < files; ++i) {
+                OutputMode mode = output->modes[i];
+                segcache_path(dir, name, MODE_NAMES[mode], path, sizeof(path));
+                if (segcache_copy(path, CLONE_HEADER_SIZE, clone_record_size(MODE_KEY_LEN[mode]), output->fps[i]) < 0) {
+                    fprintf(stderr, "Error: Could not read the cache entry '%s'.\n", path);
+                    result = -1;
+                }
+            }
+        }
+        pkc_destroy(single);
+    }
+    if (result == 0 && tail > 0) {
+        mpz_mul_ui(params->min_scalar, seg_end, CACHE_SEGMENT_TERMS);
+        mpz_mul(params->min_scalar, params->min_scalar, params->step);
+        mpz_add(params->min_scalar, params->min_scalar, offset);
+        params->count = tail;
+        result = run_pipeline(engine, params, output, false, NULL, NULL);
+    }
+    mpz_set(params->min_scalar, saved_min);
+    params->count = saved_count;
+
+    uint64_t evicted = segcache_evict(dir, max_bytes);
+    if (result == 0)
+        fprintf(stderr, "[+] cache: %lld segments read from %s, %lld computed, %.1f MB evicted\n",
+                hits, dir, computed, evicted / 1048576.0);
+    mpz_clears(first, offset, seg_lo, seg_end, value, saved_min, NULL);
+    return result;
+}
+
+int clone_main(int argc, char **argv) {
     if (argc < 2) {
         print_usage(argv[0]);
         return 1;
@@ -263,36 +1778,226 @@ int main(int argc, char **argv) {
     
     long long count = 1;
     int num_threads = 1;
+    int hash_threads = 0;
+    TopoPinMode pin_mode = TOPO_PIN_NONE;
     bool verbose = false;
     bool random_mode = false;
     const char *bitrange_param = NULL;
     const char *range_param = NULL;
     const char *output_filename = NULL;
-    OutputMode output_mode = MODE_PUBKEY;
+    const char *step_param = NULL;
+    bool split_output = false;
+    bool endo = false;
+    bool binary_output = false;
+    bool sort_output = false;
+    const char *sort_input = NULL;
+    long sort_mem_mb = 1024;
+    uint32_t div_min = 2, div_max = 2;
+    int div_iterations = 1;
+    bool div_given = false;
+    bool mul_inverse = false;
+    bool count_given = false;
+    bool kangaroo = false;
+    KangarooOptions kangaroo_opt = { .dp_bits = -1 };
+    bool bsgs = false;
+    long bsgs_mem_mb = BSGS_DEFAULT_MEM_MB;
+    const char *bsgs_table = NULL;
+    bool autotune = false;
+    bool no_splice = false;
+    bool permute = false;
+    const char *perm_key_param = NULL;
+    const char *perm_start_param = NULL;
+    const char *join_keys = NULL;
+    long join_mem_mb = JOIN_DEFAULT_MEM_MB;
+    const char *join_dir = NULL;
+    const char *coverage_path = NULL;
+    bool skip_covered = false;
+    const char *cache_dir = NULL;
+    long cache_mb = CACHE_DEFAULT_MB;
+    const char *verify_path = NULL;
+    unsigned tune_fixed = 0;            // 命令行明確給出的項，調優與配置文件都不改
+    H160Filter filter;
+    h160_filter_init(&filter);
+    OutputSpec output;
+    PkcFamily family;
+    parse_output_modes("p", &output, &family);
 
-    mpz_t min_scalar, max_scalar, n;
-    mpz_inits(min_scalar, max_scalar, n, NULL);
+    mpz_t min_scalar, max_scalar, n, step, total;
+    mpz_inits(min_scalar, max_scalar, n, step, total, NULL);
     mpz_set_str(n, SECP256K1_N_HEX, 16);
+    mpz_set_ui(step, 1);
+    mpz_set_ui(total, 1);
+
+    enum { OPT_STEP = 256, OPT_SPLIT, OPT_ENDO, OPT_BINARY, OPT_SORT, OPT_SORT_INPUT, OPT_SORT_MEM, OPT_BACKEND, OPT_HASH_THREADS, OPT_AFFINITY, OPT_NUMA, OPT_DIV, OPT_ITER, OPT_INVERSE,
+           OPT_KANGAROO, OPT_DP, OPT_DP_LOAD, OPT_DP_SAVE, OPT_BSGS, OPT_BSGS_MEM, OPT_BSGS_TABLE,
+           OPT_AUTOTUNE, OPT_H160_PREFIX, OPT_H160_MASK, OPT_ADDR_PREFIX, OPT_NO_SPLICE,
+           OPT_PERMUTE, OPT_PERM_KEY, OPT_PERM_START, OPT_JOIN, OPT_JOIN_MEM, OPT_JOIN_DIR,
+           OPT_COVERAGE, OPT_SKIP_COVERED, OPT_CACHE, OPT_CACHE_SIZE, OPT_VERIFY };
+    static const struct option long_options[] = {
+        {"step", required_argument, NULL, OPT_STEP},
+        {"split", no_argument, NULL, OPT_SPLIT},
+        {"endo", no_argument, NULL, OPT_ENDO},
+        {"binary", no_argument, NULL, OPT_BINARY},
+        {"sort", no_argument, NULL, OPT_SORT},
+        {"sort-input", required_argument, NULL, OPT_SORT_INPUT},
+        {"sort-mem", required_argument, NULL, OPT_SORT_MEM},
+        {"backend", required_argument, NULL, OPT_BACKEND},
+        {"hash-threads", required_argument, NULL, OPT_HASH_THREADS},
+        {"affinity", no_argument, NULL, OPT_AFFINITY},
+        {"numa", no_argument, NULL, OPT_NUMA},
+        {"div", required_argument, NULL, OPT_DIV},
+        {"iter", required_argument, NULL, OPT_ITER},
+        {"inverse", no_argument, NULL, OPT_INVERSE},
+        {"kangaroo", no_argument, NULL, OPT_KANGAROO},
+        {"dp", required_argument, NULL, OPT_DP},
+        {"dp-load", required_argument, NULL, OPT_DP_LOAD},
+        {"dp-save", required_argument, NULL, OPT_DP_SAVE},
+        {"bsgs", no_argument, NULL, OPT_BSGS},
+        {"bsgs-mem", required_argument, NULL, OPT_BSGS_MEM},
+        {"bsgs-table", required_argument, NULL, OPT_BSGS_TABLE},
+        {"autotune", no_argument, NULL, OPT_AUTOTUNE},
+        {"h160-prefix", required_argument, NULL, OPT_H160_PREFIX},
+        {"h160-mask", required_argument, NULL, OPT_H160_MASK},
+        {"addr-prefix", required_argument, NULL, OPT_ADDR_PREFIX},
+        {"no-splice", no_argument, NULL, OPT_NO_SPLICE},
+        {"permute", no_argument, NULL, OPT_PERMUTE},
+        {"perm-key", required_argument, NULL, OPT_PERM_KEY},
+        {"perm-start", required_argument, NULL, OPT_PERM_START},
+        {"join", required_argument, NULL, OPT_JOIN},
+        {"join-mem", required_argument, NULL, OPT_JOIN_MEM},
+        {"join-dir", required_argument, NULL, OPT_JOIN_DIR},
+        {"coverage", required_argument, NULL, OPT_COVERAGE},
+        {"skip-covered", no_argument, NULL, OPT_SKIP_COVERED},
+        {"cache", required_argument, NULL, OPT_CACHE},
+        {"cache-size", required_argument, NULL, OPT_CACHE_SIZE},
+        {"verify", required_argument, NULL, OPT_VERIFY},
+        {NULL, 0, NULL, 0}
+    };
 
     int opt;
-    while ((opt = getopt(argc, argv, "m:t:n:vRb:r:o:")) != -1) {
+    while ((opt = getopt_long(argc, argv, "m:t:n:vRb:r:o:", long_options, NULL)) != -1) {
         switch (opt) {
             case 'm':
-                if (strcmp(optarg, "p") == 0) output_mode = MODE_PUBKEY;
-                else if (strcmp(optarg, "h") == 0) output_mode = MODE_HASH160;
-                else if (strcmp(optarg, "a") == 0) output_mode = MODE_ADDRESS;
-                else { fprintf(stderr, "Error: Invalid mode '%s'. Use p, h, or a.\n", optarg); return 1; }
+                if (!parse_output_modes(optarg, &output, &family)) {
+                    fprintf(stderr, "Error: Invalid mode '%s'. Use p, u, h, hu, a, au or a comma-separated set of them,\n"
+                                    "       optionally with fission.\n", optarg);
+                    return 1;
+                }
                 break;
             case 't':
                 num_threads = atoi(optarg);
                 if (num_threads <= 0) { fprintf(stderr, "Error: Number of threads must be > 0.\n"); return 1; }
+                tune_fixed |= AUTOTUNE_FIX_THREADS;
+                break;
+            case 'n':
+                if (mpz_set_str(total, optarg, 10) != 0 || mpz_sgn(total) < 0 || mpz_sizeinbase(total, 2) > 256) {
+                    fprintf(stderr, "Error: -n count must be a decimal number from 0 (no limit) below 2^256.\n"); return 1;
+                }
+                count_given = true;
                 break;
-            case 'n': count = atoll(optarg); if(count <= 0) { fprintf(stderr, "Error: -n count must be > 0.\n"); return 1; } break;
             case 'v': verbose = true; break;
             case 'R': random_mode = true; break;
             case 'b': bitrange_param = optarg; break;
             case 'r': range_param = optarg; break;
             case 'o': output_filename = optarg; break;
+            case OPT_STEP: step_param = optarg; break;
+            case OPT_SPLIT: split_output = true; break;
+            case OPT_ENDO: endo = true; break;
+            case OPT_BINARY: binary_output = true; break;
+            case OPT_SORT: sort_output = true; break;
+            case OPT_SORT_INPUT: sort_input = optarg; break;
+            case OPT_SORT_MEM:
+                sort_mem_mb = atol(optarg);
+                if (sort_mem_mb <= 0) { fprintf(stderr, "Error: --sort-mem must be > 0.\n"); return 1; }
+                break;
+            case OPT_AFFINITY: if (pin_mode == TOPO_PIN_NONE) pin_mode = TOPO_PIN_CORES; tune_fixed |= AUTOTUNE_FIX_PIN; break;
+            case OPT_NUMA: pin_mode = TOPO_PIN_NUMA; tune_fixed |= AUTOTUNE_FIX_PIN; break;
+            case OPT_DIV:
+                if (!parse_divisors(optarg, &div_min, &div_max)) {
+                    fprintf(stderr, "Error: --div must be a decimal range A:B with 1 <= A <= B < 2^32.\n"); return 1;
+                }
+                div_given = true;
+                break;
+            case OPT_ITER:
+                div_iterations = atoi(optarg);
+                if (div_iterations < 1 || div_iterations > PKC_GRID_MAX_ITERATIONS) {
+                    fprintf(stderr, "Error: --iter must be between 1 and %d.\n", PKC_GRID_MAX_ITERATIONS); return 1;
+                }
+                div_given = true;
+                break;
+            case OPT_INVERSE: mul_inverse = true; break;
+            case OPT_KANGAROO: kangaroo = true; break;
+            case OPT_DP:
+                kangaroo_opt.dp_bits = atoi(optarg);
+                if (kangaroo_opt.dp_bits < 0 || kangaroo_opt.dp_bits > KANGAROO_MAX_DP_BITS) {
+                    fprintf(stderr, "Error: --dp must be between 0 and %d.\n", KANGAROO_MAX_DP_BITS); return 1;
+                }
+                break;
+            case OPT_DP_LOAD:
+                if (kangaroo_opt.load_count == KANGAROO_LOAD_MAX) {
+                    fprintf(stderr, "Error: At most %d --dp-load files.\n", KANGAROO_LOAD_MAX); return 1;
+                }
+                kangaroo_opt.load[kangaroo_opt.load_count++] = optarg;
+                break;
+            case OPT_DP_SAVE: kangaroo_opt.save = optarg; break;
+            case OPT_BSGS: bsgs = true; break;
+            case OPT_BSGS_MEM:
+                bsgs_mem_mb = atol(optarg);
+                if (bsgs_mem_mb <= 0) { fprintf(stderr, "Error: --bsgs-mem must be > 0.\n"); return 1; }
+                break;
+            case OPT_BSGS_TABLE: bsgs_table = optarg; break;
+            case OPT_AUTOTUNE: autotune = true; break;
+            case OPT_NO_SPLICE: no_splice = true; break;
+            case OPT_PERMUTE: permute = true; break;
+            case OPT_PERM_KEY: perm_key_param = optarg; break;
+            case OPT_PERM_START: perm_start_param = optarg; break;
+            case OPT_JOIN: join_keys = optarg; break;
+            case OPT_JOIN_MEM:
+                join_mem_mb = atol(optarg);
+                if (join_mem_mb <= 0) { fprintf(stderr, "Error: --join-mem must be > 0.\n"); return 1; }
+                break;
+            case OPT_JOIN_DIR: join_dir = optarg; break;
+            case OPT_COVERAGE: coverage_path = optarg; break;
+            case OPT_SKIP_COVERED: skip_covered = true; break;
+            case OPT_CACHE: cache_dir = optarg; break;
+            case OPT_CACHE_SIZE:
+                cache_mb = atol(optarg);
+                if (cache_mb <= 0) { fprintf(stderr, "Error: --cache-size must be > 0.\n"); return 1; }
+                break;
+            case OPT_VERIFY: verify_path = optarg; break;
+            case OPT_H160_PREFIX:
+                if (!h160_filter_add_prefix(&filter, optarg)) {
+                    fprintf(stderr, "Error: --h160-prefix must be 1 to 40 hexadecimal digits.\n"); return 1;
+                }
+                break;
+            case OPT_H160_MASK:
+                if (!h160_filter_add_mask(&filter, optarg)) {
+                    fprintf(stderr, "Error: --h160-mask must be <value>:<mask>, each 1 to 40 hexadecimal digits.\n"); return 1;
+                }
+                break;
+            case OPT_ADDR_PREFIX:
+                if (!h160_filter_add_address_prefix(&filter, optarg)) {
+                    fprintf(stderr, "Error: --addr-prefix must be a Base58 prefix of a P2PKH address (starting with 1).\n"); return 1;
+                }
+                break;
+            case OPT_HASH_THREADS:
+                hash_threads = atoi(optarg);
+                if (hash_threads <= 0) { fprintf(stderr, "Error: --hash-threads must be > 0.\n"); return 1; }
+                tune_fixed |= AUTOTUNE_FIX_HASH_THREADS;
+                break;
+            case OPT_BACKEND: {
+                EcBackend backend = EC_BACKEND_COUNT;
+                for (int b = 0; b < EC_BACKEND_COUNT; ++b)
+                    if (strcmp(optarg, ec_backend_name((EcBackend)b)) == 0) backend = (EcBackend)b;
+                if (backend == EC_BACKEND_COUNT) {
+                    fprintf(stderr, "Error: Invalid backend '%s'. Use auto, scalar or ifma.\n", optarg); return 1;
+                }
+                if (!ec_set_backend(backend)) {
+                    fprintf(stderr, "Error: Backend '%s' is not supported by this CPU or build.\n", optarg); return 1;
+                }
+                if (backend != EC_BACKEND_AUTO) tune_fixed |= AUTOTUNE_FIX_BACKEND;
+                break;
+            }
             default: print_usage(argv[0]); return 1;
         }
     }
@@ -300,126 +2005,422 @@ int main(int argc, char **argv) {
     if (bitrange_param && range_param) {
         fprintf(stderr, "Error: Cannot specify both -b and -r.\n"); return 1;
     }
+    // 0：-n 0 或放不進 long long，分段運行
+    if (!pkc_mpz_get_count(total, &count)) count = 0;
+    if (sort_input) {
+        if (!output_filename) { fprintf(stderr, "Error: --sort-input requires -o <file>.\n"); return 1; }
+        long long sorted = clone_sort_file(sort_input, output_filename, (size_t)sort_mem_mb << 20, num_threads);
+        if (sorted < 0) return 1;
+        fprintf(stderr, "[+] sorted %lld unique records into %s\n", sorted, output_filename);
+        return 0;
+    }
+    if (split_output && !output_filename) {
+        fprintf(stderr, "Error: --split requires -o <file>.\n"); return 1;
+    }
+    if (binary_output) {
+        for (int i = 0; i < output.mode_count; ++i) {
+            if (MODE_KEY_LEN[output.modes[i]] == 0) {
+                fprintf(stderr, "Error: --binary supports modes p, u, h and hu only.\n"); return 1;
+            }
+        }
+        if (output.mode_count > 1 && !split_output) {
+            fprintf(stderr, "Error: --binary with several modes requires --split.\n"); return 1;
+        }
+    }
+    if (sort_output && (!binary_output || !output_filename)) {
+        fprintf(stderr, "Error: --sort requires --binary and -o <file>.\n"); return 1;
+    }
+    if (family == PKC_FAMILY_FISSION) {
+        if (random_mode || bitrange_param || range_param || step_param || endo) {
+            fprintf(stderr, "Error: -R, -b, -r, --step and --endo do not apply to -m fission.\n"); return 1;
+        }
+        if (count < 1 || count > PKC_FISSION_MAX_DEPTH) {
+            fprintf(stderr, "Error: Fission depth (-n) must be between 1 and %d.\n", PKC_FISSION_MAX_DEPTH); return 1;
+        }
+    }
+    if ((family == PKC_FAMILY_GRID || family == PKC_FAMILY_MUL) && (random_mode || endo)) {
+        fprintf(stderr, "Error: -R and --endo do not apply to -m grid or -m mul.\n"); return 1;
+    }
+    if (mul_inverse && family != PKC_FAMILY_MUL) {
+        fprintf(stderr, "Error: --inverse requires -m mul.\n"); return 1;
+    }
+    if (div_given && family != PKC_FAMILY_GRID) {
+        fprintf(stderr, "Error: --div and --iter require -m grid.\n"); return 1;
+    }
+    if (!kangaroo && (kangaroo_opt.dp_bits >= 0 || kangaroo_opt.load_count || kangaroo_opt.save)) {
+        fprintf(stderr, "Error: --dp, --dp-load and --dp-save require --kangaroo.\n"); return 1;
+    }
+    if (kangaroo) {
+        if (!bitrange_param && !range_param) {
+            fprintf(stderr, "Error: --kangaroo requires a range (-b or -r).\n"); return 1;
+        }
+        if (random_mode || step_param || endo || family != PKC_FAMILY_SHIFT || binary_output || split_output) {
+            fprintf(stderr, "Error: -R, --step, --endo, -m families, --binary and --split do not apply to --kangaroo.\n"); return 1;
+        }
+        if (mpz_sizeinbase(total, 2) > 64) {
+            fprintf(stderr, "Error: -n (maximum jumps) for --kangaroo must be below 2^64.\n"); return 1;
+        }
+        // -n 0 即不限
+        if (count_given) mpz_export(&kangaroo_opt.max_jumps, NULL, 1, sizeof(uint64_t), 0, 0, total);
+    }
+    if (!h160_filter_empty(&filter) && (kangaroo || bsgs)) {
+        fprintf(stderr, "Error: --h160-prefix, --h160-mask and --addr-prefix apply to cloning only.\n"); return 1;
+    }
+    if (autotune && (kangaroo || bsgs)) {
+        fprintf(stderr, "Error: --autotune applies to cloning only, not to --kangaroo or --bsgs.\n"); return 1;
+    }
+    if (!bsgs && (bsgs_mem_mb != BSGS_DEFAULT_MEM_MB || bsgs_table)) {
+        fprintf(stderr, "Error: --bsgs-mem and --bsgs-table require --bsgs.\n"); return 1;
+    }
+    if (bsgs) {
+        if (kangaroo) {
+            fprintf(stderr, "Error: Use either --bsgs or --kangaroo.\n"); return 1;
+        }
+        if (!bitrange_param && !range_param) {
+            fprintf(stderr, "Error: --bsgs requires a range (-b or -r).\n"); return 1;
+        }
+        if (random_mode || step_param || endo || family != PKC_FAMILY_SHIFT || binary_output || split_output || count_given) {
+            fprintf(stderr, "Error: -R, -n, --step, --endo, -m families, --binary and --split do not apply to --bsgs.\n"); return 1;
+        }
+    }
+    if (!join_keys && (join_mem_mb != JOIN_DEFAULT_MEM_MB || join_dir)) {
+        fprintf(stderr, "Error: --join-mem and --join-dir require --join.\n"); return 1;
+    }
+    if (join_keys && (kangaroo || bsgs || family != PKC_FAMILY_SHIFT || binary_output || split_output || sort_output
+                      || !h160_filter_empty(&filter))) {
+        fprintf(stderr, "Error: --join takes P +/- kG clones only, without --kangaroo, --bsgs, -m families, --binary,\n"
+                        "       --split, --sort or hash160 filters.\n"); return 1;
+    }
+    bool clone_only = !kangaroo && !bsgs && !join_keys && family == PKC_FAMILY_SHIFT;
+    if (coverage_path && !clone_only) {
+        fprintf(stderr, "Error: --coverage applies to P +/- kG cloning only, not to --kangaroo, --bsgs, --join or -m families.\n");
+        return 1;
+    }
+    if (!cache_dir && cache_mb != CACHE_DEFAULT_MB) {
+        fprintf(stderr, "Error: --cache-size requires --cache <dir>.\n"); return 1;
+    }
+    if (cache_dir && (!clone_only || !binary_output || random_mode || coverage_path || !h160_filter_empty(&filter))) {
+        fprintf(stderr, "Error: --cache takes incremental P +/- kG cloning with --binary, without -R, --coverage\n"
+                        "       or hash160 filters.\n"); return 1;
+    }
+    if (cache_dir && !segcache_open(cache_dir)) {
+        fprintf(stderr, "Error: Could not create the cache directory '%s'.\n", cache_dir); return 1;
+    }
+    if (verify_path && (kangaroo || bsgs || join_keys || cache_dir || binary_output || split_output || sort_output
+                        || !h160_filter_empty(&filter))) {
+        fprintf(stderr, "Error: --verify writes text hits; it does not combine with --kangaroo, --bsgs, --join,\n"
+                        "       --cache, --binary, --split, --sort or hash160 filters.\n"); return 1;
+    }
+    // 環境變量給出的默認覆蓋文件只用於能記錄的運行
+    if (!coverage_path && clone_only && !cache_dir && getenv("PKCLONE_COVERAGE") && *getenv("PKCLONE_COVERAGE"))
+        coverage_path = getenv("PKCLONE_COVERAGE");
+    if (skip_covered && !coverage_path) {
+        fprintf(stderr, "Error: --skip-covered requires --coverage <file>.\n"); return 1;
+    }
+    if (skip_covered && random_mode && !permute) {
+        fprintf(stderr, "Error: --skip-covered needs incremental mode or -R --permute; plain -R only records draws.\n"); return 1;
+    }
+    if (step_param && (mpz_set_str(step, step_param, 16) != 0 || mpz_sgn(step) <= 0)) {
+        fprintf(stderr, "Error: --step must be a positive hexadecimal number.\n"); return 1;
+    }
+    if ((perm_key_param || perm_start_param) && !permute) {
+        fprintf(stderr, "Error: --perm-key and --perm-start require --permute.\n"); return 1;
+    }
+    if (permute && !random_mode) {
+        fprintf(stderr, "Error: --permute requires -R.\n"); return 1;
+    }
     if (random_mode) {
         if (bitrange_param) set_bitrange(bitrange_param, min_scalar, max_scalar);
         else if (range_param) set_range(range_param, min_scalar, max_scalar);
         else { mpz_set_ui(min_scalar, 1); mpz_sub_ui(max_scalar, n, 1); }
     } else {
+        mpz_t terms;
+        mpz_init(terms);
         if (!bitrange_param && !range_param) {
-            mpz_set_ui(min_scalar, 1);
-            mpz_add_ui(max_scalar, min_scalar, count - 1);
+            // 網格的 s = 0 即 P·d⁻ᵗ 本身；-n 0 時一直走到 n - 1
+            mpz_set_ui(min_scalar, family == PKC_FAMILY_GRID ? 0 : 1);
+            if (mpz_sgn(total) == 0) {
+                mpz_sub_ui(max_scalar, n, 1);
+                mpz_sub(terms, max_scalar, min_scalar);
+                mpz_fdiv_q(total, terms, step);
+                mpz_add_ui(total, total, 1);
+            } else {
+                mpz_sub_ui(max_scalar, total, 1);
+                mpz_mul(max_scalar, max_scalar, step);
+                mpz_add(max_scalar, max_scalar, min_scalar);
+            }
         } else {
              if (bitrange_param) set_bitrange(bitrange_param, min_scalar, max_scalar);
              else if (range_param) set_range(range_param, min_scalar, max_scalar);
+             // 步長模式、-n 0 與分段運行的 -n（count 為 0）只走範圍內的項
+             if (step_param || count == 0) {
+                 mpz_sub(terms, max_scalar, min_scalar);
+                 if (mpz_sgn(terms) < 0) {
+                     fprintf(stderr, "Error: Range minimum is greater than maximum.\n");
+                     mpz_clear(terms);
+                     return 1;
+                 }
+                 mpz_fdiv_q(terms, terms, step);
+                 mpz_add_ui(terms, terms, 1);
+                 if (mpz_sgn(total) == 0) {
+                     mpz_set(total, terms);
+                 } else if (mpz_cmp(terms, total) < 0) {
+                     mpz_set(total, terms);
+                     gmp_fprintf(stderr, "[+] step=%Zx → %Zd terms in range, count reduced.\n", step, total);
+                 }
+             }
         }
+        mpz_clear(terms);
     }
     
+    unsigned char perm_key[FEISTEL_KEY_SIZE] = {0};
+    mpz_t perm_start;
+    mpz_init(perm_start);
+    if (permute && !setup_permutation(perm_key_param, perm_start_param, min_scalar, max_scalar, step, perm_key, perm_start, total))
+        return 1;
+    if (!pkc_mpz_get_count(total, &count)) count = 0;
+    // 分段運行時 total 為每個基準公鑰的標量總數，0 表示 -R 一直運行
+    bool streaming = count == 0;
+    if (streaming && (join_keys || cache_dir)) {
+        fprintf(stderr, "Error: --join and --cache need -n between 1 and 2^63 - 1.\n"); return 1;
+    }
+
     if (optind >= argc) {
         fprintf(stderr, "Error: Public key hex string is missing.\n"); return 1;
     }
-    const char *pubkey_hex = argv[optind];
-    size_t pubkey_hex_len = strlen(pubkey_hex);
-    unsigned char pubkey_bytes[65];
-    size_t pubkey_bytes_len;
-    if (!hex_to_bytes(pubkey_hex, pubkey_bytes, pubkey_hex_len, &pubkey_bytes_len) || (pubkey_bytes_len != 33 && pubkey_bytes_len != 65)) {
-        fprintf(stderr, "Error: Invalid public key hex string or length.\n"); return 1;
+    PkcContext *engine = pkc_create();
+    if (!engine || !add_base_keys(engine, argv[optind], num_threads)) {
+        pkc_destroy(engine);
+        return 1;
     }
-
-    secp256k1_context *ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
-    secp256k1_pubkey pubkey_orig;
-    if (!secp256k1_ec_pubkey_parse(ctx, &pubkey_orig, pubkey_bytes, pubkey_bytes_len)) {
-        fprintf(stderr, "Error: Failed to parse public key.\n");
-        secp256k1_context_destroy(ctx);
+    HitTargets targets = {0};
+    if (verify_path && !load_hit_targets(&targets, verify_path, num_threads)) {
+        pkc_destroy(engine);
         return 1;
     }
-    
-    FILE *output_fp = stdout;
-    if (output_filename) {
-        output_fp = fopen(output_filename, "w");
-        if (!output_fp) {
+
+    if (kangaroo) {
+        // 野生 DP 只對應一個目標，單個 DP 文件不能混合多個目標
+        bool ok = !(kangaroo_opt.load_count || kangaroo_opt.save) || pkc_base_count(engine) == 1;
+        if (!ok) fprintf(stderr, "Error: --dp-load and --dp-save take a single public key.\n");
+        FILE *out = stdout;
+        if (ok && output_filename && !(out = fopen(output_filename, "w"))) {
+            fprintf(stderr, "Error: Could not open output file '%s'.\n", output_filename);
+            ok = false;
+        }
+        if (ok) ok = run_kangaroo(engine, &kangaroo_opt, min_scalar, max_scalar, num_threads, pin_mode, out);
+        if (out && out != stdout) fclose(out);
+        pkc_destroy(engine);
+        mpz_clears(min_scalar, max_scalar, n, step, total, NULL);
+        return ok ? 0 : 1;
+    }
+    if (bsgs) {
+        FILE *out = stdout;
+        bool ok = true;
+        if (output_filename && !(out = fopen(output_filename, "w"))) {
             fprintf(stderr, "Error: Could not open output file '%s'.\n", output_filename);
-            secp256k1_context_destroy(ctx);
+            ok = false;
+        }
+        if (ok) ok = run_bsgs(engine, (size_t)bsgs_mem_mb << 20, bsgs_table, min_scalar, max_scalar, num_threads, pin_mode, out);
+        if (out && out != stdout) fclose(out);
+        pkc_destroy(engine);
+        mpz_clears(min_scalar, max_scalar, n, step, total, NULL);
+        return ok ? 0 : 1;
+    }
+    
+    output.split = split_output;
+    output.binary = binary_output;
+    if (!open_outputs(&output, output_filename)) {
+        hit_targets_free(&targets);
+        pkc_destroy(engine);
+        return 1;
+    }
+    // 單個輸出且是管道（通常是 stdout | 下游工具）：文件頭已經過 stdio，先沖出再改用 vmsplice
+    if (!no_splice && !join_keys && !cache_dir && !verify_path && !output.split && pipe_out_init(&output.pipe, fileno(output.fps[0]))) {
+        fflush(output.fps[0]);
+        output.spliced = true;
+    }
+
+    PkcParams params;
+    pkc_params_init(&params);
+    params.count = count;
+    params.threads = num_threads;
+    params.hash_threads = hash_threads;
+    params.pin = pin_mode;
+    if (pin_mode == TOPO_PIN_NUMA)
+        fprintf(stderr, "[+] numa: %d nodes, %d cpus, threads spread across nodes\n", topo_node_count(), topo_cpu_count());
+    params.random_mode = random_mode;
+    params.permute = permute;
+    memcpy(params.perm_key, perm_key, sizeof(perm_key));
+    mpz_set(params.perm_start, perm_start);
+    params.endo = endo;
+    params.family = family;
+    params.div_min = div_min;
+    params.div_max = div_max;
+    params.div_iterations = div_iterations;
+    params.mul_inverse = mul_inverse;
+    params.forms = engine_forms(&output);
+    // 謂詞在哈希執行緒中、格式化之前判斷，不匹配的記錄不會到達 Base58 與輸出
+    if (!h160_filter_empty(&filter)) {
+        params.forms |= filter_forms(&output);
+        params.h160_predicate = filter_predicate;
+        params.predicate_user = &filter;
+    } else if (verify_path) {
+        // 只算要比較的 hash160，記錄本身不寫出
+        params.forms = filter_forms(&output);
+        params.h160_predicate = verify_predicate;
+        params.predicate_user = &targets;
+    }
+    mpz_set(params.min_scalar, min_scalar);
+    mpz_set(params.max_scalar, max_scalar);
+    mpz_set(params.step, step);
+
+    // --autotune 試驗後寫入配置文件；否則有同一 CPU 與工作類型的記錄時直接套用
+    char profile_path[4096], profile_key[512];
+    AutotuneResult tuned;
+    bool tuned_applied = false;
+    bool have_profile = autotune_profile_path(profile_path, sizeof(profile_path));
+    autotune_key(&params, profile_key, sizeof(profile_key));
+    if (autotune) {
+        fprintf(stderr, "[+] autotune: %s\n", profile_key);
+        if (!autotune_run(engine, &params, tune_fixed, AUTOTUNE_TRIAL_SECONDS, stderr, &tuned)) {
+            fprintf(stderr, "Error: Autotune trials failed (invalid range or out of memory).\n");
+            hit_targets_free(&targets);
+            pkc_params_clear(&params);
+            pkc_destroy(engine);
+            close_outputs(&output);
             return 1;
         }
+        autotune_apply(&tuned, tune_fixed, &params);
+        tuned_applied = true;
+        if (have_profile && !autotune_store(profile_path, profile_key, &tuned))
+            fprintf(stderr, "[!] Could not write the autotune profile '%s'.\n", profile_path);
+        else if (have_profile)
+            fprintf(stderr, "[+] autotune profile saved to %s\n", profile_path);
+    } else if (have_profile && autotune_load(profile_path, profile_key, &tuned)) {
+        autotune_apply(&tuned, tune_fixed, &params);
+        tuned_applied = true;
     }
+    if (tuned_applied)
+        fprintf(stderr, "[+] tuned: backend %s, -t %d, --hash-threads %d, batch %zu%s\n",
+                ec_backend_name(ec_get_backend()), params.threads, pkc_sink_threads(&params), params.batch_size,
+                params.pin == TOPO_PIN_NONE ? "" : params.pin == TOPO_PIN_CORES ? ", --affinity" : ", --numa");
 
-    pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
-    ThreadData *thread_data = malloc(num_threads * sizeof(ThreadData));
-    pthread_mutex_t output_mutex;
-    pthread_mutex_init(&output_mutex, NULL);
-    
-    long long count_per_thread = count / num_threads;
-    long long remainder = count % num_threads;
-    long long current_start = 0;
-
-    for (int i = 0; i < num_threads; i++) {
-        thread_data[i].thread_id = i;
-        thread_data[i].start_count = current_start;
-        long long work_for_this_thread = count_per_thread + (i < remainder ? 1 : 0);
-        thread_data[i].end_count = current_start + work_for_this_thread;
-        current_start = thread_data[i].end_count;
-
-        thread_data[i].ctx = ctx;
-        thread_data[i].pubkey_orig = pubkey_orig;
-        mpz_init_set(thread_data[i].min_scalar, min_scalar);
-        mpz_init_set(thread_data[i].max_scalar, max_scalar);
-        mpz_init_set(thread_data[i].n, n);
-        thread_data[i].random_mode = random_mode;
-        thread_data[i].verbose = verbose;
-        thread_data[i].output_mode = output_mode;
-        thread_data[i].output_fp = output_fp;
-        thread_data[i].output_mutex = &output_mutex;
-
-        // 初始化並為每個執行緒的隨機狀態播種
-        gmp_randinit_default(thread_data[i].randstate);
-        unsigned long seed = time(NULL) ^ (unsigned long)getpid() ^ (unsigned long)(i + 1);
-        gmp_randseed_ui(thread_data[i].randstate, seed);
-
-        pthread_create(&threads[i], NULL, worker_thread, &thread_data[i]);
-    }
-
-    for (int i = 0; i < num_threads; i++) {
-        pthread_join(threads[i], NULL);
-        // 清理執行緒數據和隨機狀態
-        mpz_clears(thread_data[i].min_scalar, thread_data[i].max_scalar, thread_data[i].n, NULL);
-        gmp_randclear(thread_data[i].randstate);
+    if (join_keys) {
+        // 記錄只留 k 的低 64 位，靠 min 還原
+        mpz_t span;
+        mpz_init(span);
+        if (random_mode) mpz_sub(span, max_scalar, min_scalar);
+        else {
+            mpz_sub_ui(span, total, 1);
+            mpz_mul(span, span, step);
+        }
+        bool ok = mpz_sizeinbase(span, 2) <= 64;
+        mpz_clear(span);
+        if (!ok) fprintf(stderr, "Error: --join needs the scalars of a set to span less than 2^64.\n");
+        PkcContext *set_b = ok ? pkc_create() : NULL;
+        ok = set_b && add_base_keys(set_b, join_keys, num_threads);
+        if (ok) {
+            const char *dir = join_dir ? join_dir : getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+            ok = run_join(engine, set_b, &params, (size_t)join_mem_mb << 20, dir, output.fps[0]);
+        }
+        pkc_destroy(set_b);
+        pkc_params_clear(&params);
+        pkc_destroy(engine);
+        mpz_clears(min_scalar, max_scalar, n, step, total, perm_start, NULL);
+        close_outputs(&output);
+        h160_filter_free(&filter);
+        return ok ? 0 : 1;
     }
-    
-    if (verbose) {
-        unsigned char serialized_pubkey_orig[33];
-        size_t len = sizeof(serialized_pubkey_orig);
-        secp256k1_ec_pubkey_serialize(ctx, serialized_pubkey_orig, &len, &pubkey_orig, SECP256K1_EC_COMPRESSED);
-        
-        pthread_mutex_lock(&output_mutex);
-        switch(output_mode) {
-             case MODE_PUBKEY:
-                 print_bytes_hex(output_fp, serialized_pubkey_orig, len);
-                 break;
-             case MODE_HASH160: {
-                 unsigned char h160[HASH160_SIZE];
-                 hash160(serialized_pubkey_orig, len, h160);
-                 print_bytes_hex(output_fp, h160, HASH160_SIZE);
-                 break;
-             }
-             case MODE_ADDRESS: {
-                 char *addr_str = NULL;
-                 pubkey_to_address(serialized_pubkey_orig, len, &addr_str);
-                 if(addr_str) { fprintf(output_fp, "%s", addr_str); free(addr_str); }
-                 break;
-             }
+
+    CoveragePlan plan;
+    bool planned = false;
+    if (coverage_path) {
+        // 增量模式不給區間時一直延伸到 n - 1
+        mpz_t range_end;
+        mpz_init(range_end);
+        if (bitrange_param || range_param) mpz_set(range_end, max_scalar);
+        else mpz_sub_ui(range_end, n, 1);
+        planned = coverage_plan_init(&plan, coverage_path, skip_covered, engine, &output, &params, range_end);
+        mpz_clear(range_end);
+    }
+    // 覆蓋文件的錯誤已在 coverage_plan_init 中報告
+    bool ok = !coverage_path || planned;
+    // 分段運行時 Ctrl-C 停在當前段，已寫出的記錄照常沖出
+    if (streaming) signal(SIGINT, on_interrupt);
+    int run_result = !ok ? 0
+                   : cache_dir ? run_cached(engine, &params, &output, cache_dir, (uint64_t)cache_mb << 20)
+                   : verify_path ? run_verify(engine, &params, &targets, output.fps[0], planned ? &plan : NULL,
+                                              streaming ? total : NULL)
+                   : run_pipeline(engine, &params, &output, verbose, planned ? &plan : NULL, streaming ? total : NULL);
+    if (streaming) signal(SIGINT, SIG_DFL);
+    if (run_result < 0) {
+        fprintf(stderr, "Error: Clone engine failed (invalid range or out of memory).\n");
+        ok = false;
+    }
+    if (coverage_path) coverage_plan_free(&plan);
+
+    if (ok && verbose && !binary_output && !verify_path) {
+        AffinePoint point_orig;
+        for (int b = 0; b < pkc_base_count(engine); ++b) {
+            pkc_base_point(engine, b, &point_orig);
+            write_original_record(&output, &point_orig, pkc_base_count(engine) > 1 ? b : -1);
         }
-        fprintf(output_fp, " = original\n");
-        pthread_mutex_unlock(&output_mutex);
     }
 
-    pthread_mutex_destroy(&output_mutex);
-    free(threads);
-    free(thread_data);
-    secp256k1_context_destroy(ctx);
-    mpz_clears(min_scalar, max_scalar, n, NULL);
-    if (output_fp != stdout) {
-        fclose(output_fp);
+    hit_targets_free(&targets);
+    pkc_params_clear(&params);
+    pkc_destroy(engine);
+    mpz_clears(min_scalar, max_scalar, n, step, total, perm_start, NULL);
+    close_outputs(&output);
+    h160_filter_free(&filter);
+    if (!ok) return 1;
+
+    if (sort_output) {
+        int files = output.split ? output.mode_count : 1;
+        for (int i = 0; i < files; ++i) {
+            char path[4096];
+            output_path(&output, output_filename, i, path, sizeof(path));
+            long long sorted = clone_sort_file(path, path, (size_t)sort_mem_mb << 20, num_threads);
+            if (sorted < 0) return 1;
+            fprintf(stderr, "[+] sorted %lld unique records into %s\n", sorted, path);
+        }
     }
 
     return 0;
 }
+
+/* --daemon：常駐並預熱 secp256k1 上下文、後端與拓撲，每個作業在 fork 出的子進程中運行 clone_main。
+ * --connect：把其餘參數連同工作目錄與標準描述符交給常駐進程，退出碼與直接運行相同。
+ */
+int run_daemon(int argc, char **argv) {
+    const char *socket_path = argv[2];
+    long max_jobs = 1;
+    for (int i = 3; i < argc; ++i) {
+        char *end;
+        if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            max_jobs = strtol(argv[++i], &end, 10);
+            if (*end == '\0' && max_jobs >= 1 && max_jobs <= 4096) continue;
+        }
+        fprintf(stderr, "Error: Usage is %s --daemon <socket> [--jobs <n>], n from 1 to 4096.\n", argv[0]);
+        return 1;
+    }
+    pkc_warm();
+    return jobserver_serve(socket_path, (int)max_jobs, clone_main) == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 3 && strcmp(argv[1], "--daemon") == 0) return run_daemon(argc, argv);
+    if (argc >= 3 && strcmp(argv[1], "--connect") == 0) {
+        // 作業的 argv[0] 保持本程序名，用法信息與直接運行一致
+        const char *socket_path = argv[2];
+        argv[2] = argv[0];
+        int code = jobserver_submit(socket_path, argc - 2, argv + 2);
+        if (code < 0) {
+            fprintf(stderr, "Error: Cannot reach a daemon on '%s'.\n", socket_path);
+            return 1;
+        }
+        return code;
+    }
+    return clone_main(argc, argv);
+}
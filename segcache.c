@@ -0,0 +1,178 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* segcache.c
+ * https://github.com/8891689
+ * 複製時把整個條目映射進來交給一次 fwrite，省掉讀緩衝的一次拷貝；
+ * 淘汰只看修改時間，命中時 utime 更新它，不另存索引文件。
+ */
+#include "segcache.h"
+#include "sha256.h"
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <utime.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+typedef struct {
+    char *path;
+    uint64_t size;
+    time_t mtime;
+} CacheEntry;
+
+int segcache_open(const char *dir) {
+    struct stat st;
+    if (stat(dir, &st) == 0) return S_ISDIR(st.st_mode);
+#ifdef _WIN32
+    return mkdir(dir) == 0 || errno == EEXIST;
+#else
+    return mkdir(dir, 0777) == 0 || errno == EEXIST;
+#endif
+}
+
+void segcache_name(const char *key, char *out) {
+    static const char hex[] = "0123456789abcdef";
+    uint8_t hash[SHA256_BLOCK_SIZE];
+    sha256((const uint8_t *)key, strlen(key), hash);
+    for (int i = 0; i < SHA256_BLOCK_SIZE; ++i) {
+        out[2 * i] = hex[hash[i] >> 4];
+        out[2 * i + 1] = hex[hash[i] & 15];
+    }
+    out[SEGCACHE_NAME_LEN] = '\0';
+}
+
+int segcache_path(const char *dir, const char *name, const char *suffix, char *path, size_t size) {
+    int n = snprintf(path, size, "%s/%s.%s", dir, name, suffix);
+    return n > 0 && (size_t)n < size;
+}
+
+int segcache_hit(const char *dir, const char *name, const char *suffix) {
+    char path[4096];
+    struct stat st;
+    if (!segcache_path(dir, name, suffix, path, sizeof(path)) || stat(path, &st) != 0) return 0;
+    utime(path, NULL);
+    return 1;
+}
+
+long long segcache_copy(const char *path, size_t header, size_t record_size, FILE *out) {
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < header || ((uint64_t)st.st_size - header) % record_size) {
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    long long records = (long long)((size - header) / record_size);
+    if (size == header) {
+        close(fd);
+        return 0;
+    }
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+#ifdef MADV_SEQUENTIAL
+    madvise(map, size, MADV_SEQUENTIAL);
+#endif
+    size_t written = fwrite((const char *)map + header, 1, size - header, out);
+    munmap(map, size);
+    return written == size - header ? records : -1;
+#else
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return -1;
+    char *buf = malloc(1 << 20);
+    long long bytes = 0;
+    size_t n;
+    if (!buf || fseek(fp, (long)header, SEEK_SET) != 0) {
+        free(buf);
+        fclose(fp);
+        return -1;
+    }
+    while ((n = fread(buf, 1, 1 << 20, fp)) > 0) {
+        if (fwrite(buf, 1, n, out) != n) {
+            bytes = -1;
+            break;
+        }
+        bytes += (long long)n;
+    }
+    free(buf);
+    fclose(fp);
+    if (bytes < 0 || bytes % (long long)record_size) return -1;
+    return bytes / (long long)record_size;
+#endif
+}
+
+static int is_entry_name(const char *name) {
+    for (int i = 0; i < SEGCACHE_NAME_LEN; ++i) {
+        char c = name[i];
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return 0;
+    }
+    // 寫到一半的臨時文件是 <name>.tmp<pid>.<格式>，不算條目
+    return name[SEGCACHE_NAME_LEN] == '.' && strncmp(name + SEGCACHE_NAME_LEN + 1, "tmp", 3) != 0;
+}
+
+static int compare_entry_mtime(const void *a, const void *b) {
+    const CacheEntry *x = a, *y = b;
+    return (x->mtime > y->mtime) - (x->mtime < y->mtime);
+}
+
+uint64_t segcache_evict(const char *dir, uint64_t max_bytes) {
+    DIR *d = opendir(dir);
+    if (!d) return 0;
+    CacheEntry *entries = NULL;
+    size_t count = 0, cap = 0;
+    uint64_t total = 0, removed = 0;
+    struct dirent *e;
+    char path[4096];
+    while ((e = readdir(d))) {
+        struct stat st;
+        if (!is_entry_name(e->d_name)) continue;
+        int n = snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+        if (n <= 0 || (size_t)n >= sizeof(path) || stat(path, &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        if (count == cap) {
+            size_t next = cap ? cap * 2 : 64;
+            CacheEntry *grown = realloc(entries, next * sizeof(*entries));
+            if (!grown) break;
+            entries = grown;
+            cap = next;
+        }
+        entries[count].path = strdup(path);
+        if (!entries[count].path) break;
+        entries[count].size = (uint64_t)st.st_size;
+        entries[count].mtime = st.st_mtime;
+        total += entries[count].size;
+        count++;
+    }
+    closedir(d);
+    if (count) qsort(entries, count, sizeof(*entries), compare_entry_mtime);
+    for (size_t i = 0; i < count && total > max_bytes; ++i) {
+        if (remove(entries[i].path) != 0) continue;
+        total -= entries[i].size;
+        removed += entries[i].size;
+    }
+    for (size_t i = 0; i < count; ++i) free(entries[i].path);
+    free(entries);
+    return removed;
+}
@@ -0,0 +1,57 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* segcache.h — 二進制克隆輸出的分段緩存（按內容命名，容量受限，LRU 淘汰）
+ *
+ * 目錄中每個條目是一個普通的克隆二進制文件（clonefile.h），文件名為
+ * sha256(分段鍵) 的 64 位十六進制 + "." + 格式名，如 3fa2...e1.h。分段鍵由調用方拼出，
+ * 包含決定內容的全部參數，所以同一段在任何機器、任何運行中都是同一個名字，
+ * 多人、多條流水線可以共用一個目錄。條目寫到臨時名後改名，讀者不會看到寫了一半的文件。
+ * 命中時把條目的修改時間更新為現在；超出容量時按修改時間從舊到新刪除。
+ */
+#ifndef SEGCACHE_H
+#define SEGCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SEGCACHE_NAME_LEN 64
+
+// 目錄不存在時創建，失敗返回 0
+int segcache_open(const char *dir);
+// name = sha256(key) 的十六進制，out 至少 SEGCACHE_NAME_LEN + 1 字節
+void segcache_name(const char *key, char *out);
+// <dir>/<name>.<suffix>，放不下返回 0
+int segcache_path(const char *dir, const char *name, const char *suffix, char *path, size_t size);
+// 條目存在時更新它的修改時間並返回 1
+int segcache_hit(const char *dir, const char *name, const char *suffix);
+/* 把條目的記錄（跳過 header 字節的文件頭）寫到 out：映射整個文件後一次 fwrite。
+ * 返回記錄數；文件缺失、大小不是 header + k·record_size 或寫失敗返回 -1。
+ */
+long long segcache_copy(const char *path, size_t header, size_t record_size, FILE *out);
+// 刪除最久未用的條目直到總大小不超過 max_bytes，返回刪除的字節數
+uint64_t segcache_evict(const char *dir, uint64_t max_bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SEGCACHE_H */
@@ -0,0 +1,126 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* spsc.c
+ * https://github.com/8891689
+ * head 只由消費者寫、tail 只由生產者寫，用 acquire / release 配對，無鎖。
+ */
+#include "spsc.h"
+#include <stdlib.h>
+#include <sched.h>
+#include <time.h>
+
+// 連續失敗 spins 次後的等待策略
+static void spsc_backoff(unsigned spins) {
+    if (spins < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    } else if (spins < 256) {
+        sched_yield();
+    } else {
+        struct timespec ts = { 0, 50000 };
+        nanosleep(&ts, NULL);
+    }
+}
+
+int spsc_init(SpscRing *ring, size_t capacity) {
+    size_t cap = 2;
+    while (cap < capacity) cap <<= 1;
+    ring->slots = calloc(cap, sizeof(void *));
+    ring->mask = cap - 1;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->closed = 0;
+    return ring->slots != NULL;
+}
+
+void spsc_free(SpscRing *ring) {
+    free(ring->slots);
+    ring->slots = NULL;
+}
+
+int spsc_try_push(SpscRing *ring, void *item) {
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if (tail - head > ring->mask) return 0;
+    ring->slots[tail & ring->mask] = item;
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+void *spsc_try_pop(SpscRing *ring) {
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (head == tail) return NULL;
+    void *item = ring->slots[head & ring->mask];
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    return item;
+}
+
+void spsc_push(SpscRing *ring, void *item) {
+    for (unsigned spins = 0; !spsc_try_push(ring, item); ++spins) spsc_backoff(spins);
+}
+
+// 先讀 closed 再讀隊列：關閉前 push 的項一定能被看到
+static int spsc_drained(SpscRing *ring) {
+    if (!__atomic_load_n(&ring->closed, __ATOMIC_ACQUIRE)) return 0;
+    return __atomic_load_n(&ring->head, __ATOMIC_RELAXED) == __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+void *spsc_pop(SpscRing *ring) {
+    for (unsigned spins = 0; ; ++spins) {
+        void *item = spsc_try_pop(ring);
+        if (item) return item;
+        if (spsc_drained(ring)) return NULL;
+        spsc_backoff(spins);
+    }
+}
+
+void spsc_close(SpscRing *ring) {
+    __atomic_store_n(&ring->closed, 1, __ATOMIC_RELEASE);
+}
+
+void *spsc_try_pop_any(SpscRing **rings, int count, int *which) {
+    if (*which < 0 || *which >= count) *which = count - 1;
+    for (int k = 1; k <= count; ++k) {
+        int i = (*which + k) % count;
+        void *item = spsc_try_pop(rings[i]);
+        if (item) {
+            *which = i;
+            return item;
+        }
+    }
+    return NULL;
+}
+
+void *spsc_pop_any(SpscRing **rings, int count, int *which) {
+    if (*which < 0 || *which >= count) *which = count - 1;
+    for (unsigned spins = 0; ; ++spins) {
+        int open = 0;
+        for (int k = 1; k <= count; ++k) {
+            int i = (*which + k) % count;
+            void *item = spsc_try_pop(rings[i]);
+            if (item) {
+                *which = i;
+                return item;
+            }
+            if (!spsc_drained(rings[i])) open = 1;
+        }
+        if (!open) return NULL;
+        spsc_backoff(spins);
+    }
+}
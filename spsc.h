@@ -0,0 +1,69 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* spsc.h — 單生產者單消費者有界環形隊列
+ * 流水線各階段之間只傳遞緩衝區指針；環滿時生產者等待，形成反壓。
+ */
+#ifndef SPSC_H
+#define SPSC_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SPSC_CACHE_LINE 64
+
+typedef struct {
+    void **slots;
+    size_t mask;                                        // 容量 - 1，容量為 2 的冪
+    char pad0[SPSC_CACHE_LINE];
+    size_t head;                                        // 消費者位置
+    char pad1[SPSC_CACHE_LINE - sizeof(size_t)];
+    size_t tail;                                        // 生產者位置
+    int closed;                                         // 生產者已結束
+    char pad2[SPSC_CACHE_LINE];
+} SpscRing;
+
+// 容量向上取 2 的冪，成功返回 1
+int  spsc_init(SpscRing *ring, size_t capacity);
+void spsc_free(SpscRing *ring);
+
+// 非阻塞版本：環滿 / 空時返回 0 / NULL
+int   spsc_try_push(SpscRing *ring, void *item);
+void *spsc_try_pop(SpscRing *ring);
+
+// 阻塞版本：先自旋，再讓出 CPU，再短暫休眠
+void  spsc_push(SpscRing *ring, void *item);
+// 環已關閉且為空時返回 NULL
+void *spsc_pop(SpscRing *ring);
+// 生產者調用，之後不再 push
+void  spsc_close(SpscRing *ring);
+
+/* 從多個環中輪詢取出一項；所有環都已關閉且為空時返回 NULL。
+ * *which 傳入上次取到的下標（首次傳 -1），從下一個環開始輪詢，返回時為本次的下標。
+ * 調用者必須是這些環唯一的消費者。
+ */
+void *spsc_pop_any(SpscRing **rings, int count, int *which);
+// 非阻塞版本：所有環當前都為空時返回 NULL（不區分是否已關閉）
+void *spsc_try_pop_any(SpscRing **rings, int count, int *which);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPSC_H */
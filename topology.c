@@ -0,0 +1,299 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* topology.c
+ * https://github.com/8891689
+ * 不依賴 libnuma：節點與 CPU 從 sysfs 讀取，綁定內存直接用 mbind 系統調用。
+ */
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+#include "topology.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#define TOPO_MAX_CPUS 4096
+#define HUGE_2MB ((size_t)2 << 20)
+#define HUGE_1GB ((size_t)1 << 30)
+
+typedef struct {
+    int id;             // sysfs 中的節點號，可能不連續
+    int *cpus;
+    int cpu_count;
+} TopoNode;
+
+static TopoNode topo_nodes[TOPO_MAX_NODES];
+static int topo_nodes_count;
+static int *topo_cpus;                  // 進程可用的 CPU，升序
+static int topo_cpus_count;
+static short topo_cpu_node[TOPO_MAX_CPUS];   // CPU → 節點下標
+static pthread_once_t topo_once = PTHREAD_ONCE_INIT;
+
+#ifdef __linux__
+// 解析 "0-3,8,10-11" 形式的 CPU / 節點列表，只保留 allowed 中的項（allowed 為 NULL 時全收）
+static int parse_list(const char *path, int *out, int max, const cpu_set_t *allowed) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    char line[4096];
+    int count = 0;
+    if (fgets(line, sizeof(line), fp)) {
+        char *p = line;
+        while (*p && *p != '\n') {
+            char *end;
+            long lo = strtol(p, &end, 10), hi = lo;
+            if (end == p) break;
+            p = end;
+            if (*p == '-') { hi = strtol(p + 1, &end, 10); p = end; }
+            for (long v = lo; v <= hi && count < max; ++v) {
+                if (allowed && (v >= CPU_SETSIZE || !CPU_ISSET(v, allowed))) continue;
+                out[count++] = (int)v;
+            }
+            if (*p == ',') ++p;
+        }
+    }
+    fclose(fp);
+    return count;
+}
+#endif
+
+static void topo_load(void) {
+    topo_cpus = malloc(TOPO_MAX_CPUS * sizeof(int));
+    if (!topo_cpus) return;
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+    for (int c = 0; c < CPU_SETSIZE && topo_cpus_count < TOPO_MAX_CPUS; ++c)
+        if (CPU_ISSET(c, &allowed)) topo_cpus[topo_cpus_count++] = c;
+
+    int ids[TOPO_MAX_NODES];
+    int id_count = parse_list("/sys/devices/system/node/online", ids, TOPO_MAX_NODES, NULL);
+    for (int i = 0; i < id_count; ++i) {
+        char path[128];
+        TopoNode *node = &topo_nodes[topo_nodes_count];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", ids[i]);
+        node->cpus = malloc(TOPO_MAX_CPUS * sizeof(int));
+        if (!node->cpus) break;
+        node->cpu_count = parse_list(path, node->cpus, TOPO_MAX_CPUS, &allowed);
+        // 沒有可用 CPU 的節點（純內存節點或被 taskset 排除）不參與放置
+        if (node->cpu_count <= 0) { free(node->cpus); node->cpus = NULL; continue; }
+        node->id = ids[i];
+        for (int c = 0; c < node->cpu_count; ++c)
+            if (node->cpus[c] < TOPO_MAX_CPUS) topo_cpu_node[node->cpus[c]] = (short)topo_nodes_count;
+        topo_nodes_count++;
+    }
+#else
+    topo_cpus[topo_cpus_count++] = 0;
+#endif
+    // 讀不到 sysfs 時視為單節點
+    if (topo_nodes_count == 0) {
+        topo_nodes[0].id = -1;
+        topo_nodes[0].cpus = topo_cpus;
+        topo_nodes[0].cpu_count = topo_cpus_count;
+        topo_nodes_count = 1;
+    }
+}
+
+int topo_init(void) {
+    pthread_once(&topo_once, topo_load);
+    return topo_nodes_count;
+}
+
+int topo_node_count(void) {
+    return topo_init();
+}
+
+int topo_cpu_count(void) {
+    topo_init();
+    return topo_cpus_count;
+}
+
+int topo_place(TopoPinMode mode, int pair, int member, int *node) {
+    topo_init();
+    if (node) *node = 0;
+    if (mode == TOPO_PIN_NONE || topo_cpus_count == 0) return -1;
+    if (mode == TOPO_PIN_CORES) {
+        int cpu = topo_cpus[(pair * 2 + member) % topo_cpus_count];
+        if (node && cpu < TOPO_MAX_CPUS) *node = topo_cpu_node[cpu];
+        return cpu;
+    }
+    int n = pair % topo_nodes_count;
+    const TopoNode *tn = &topo_nodes[n];
+    if (node) *node = n;
+    return tn->cpus[((pair / topo_nodes_count) * 2 + member) % tn->cpu_count];
+}
+
+int topo_pin_self(int cpu) {
+#ifdef __linux__
+    if (cpu < 0) return 0;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return 0;
+#endif
+}
+
+int topo_current_node(void) {
+    topo_init();
+#ifdef __linux__
+    int cpu = sched_getcpu();
+    if (cpu >= 0 && cpu < TOPO_MAX_CPUS) return topo_cpu_node[cpu];
+#endif
+    return 0;
+}
+
+void topo_cpu_model(char *out, size_t len) {
+    if (len == 0) return;
+    snprintf(out, len, "unknown");
+#ifdef __linux__
+    FILE *fp = fopen("/proc/cpuinfo", "r");
+    if (fp) {
+        char line[512];
+        while (fgets(line, sizeof(line), fp)) {
+            // x86 為 "model name"，部分 ARM 內核只有 "Hardware"
+            if (strncmp(line, "model name", 10) != 0 && strncmp(line, "Hardware", 8) != 0) continue;
+            char *value = strchr(line, ':');
+            if (!value) continue;
+            value += 1 + strspn(value + 1, " \t");
+            value[strcspn(value, "\r\n")] = '\0';
+            snprintf(out, len, "%s", value);
+            fclose(fp);
+            return;
+        }
+        fclose(fp);
+    }
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int regs[12];
+    if (__get_cpuid_max(0x80000000, NULL) >= 0x80000004) {
+        for (unsigned int i = 0; i < 3; ++i)
+            __get_cpuid(0x80000002 + i, &regs[4 * i], &regs[4 * i + 1], &regs[4 * i + 2], &regs[4 * i + 3]);
+        char brand[49];
+        memcpy(brand, regs, 48);
+        brand[48] = '\0';
+        snprintf(out, len, "%s", brand + strspn(brand, " "));
+    }
+#endif
+}
+
+#ifdef __linux__
+static void *map_anonymous(size_t len, int flags) {
+    void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+static size_t round_up(size_t size, size_t unit) {
+    return (size + unit - 1) / unit * unit;
+}
+
+// MPOL_BIND 到單個節點；必須在第一次寫入前調用
+static void bind_to_node(void *p, size_t len, int node_id) {
+    unsigned long mask[(TOPO_MAX_NODES + 8 * sizeof(unsigned long) - 1) / (8 * sizeof(unsigned long))] = { 0 };
+    if (node_id < 0 || node_id >= TOPO_MAX_NODES) return;
+    mask[node_id / (8 * sizeof(unsigned long))] |= 1UL << (node_id % (8 * sizeof(unsigned long)));
+    syscall(SYS_mbind, p, len, 2 /* MPOL_BIND */, mask, (unsigned long)TOPO_MAX_NODES + 1, 0);
+}
+#endif
+
+int topo_huge_alloc(HugeRegion *r, size_t size, int node) {
+    memset(r, 0, sizeof(*r));
+    if (size == 0) size = 1;
+#ifdef __linux__
+#ifdef MAP_HUGE_1GB
+    if (size >= HUGE_1GB) {
+        r->len = round_up(size, HUGE_1GB);
+        r->ptr = map_anonymous(r->len, MAP_HUGETLB | MAP_HUGE_1GB);
+    }
+#endif
+    if (!r->ptr) {
+        r->len = round_up(size, HUGE_2MB);
+        r->ptr = map_anonymous(r->len, MAP_HUGETLB);
+    }
+    r->hugetlb = r->ptr != NULL;
+    if (!r->ptr) {
+        r->ptr = map_anonymous(r->len, 0);
+        if (!r->ptr) return 0;
+        madvise(r->ptr, r->len, MADV_HUGEPAGE);
+    }
+    topo_init();
+    if (node >= 0 && node < topo_nodes_count && topo_nodes[node].id >= 0)
+        bind_to_node(r->ptr, r->len, topo_nodes[node].id);
+    return 1;
+#else
+    (void)node;
+    r->len = size;
+    r->ptr = malloc(size);
+    return r->ptr != NULL;
+#endif
+}
+
+void topo_huge_free(HugeRegion *r) {
+    if (!r->ptr) return;
+#ifdef __linux__
+    munmap(r->ptr, r->len);
+#else
+    free(r->ptr);
+#endif
+    r->ptr = NULL;
+}
+
+int numa_table_init(NumaTable *t, size_t size, int replicate) {
+    memset(t, 0, sizeof(*t));
+    t->size = size;
+    int nodes = topo_init();
+    t->copy_count = replicate && nodes > 1 ? nodes : 1;
+    for (int i = 0; i < t->copy_count; ++i) {
+        if (!topo_huge_alloc(&t->copies[i], size, t->copy_count > 1 ? i : -1)) {
+            numa_table_free(t);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void *numa_table_primary(NumaTable *t) {
+    return t->copies[0].ptr;
+}
+
+void numa_table_commit(NumaTable *t) {
+    for (int i = 1; i < t->copy_count; ++i) memcpy(t->copies[i].ptr, t->copies[0].ptr, t->size);
+}
+
+const void *numa_table_local(const NumaTable *t) {
+    if (t->copy_count <= 1) return t->copies[0].ptr;
+    int node = topo_current_node();
+    return t->copies[node < t->copy_count ? node : 0].ptr;
+}
+
+void numa_table_free(NumaTable *t) {
+    for (int i = 0; i < TOPO_MAX_NODES; ++i) topo_huge_free(&t->copies[i]);
+    t->copy_count = 0;
+}
@@ -0,0 +1,87 @@
+/* Apache License, Version 2.0
+   Copyright [2025] [8891689]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+   Author: 8891689 (https://github.com/8891689)
+*/
+/* topology.h — CPU / NUMA 拓撲、執行緒綁核、大頁內存與按節點複製的只讀表
+ * 只在 Linux 上生效（讀 /sys/devices/system/node，mbind / MAP_HUGETLB）；
+ * 其他平台退化為單節點、不綁核、普通 malloc。
+ */
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TOPO_MAX_NODES 64
+
+typedef enum {
+    TOPO_PIN_NONE,      // 不綁核
+    TOPO_PIN_CORES,     // 按可用 CPU 順序逐個綁定
+    TOPO_PIN_NUMA       // 執行緒對輪流分到各 NUMA 節點，再在節點內綁定
+} TopoPinMode;
+
+// 讀取拓撲，重複調用無副作用；返回節點數
+int topo_init(void);
+int topo_node_count(void);
+int topo_cpu_count(void);
+
+/* 第 pair 對執行緒中的第 member 個（0 或 1）應綁定的 CPU，node 返回其節點。
+ * 同一對的兩個執行緒（如 EC 執行緒與消費它的哈希執行緒）總在同一節點的相鄰 CPU 上。
+ * TOPO_PIN_NONE 時返回 -1。
+ */
+int topo_place(TopoPinMode mode, int pair, int member, int *node);
+// 把調用執行緒綁到 cpu，成功返回 1
+int topo_pin_self(int cpu);
+// 調用執行緒當前所在的節點
+int topo_current_node(void);
+// CPU 型號字符串（Linux 讀 /proc/cpuinfo，x86 上退回 cpuid 品牌串），取不到時為 "unknown"
+void topo_cpu_model(char *out, size_t len);
+
+// 大頁內存區：>= 1GB 時先試 1GB 頁，再試 2MB 頁，都沒有預留時用普通頁並建議透明大頁
+typedef struct {
+    void *ptr;
+    size_t len;         // 映射長度，已按頁大小取整
+    int hugetlb;        // 1：顯式大頁
+} HugeRegion;
+
+// node >= 0 時把內存綁定到該節點；成功返回 1
+int  topo_huge_alloc(HugeRegion *r, size_t size, int node);
+void topo_huge_free(HugeRegion *r);
+
+// 大型只讀表（過濾器、預計算倍點）：每個節點一份副本，查表走本節點內存
+typedef struct {
+    HugeRegion copies[TOPO_MAX_NODES];
+    int copy_count;     // 1 表示未複製
+    size_t size;
+} NumaTable;
+
+// 分配 size 字節的表；replicate 非 0 且有多個節點時每個節點一份。內容由 numa_table_commit 寫入
+int  numa_table_init(NumaTable *t, size_t size, int replicate);
+// 第 0 份副本，供構建表時寫入
+void *numa_table_primary(NumaTable *t);
+// 把第 0 份的內容複製到其他節點的副本
+void numa_table_commit(NumaTable *t);
+// 調用執行緒所在節點的副本
+const void *numa_table_local(const NumaTable *t);
+void numa_table_free(NumaTable *t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOLOGY_H */